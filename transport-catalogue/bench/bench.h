@@ -0,0 +1,41 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <ostream>
+#include <vector>
+
+namespace bench {
+
+/*
+ * Бенчмарки горячих участков справочника. Данные генерируются в самом бенчмарке, время - минимум
+ * из нескольких запусков: на минимум меньше всего влияют помехи со стороны других процессов.
+ * Контрольная сумма результата выводится рядом со временем: у вариантов одного участка она совпадает
+ */
+template <typename Func>
+double MeasureMs(int repeat_count, Func func) {
+    double best = std::numeric_limits<double>::infinity();
+    for (int i = 0; i < repeat_count; ++i) {
+        const auto start = std::chrono::steady_clock::now();
+        func();
+        const std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - start;
+        best = std::min(best, duration.count());
+    }
+    return best;
+}
+
+// Вариант просмотра строк (string_scan.h), с которым собран бенчмарк: AVX2, SSE2 или scalar
+const char* GetStringScanMode();
+
+// Разбор строк json::Parser, запись json::Writer и svg::Text::SetData на кириллических названиях остановок
+void BenchStringScan(std::ostream& out);
+
+// Флойд-Уоршелл на таблицах vertex_counts вершин: скалярное ядро, SIMD-ядро и SIMD-ядро по строкам в пуле потоков
+void BenchFloydWarshall(std::ostream& out, const std::vector<size_t>& vertex_counts);
+
+// Разбор входа make_base: прежний рекурсивный загрузчик из std::istream, json::Load по буферу,
+// json::ForEachItem по base_requests и события json::Parser
+void BenchJsonParser(std::ostream& out);
+
+}  // namespace bench
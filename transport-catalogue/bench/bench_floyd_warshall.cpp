@@ -0,0 +1,129 @@
+#include "bench.h"
+
+#include "floyd_warshall.h"
+#include "routes_table.h"
+#include "thread_pool.h"
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace bench {
+
+namespace {
+
+using Table = graph::RoutesTable<double>;
+
+constexpr size_t EXTRA_EDGES_PER_VERTEX = 3;
+
+// Таблица до релаксации: кольцо по всем вершинам (граф связен) и случайные рёбра весом 1..100
+Table MakeInitialTable(size_t vertex_count) {
+    std::mt19937 generator(static_cast<std::mt19937::result_type>(vertex_count));
+    std::uniform_int_distribution<size_t> vertex_distribution(0, vertex_count - 1);
+    std::uniform_real_distribution<double> weight_distribution(1.0, 100.0);
+
+    Table table(vertex_count);
+    graph::TableEdgeId edge_id = 0;
+    auto add_edge = [&](size_t from, size_t to) {
+        const size_t cell = table.GetCell(from, to);
+        const double weight = weight_distribution(generator);
+        if (weight < table.weights[cell]) {
+            table.weights[cell] = weight;
+            table.prev_edges[cell] = edge_id;
+        }
+        ++edge_id;
+    };
+    for (size_t vertex = 0; vertex < vertex_count; ++vertex) {
+        table.weights[table.GetCell(vertex, vertex)] = 0.0;
+    }
+    for (size_t vertex = 0; vertex < vertex_count; ++vertex) {
+        add_edge(vertex, (vertex + 1) % vertex_count);
+        for (size_t i = 0; i < EXTRA_EDGES_PER_VERTEX; ++i) {
+            const size_t to = vertex_distribution(generator);
+            if (to != vertex) {
+                add_edge(vertex, to);
+            }
+        }
+    }
+    return table;
+}
+
+// Последовательный Флойд-Уоршелл на скалярном ядре; с -mavx2 его цикл векторизует компилятор
+void RelaxAllPairsScalar(Table& table) {
+    const size_t vertex_count = table.vertex_count;
+    double* weights = table.weights.data();
+    graph::TableEdgeId* prev_edges = table.prev_edges.data();
+    for (size_t vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
+        const double* row_k = weights + vertex_through * vertex_count;
+        const graph::TableEdgeId* prev_k = prev_edges + vertex_through * vertex_count;
+        for (size_t vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
+            double* row_i = weights + vertex_from * vertex_count;
+            const double weight_ik = row_i[vertex_through];
+            if (weight_ik == Table::UNREACHABLE) {
+                continue;
+            }
+            graph::floyd_warshall::RelaxRowScalar(row_k, prev_k, row_i, prev_edges + vertex_from * vertex_count,
+                                                  weight_ik, prev_edges[vertex_from * vertex_count + vertex_through],
+                                                  0, vertex_count);
+        }
+    }
+}
+
+// Хеш рёбер маршрутов: совпадает, только если варианты выбрали одни и те же маршруты
+std::uint64_t HashTable(const Table& table) {
+    std::uint64_t hash = 14695981039346656037ULL;
+    for (const graph::TableEdgeId prev_edge : table.prev_edges) {
+        hash = (hash ^ prev_edge) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+double SumWeights(const Table& table) {
+    double sum = 0.0;
+    for (const double weight : table.weights) {
+        if (weight != Table::UNREACHABLE) {
+            sum += weight;
+        }
+    }
+    return sum;
+}
+
+const char* GetFloydWarshallMode() {
+#if defined(GRAPH_FLOYD_WARSHALL_AVX2)
+    return "AVX2";
+#elif defined(GRAPH_FLOYD_WARSHALL_SSE2)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+
+}  // namespace
+
+void BenchFloydWarshall(std::ostream& out, const std::vector<size_t>& vertex_counts) {
+    concurrency::ThreadPool pool;
+    out << "floyd-warshall (" << GetFloydWarshallMode() << " kernel, " << pool.GetThreadCount() << " threads):\n";
+    for (const size_t vertex_count : vertex_counts) {
+        const Table initial_table = MakeInitialTable(vertex_count);
+        // каждый вариант работает над своей копией, копирование в замер не входит
+        auto run = [&](const char* name, auto relax_all_pairs) {
+            Table table = initial_table;
+            const double duration = MeasureMs(1, [&] {
+                relax_all_pairs(table);
+            });
+            out << "  V = " << vertex_count << ", " << name << duration << " ms, weights sum " << SumWeights(table)
+                << ", routes hash " << HashTable(table) << '\n';
+        };
+        run("scalar kernel:       ", [](Table& table) {
+            RelaxAllPairsScalar(table);
+        });
+        run("SIMD kernel:         ", [](Table& table) {
+            graph::floyd_warshall::RelaxAllPairs(table, nullptr);
+        });
+        run("row-parallel kernel: ", [&pool](Table& table) {
+            graph::floyd_warshall::RelaxAllPairs(table, &pool);
+        });
+    }
+}
+
+}  // namespace bench
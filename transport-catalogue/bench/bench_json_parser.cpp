@@ -0,0 +1,365 @@
+#include "bench.h"
+
+#include "json.h"
+#include "json_writer.h"
+
+#include <cctype>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+using namespace std::literals;
+
+namespace bench {
+
+namespace {
+
+/*
+ * Прежний json::Load: рекурсивный разбор std::istream по одному символу (operator>>, putback, peek)
+ * в дерево узлов на std::map и std::vector. Оставлен только как точка отсчёта для json::Parser
+ */
+namespace recursive_loader {
+
+class Node;
+using Dict = std::map<std::string, Node>;
+using Array = std::vector<Node>;
+
+class Node final : private std::variant<std::nullptr_t, Array, Dict, bool, int, double, std::string> {
+public:
+    using variant::variant;
+    using Value = variant;
+
+    const Value& GetValue() const {
+        return *this;
+    }
+};
+
+Node LoadNode(std::istream& input);
+
+std::string LoadLiteral(std::istream& input) {
+    std::string literal;
+    while (std::isalpha(input.peek())) {
+        literal.push_back(static_cast<char>(input.get()));
+    }
+    return literal;
+}
+
+std::string LoadString(std::istream& input) {
+    auto it = std::istreambuf_iterator<char>(input);
+    const auto end = std::istreambuf_iterator<char>();
+    std::string result;
+    while (true) {
+        if (it == end) {
+            throw json::ParsingError("String parsing error"s);
+        }
+        const char ch = *it;
+        if (ch == '"') {
+            ++it;
+            break;
+        }
+        if (ch == '\\') {
+            ++it;
+            if (it == end) {
+                throw json::ParsingError("String parsing error"s);
+            }
+            switch (const char escaped_char = *it; escaped_char) {
+                case 'n':
+                    result.push_back('\n');
+                    break;
+                case 't':
+                    result.push_back('\t');
+                    break;
+                case 'r':
+                    result.push_back('\r');
+                    break;
+                case '"':
+                case '\\':
+                    result.push_back(escaped_char);
+                    break;
+                default:
+                    throw json::ParsingError("Unrecognized escape sequence \\"s + escaped_char);
+            }
+        } else if (ch == '\n' || ch == '\r') {
+            throw json::ParsingError("Unexpected end of line"s);
+        } else {
+            result.push_back(ch);
+        }
+        ++it;
+    }
+    return result;
+}
+
+Node LoadArray(std::istream& input) {
+    Array result;
+    for (char c; input >> c && c != ']';) {
+        if (c != ',') {
+            input.putback(c);
+        }
+        result.push_back(LoadNode(input));
+    }
+    if (!input) {
+        throw json::ParsingError("Array parsing error"s);
+    }
+    return Node(std::move(result));
+}
+
+Node LoadDict(std::istream& input) {
+    Dict result;
+    for (char c; input >> c && c != '}';) {
+        if (c == '"') {
+            std::string key = LoadString(input);
+            if (!(input >> c) || c != ':') {
+                throw json::ParsingError(": is expected"s);
+            }
+            if (result.find(key) != result.end()) {
+                throw json::ParsingError("Duplicate key '"s + key + "' have been found"s);
+            }
+            result.emplace(std::move(key), LoadNode(input));
+        } else if (c != ',') {
+            throw json::ParsingError("',' is expected"s);
+        }
+    }
+    if (!input) {
+        throw json::ParsingError("Dictionary parsing error"s);
+    }
+    return Node(std::move(result));
+}
+
+Node LoadNumber(std::istream& input) {
+    std::string number;
+    auto read_char = [&number, &input] {
+        number += static_cast<char>(input.get());
+        if (!input) {
+            throw json::ParsingError("Failed to read number from stream"s);
+        }
+    };
+    auto read_digits = [&input, read_char] {
+        if (!std::isdigit(input.peek())) {
+            throw json::ParsingError("A digit is expected"s);
+        }
+        while (std::isdigit(input.peek())) {
+            read_char();
+        }
+    };
+
+    if (input.peek() == '-') {
+        read_char();
+    }
+    if (input.peek() == '0') {
+        read_char();
+    } else {
+        read_digits();
+    }
+    bool is_int = true;
+    if (input.peek() == '.') {
+        read_char();
+        read_digits();
+        is_int = false;
+    }
+    if (int ch = input.peek(); ch == 'e' || ch == 'E') {
+        read_char();
+        if (ch = input.peek(); ch == '+' || ch == '-') {
+            read_char();
+        }
+        read_digits();
+        is_int = false;
+    }
+    try {
+        if (is_int) {
+            try {
+                return std::stoi(number);
+            } catch (...) {
+                // не помещается в int - читается как double
+            }
+        }
+        return std::stod(number);
+    } catch (...) {
+        throw json::ParsingError("Failed to convert "s + number + " to number"s);
+    }
+}
+
+Node LoadNode(std::istream& input) {
+    char c;
+    if (!(input >> c)) {
+        throw json::ParsingError("Unexpected EOF"s);
+    }
+    switch (c) {
+        case '[':
+            return LoadArray(input);
+        case '{':
+            return LoadDict(input);
+        case '"':
+            return LoadString(input);
+        case 't':
+        case 'f': {
+            input.putback(c);
+            const std::string literal = LoadLiteral(input);
+            if (literal != "true"sv && literal != "false"sv) {
+                throw json::ParsingError("Failed to parse '"s + literal + "' as bool"s);
+            }
+            return Node(literal == "true"sv);
+        }
+        case 'n':
+            input.putback(c);
+            if (LoadLiteral(input) != "null"sv) {
+                throw json::ParsingError("Failed to parse null"s);
+            }
+            return Node(nullptr);
+        default:
+            input.putback(c);
+            return LoadNumber(input);
+    }
+}
+
+size_t CountNodes(const Node& node) {
+    size_t count = 1;
+    if (const auto* array = std::get_if<Array>(&node.GetValue())) {
+        for (const Node& item : *array) {
+            count += CountNodes(item);
+        }
+    } else if (const auto* dict = std::get_if<Dict>(&node.GetValue())) {
+        for (const auto& [key, value] : *dict) {
+            count += CountNodes(value);
+        }
+    }
+    return count;
+}
+
+}  // namespace recursive_loader
+
+constexpr size_t STOP_COUNT = 20'000;
+constexpr size_t BUS_COUNT = 2'000;
+constexpr size_t ROAD_DISTANCES_PER_STOP = 5;
+constexpr size_t STOPS_PER_BUS = 20;
+constexpr int REPEAT_COUNT = 3;
+
+std::string GetStopName(size_t index) {
+    return "Остановка "s + std::to_string(index);
+}
+
+// Вход make_base: настройки и base_requests с остановками, расстояниями и автобусами
+std::string MakeBaseRequests() {
+    std::string document;
+    json::Writer writer(document);
+    writer.StartDict();
+    writer.Key("serialization_settings").StartDict().Key("file").Value("transport_catalogue.db").EndDict();
+    writer.Key("routing_settings").StartDict().Key("bus_wait_time").Value(6).Key("bus_velocity").Value(40).EndDict();
+    writer.Key("render_settings").StartDict()
+            .Key("width").Value(1200.0).Key("height").Value(1200.0).Key("padding").Value(50.0)
+            .Key("line_width").Value(14.0).Key("stop_radius").Value(5.0)
+            .Key("underlayer_color").StartArray().Value(255).Value(255).Value(255).Value(0.85).EndArray()
+            .Key("color_palette").StartArray().Value("green").Value("red").Value("orange").EndArray()
+            .EndDict();
+
+    writer.Key("base_requests");
+    writer.StartArray();
+    for (size_t i = 0; i < STOP_COUNT; ++i) {
+        writer.StartDict();
+        writer.Key("type").Value("Stop");
+        writer.Key("name").Value(std::string_view(GetStopName(i)));
+        writer.Key("latitude").Value(55.5 + static_cast<double>(i % 1000) * 0.0007);
+        writer.Key("longitude").Value(37.3 + static_cast<double>(i / 1000) * 0.0213);
+        writer.Key("road_distances");
+        writer.StartDict();
+        for (size_t j = 1; j <= ROAD_DISTANCES_PER_STOP; ++j) {
+            writer.Key(GetStopName((i + j * 7) % STOP_COUNT)).Value(static_cast<int>(500 + (i * j) % 3000));
+        }
+        writer.EndDict();
+        writer.EndDict();
+    }
+    for (size_t i = 0; i < BUS_COUNT; ++i) {
+        writer.StartDict();
+        writer.Key("type").Value("Bus");
+        writer.Key("name").Value(std::string_view("Автобус "s + std::to_string(i)));
+        writer.Key("stops");
+        writer.StartArray();
+        for (size_t j = 0; j < STOPS_PER_BUS; ++j) {
+            writer.Value(std::string_view(GetStopName((i * 13 + j * 101) % STOP_COUNT)));
+        }
+        writer.EndArray();
+        writer.Key("is_roundtrip").Value(i % 2 == 0);
+        writer.EndDict();
+    }
+    writer.EndArray();
+    writer.EndDict();
+    return document;
+}
+
+size_t CountNodes(const json::Node& node) {
+    size_t count = 1;
+    if (node.IsArray()) {
+        for (const json::Node& item : node.AsArray()) {
+            count += CountNodes(item);
+        }
+    } else if (node.IsDict()) {
+        for (const auto& [key, value] : node.AsDict()) {
+            count += CountNodes(value);
+        }
+    }
+    return count;
+}
+
+}  // namespace
+
+void BenchJsonParser(std::ostream& out) {
+    const std::string document = MakeBaseRequests();
+    const double megabytes = static_cast<double>(document.size()) / 1e6;
+
+    size_t recursive_nodes = 0;
+    const double recursive_ms = MeasureMs(REPEAT_COUNT, [&] {
+        std::istringstream input(document);
+        recursive_nodes = recursive_loader::CountNodes(recursive_loader::LoadNode(input));
+    });
+    size_t tree_nodes = 0;
+    const double tree_ms = MeasureMs(REPEAT_COUNT, [&] {
+        const json::Document parsed = json::Load(std::string_view(document));
+        tree_nodes = CountNodes(parsed.GetRoot());
+    });
+    // как в JsonReader: base_requests по одному запросу в арене, остальные разделы деревом
+    size_t reader_nodes = 0;
+    const double reader_ms = MeasureMs(REPEAT_COUNT, [&] {
+        reader_nodes = 1;
+        json::Parser parser(document);
+        parser.Next();
+        for (json::Event event = parser.Next(); event != json::Event::END_DICT; event = parser.Next()) {
+            const bool is_base_requests = parser.GetString() == "base_requests"sv;
+            const json::Event value = parser.Next();
+            if (is_base_requests) {
+                ++reader_nodes;
+                json::ForEachItem(parser, value, [&reader_nodes](const json::Node& request) {
+                    reader_nodes += CountNodes(request);
+                });
+            } else {
+                reader_nodes += CountNodes(json::LoadNode(parser, value));
+            }
+        }
+        parser.Next();
+    });
+    // без дерева: так JsonReader проходит разделы, которые режиму не нужны
+    size_t event_nodes = 0;
+    const double events_ms = MeasureMs(REPEAT_COUNT, [&] {
+        event_nodes = 0;
+        json::Parser parser(document);
+        for (json::Event event = parser.Next(); event != json::Event::END_DOCUMENT; event = parser.Next()) {
+            if (event != json::Event::KEY && event != json::Event::END_ARRAY && event != json::Event::END_DICT) {
+                ++event_nodes;
+            }
+        }
+    });
+
+    auto report = [&](const char* name, double duration, size_t node_count) {
+        out << "  " << name << duration << " ms, " << megabytes / duration * 1e3 << " MB/s, x"
+            << recursive_ms / duration << ", " << node_count << " nodes\n";
+    };
+    out << "json parser, make_base input of " << megabytes << " MB:\n";
+    report("recursive istream loader: ", recursive_ms, recursive_nodes);
+    report("json::Load (buffer):      ", tree_ms, tree_nodes);
+    report("json::ForEachItem:        ", reader_ms, reader_nodes);
+    report("json::Parser events:      ", events_ms, event_nodes);
+}
+
+}  // namespace bench
@@ -0,0 +1,48 @@
+#include "bench.h"
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std::literals;
+
+void PrintUsage(std::ostream& stream = std::cerr) {
+    stream << "Usage: transport_catalogue_bench [string_scan | json_parser]\n"sv
+           << "       transport_catalogue_bench floyd_warshall [vertex_count...]\n"sv;
+}
+
+int main(int argc, char* argv[]) {
+    // без аргументов выполняются все бенчмарки
+    const std::string_view name = argc > 1 ? std::string_view(argv[1]) : std::string_view();
+    std::vector<size_t> vertex_counts;
+    for (int i = 2; i < argc; ++i) {
+        size_t vertex_count = 0;
+        try {
+            vertex_count = std::stoul(argv[i]);
+        } catch (const std::exception&) {
+        }
+        if (name != "floyd_warshall"sv || vertex_count == 0) {
+            PrintUsage();
+            return 1;
+        }
+        vertex_counts.push_back(vertex_count);
+    }
+    if (!name.empty() && name != "string_scan"sv && name != "floyd_warshall"sv && name != "json_parser"sv) {
+        PrintUsage();
+        return 1;
+    }
+    if (vertex_counts.empty()) {
+        vertex_counts = {1000, 2000, 4000};
+    }
+
+    if (name.empty() || name == "string_scan"sv) {
+        bench::BenchStringScan(std::cout);
+    }
+    if (name.empty() || name == "json_parser"sv) {
+        bench::BenchJsonParser(std::cout);
+    }
+    if (name.empty() || name == "floyd_warshall"sv) {
+        bench::BenchFloydWarshall(std::cout, vertex_counts);
+    }
+}
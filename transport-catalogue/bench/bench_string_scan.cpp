@@ -0,0 +1,94 @@
+#include "bench.h"
+
+#include "json.h"
+#include "json_writer.h"
+#include "string_scan.h"
+#include "svg.h"
+
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std::literals;
+
+namespace bench {
+
+namespace {
+
+constexpr size_t NAME_COUNT = 200'000;
+constexpr int REPEAT_COUNT = 10;
+
+// Названия остановок на кириллице; у каждого восьмого - символы, которые экранируются в JSON и в XML
+std::vector<std::string> MakeStopNames() {
+    std::vector<std::string> names;
+    names.reserve(NAME_COUNT);
+    for (size_t i = 0; i < NAME_COUNT; ++i) {
+        std::string name = "Остановка Проспект Мира "s + std::to_string(i);
+        if (i % 8 == 0) {
+            name += " & <Кольцевая> \"Северная\" 'А'"s;
+        }
+        names.push_back(std::move(name));
+    }
+    return names;
+}
+
+}  // namespace
+
+const char* GetStringScanMode() {
+#if defined(STRING_SCAN_AVX2)
+    return "AVX2";
+#elif defined(STRING_SCAN_SSE2)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+
+void BenchStringScan(std::ostream& out) {
+    const std::vector<std::string> names = MakeStopNames();
+
+    // массив названий, записанный json::Writer, - он же вход разбора
+    std::string document;
+    const double write_ms = MeasureMs(REPEAT_COUNT, [&] {
+        document.clear();
+        json::Writer writer(document);
+        writer.StartArray();
+        for (const std::string& name : names) {
+            writer.Value(std::string_view(name));
+        }
+        writer.EndArray();
+    });
+
+    size_t parsed_size = 0;
+    const double parse_ms = MeasureMs(REPEAT_COUNT, [&] {
+        parsed_size = 0;
+        json::Parser parser(document);
+        parser.Next();
+        for (json::Event event = parser.Next(); event != json::Event::END_ARRAY; event = parser.Next()) {
+            parsed_size += parser.GetString().size();
+        }
+        parser.Next();
+    });
+
+    const double svg_ms = MeasureMs(REPEAT_COUNT, [&] {
+        for (const std::string& name : names) {
+            svg::Text text;
+            text.SetData(name);
+        }
+    });
+    // экранированный текст для контрольной суммы выводится вне замера
+    svg::Document svg_document;
+    for (const std::string& name : names) {
+        svg_document.Add(svg::Text().SetData(name));
+    }
+    std::ostringstream svg_output;
+    svg_document.Render(svg_output);
+
+    out << "string scan (" << GetStringScanMode() << "), " << NAME_COUNT << " stop names:\n"
+        << "  json::Writer strings:   " << write_ms << " ms, " << document.size() << " bytes\n"
+        << "  json::Parser strings:   " << parse_ms << " ms, " << parsed_size << " bytes\n"
+        << "  svg::Text::SetData:     " << svg_ms << " ms, " << svg_output.str().size() << " bytes of svg\n";
+}
+
+}  // namespace bench
@@ -0,0 +1,497 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+/*
+ * Иерархия сжатия (Contraction Hierarchies) над DirectedWeightedGraph.
+ * Вершины сжимаются по возрастанию "важности"; при сжатии вершины v для каждой пары u -> v -> w,
+ * у которой нет более короткого обхода, добавляется ребро-шорткат u -> w. Шорткат помнит два ребра,
+ * из которых он составлен, поэтому любой маршрут раскрывается обратно в рёбра исходного графа
+ */
+template <typename Weight>
+class ContractionHierarchy {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using Rank = std::uint32_t;
+    using HierarchyEdgeId = std::uint32_t;
+    static constexpr HierarchyEdgeId NO_HIERARCHY_EDGE = std::numeric_limits<HierarchyEdgeId>::max();
+
+    struct HierarchyEdge {
+        VertexId from;
+        VertexId to;
+        Weight weight;
+        // для исходного ребра: first - его EdgeId в графе, second == NO_HIERARCHY_EDGE;
+        // для шортката: first и second - рёбра иерархии, из которых он составлен
+        HierarchyEdgeId first;
+        HierarchyEdgeId second = NO_HIERARCHY_EDGE;
+
+        bool IsShortcut() const {
+            return second != NO_HIERARCHY_EDGE;
+        }
+    };
+
+    explicit ContractionHierarchy(const Graph& graph);
+    ContractionHierarchy(std::vector<Rank> ranks, std::vector<HierarchyEdge> edges);
+
+    size_t GetVertexCount() const;
+    const std::vector<Rank>& GetRanks() const;
+    const std::vector<HierarchyEdge>& GetEdges() const;
+
+    // Рёбра, ведущие из вершины в более важные вершины
+    const std::vector<HierarchyEdgeId>& GetUpwardEdges(VertexId vertex) const;
+    // Рёбра, ведущие в вершину из более важных вершин
+    const std::vector<HierarchyEdgeId>& GetDownwardEdges(VertexId vertex) const;
+
+    // Раскрывает ребро иерархии в последовательность рёбер исходного графа
+    void Unpack(HierarchyEdgeId edge_id, std::vector<EdgeId>& edges) const;
+
+private:
+    struct ContractionState;
+
+    // максимальное число вершин, которое просматривает поиск обхода (witness search) при сжатии вершины
+    static constexpr size_t WITNESS_SETTLE_LIMIT = 500;
+    // то же при оценке приоритета: оценка пересчитывается часто, а точность ей нужна меньше
+    static constexpr size_t PRIORITY_SETTLE_LIMIT = 50;
+    static constexpr Weight ZERO_WEIGHT{};
+
+    std::vector<Rank> ranks_;
+    std::vector<HierarchyEdge> edges_;
+    std::vector<std::vector<HierarchyEdgeId>> upward_edges_;
+    std::vector<std::vector<HierarchyEdgeId>> downward_edges_;
+
+    void Contract(const Graph& graph);
+    void BuildSearchGraphs();
+};
+
+template <typename Weight>
+struct ContractionHierarchy<Weight>::ContractionState {
+    using Shortcut = std::tuple<HierarchyEdgeId, HierarchyEdgeId, Weight>; // u -> v, v -> w, вес
+    using QueueItem = std::pair<Weight, VertexId>;
+
+    ContractionState(std::vector<HierarchyEdge>& edges, size_t vertex_count)
+        : edges(edges)
+        , out_edges(vertex_count)
+        , in_edges(vertex_count)
+        , contracted(vertex_count, false)
+        , contracted_neighbours(vertex_count, 0)
+        , witness_distances(vertex_count, std::numeric_limits<Weight>::max())
+        , is_target(vertex_count, false) {
+    }
+
+    HierarchyEdgeId AddEdge(HierarchyEdge edge) {
+        const auto id = static_cast<HierarchyEdgeId>(edges.size());
+        // исходящие рёбра упорядочены по весу: поиск обходов прекращает просмотр на первом слишком тяжёлом
+        auto& vertex_out_edges = out_edges[edge.from];
+        const auto position = std::upper_bound(vertex_out_edges.begin(), vertex_out_edges.end(), edge.weight,
+                                               [this](Weight weight, HierarchyEdgeId other) { return weight < edges[other].weight; });
+        vertex_out_edges.insert(position, id);
+        in_edges[edge.to].push_back(id);
+        edges.push_back(std::move(edge));
+        return id;
+    }
+
+    // Расстояния от source в ещё не сжатой части графа без вершины skipped, не превышающие limit.
+    // Поиск останавливается, когда найдены расстояния до всех target_count отмеченных в is_target вершин.
+    // Поиск ограничен settle_limit вершинами: недосчитанное расстояние приводит
+    // лишь к лишнему шорткату
+    void RunWitnessSearch(VertexId source, VertexId skipped, Weight limit, size_t target_count, size_t settle_limit) {
+        for (const VertexId vertex : touched) {
+            witness_distances[vertex] = std::numeric_limits<Weight>::max();
+        }
+        touched.clear();
+
+        // куча переиспользуется между поисками, чтобы не выделять память заново
+        auto push = [this](Weight distance, VertexId vertex) {
+            queue.emplace_back(distance, vertex);
+            std::push_heap(queue.begin(), queue.end(), std::greater<QueueItem>{});
+        };
+        queue.clear();
+        witness_distances[source] = ZERO_WEIGHT;
+        touched.push_back(source);
+        push(ZERO_WEIGHT, source);
+        size_t settled = 0;
+        while (!queue.empty() && settled < settle_limit) {
+            std::pop_heap(queue.begin(), queue.end(), std::greater<QueueItem>{});
+            const auto [distance, vertex] = queue.back();
+            queue.pop_back();
+            if (distance > witness_distances[vertex]) {
+                continue;
+            }
+            if (distance > limit) {
+                break;
+            }
+            if (is_target[vertex] && --target_count == 0) {
+                break;
+            }
+            ++settled;
+            for (const HierarchyEdgeId edge_id : out_edges[vertex]) {
+                const auto& edge = edges[edge_id];
+                if (edge.to == skipped) {
+                    continue;
+                }
+                const Weight candidate = distance + edge.weight;
+                if (candidate > limit) {
+                    break;
+                }
+                if (candidate < witness_distances[edge.to]) {
+                    if (witness_distances[edge.to] == std::numeric_limits<Weight>::max()) {
+                        touched.push_back(edge.to);
+                    }
+                    witness_distances[edge.to] = candidate;
+                    push(candidate, edge.to);
+                }
+            }
+        }
+    }
+
+    // Шорткаты, которые нужны при сжатии вершины
+    std::vector<Shortcut> FindShortcuts(VertexId vertex, size_t settle_limit) {
+        std::vector<Shortcut> shortcuts;
+        for (const HierarchyEdgeId in_id : in_edges[vertex]) {
+            const auto& in_edge = edges[in_id];
+            if (in_edge.from == vertex) {
+                continue;
+            }
+            Weight limit = ZERO_WEIGHT;
+            size_t target_count = 0;
+            for (const HierarchyEdgeId out_id : out_edges[vertex]) {
+                const auto& out_edge = edges[out_id];
+                if (out_edge.to != in_edge.from && !is_target[out_edge.to]) {
+                    is_target[out_edge.to] = true;
+                    ++target_count;
+                }
+                limit = std::max(limit, in_edge.weight + out_edge.weight);
+            }
+            if (target_count == 0) {
+                continue;
+            }
+            RunWitnessSearch(in_edge.from, vertex, limit, target_count, settle_limit);
+            for (const HierarchyEdgeId out_id : out_edges[vertex]) {
+                is_target[edges[out_id].to] = false;
+            }
+            for (const HierarchyEdgeId out_id : out_edges[vertex]) {
+                const auto& out_edge = edges[out_id];
+                if (out_edge.to == in_edge.from || out_edge.to == vertex) {
+                    continue;
+                }
+                const Weight via_vertex = in_edge.weight + out_edge.weight;
+                if (witness_distances[out_edge.to] > via_vertex) {
+                    shortcuts.emplace_back(in_id, out_id, via_vertex);
+                }
+            }
+        }
+        return shortcuts;
+    }
+
+    // Разность рёбер: сколько шорткатов добавится минус сколько рёбер исчезнет,
+    // плюс число уже сжатых соседей для равномерного сжатия графа
+    long long GetPriority(VertexId vertex) {
+        const auto removed_edges = static_cast<long long>(in_edges[vertex].size() + out_edges[vertex].size());
+        const auto added_edges = static_cast<long long>(FindShortcuts(vertex, PRIORITY_SETTLE_LIMIT).size());
+        return added_edges - removed_edges + contracted_neighbours[vertex];
+    }
+
+    void ContractVertex(VertexId vertex) {
+        for (const auto& [in_id, out_id, weight] : FindShortcuts(vertex, WITNESS_SETTLE_LIMIT)) {
+            AddEdge({edges[in_id].from, edges[out_id].to, weight, in_id, out_id});
+        }
+        contracted[vertex] = true;
+        // рёбра сжатой вершины убираются из списков соседей, чтобы поиск обходов их не просматривал
+        for (const HierarchyEdgeId id : in_edges[vertex]) {
+            ++contracted_neighbours[edges[id].from];
+            Erase(out_edges[edges[id].from], vertex, &HierarchyEdge::to);
+        }
+        for (const HierarchyEdgeId id : out_edges[vertex]) {
+            ++contracted_neighbours[edges[id].to];
+            Erase(in_edges[edges[id].to], vertex, &HierarchyEdge::from);
+        }
+        in_edges[vertex].clear();
+        out_edges[vertex].clear();
+    }
+
+    void Erase(std::vector<HierarchyEdgeId>& edge_ids, VertexId vertex, VertexId HierarchyEdge::*end) {
+        edge_ids.erase(std::remove_if(edge_ids.begin(), edge_ids.end(),
+                                      [&](HierarchyEdgeId id) { return edges[id].*end == vertex; }),
+                       edge_ids.end());
+    }
+
+    std::vector<HierarchyEdge>& edges;
+    std::vector<std::vector<HierarchyEdgeId>> out_edges;
+    std::vector<std::vector<HierarchyEdgeId>> in_edges;
+    std::vector<bool> contracted;
+    std::vector<long long> contracted_neighbours;
+
+    std::vector<Weight> witness_distances;
+    std::vector<VertexId> touched;
+    std::vector<bool> is_target;
+    std::vector<QueueItem> queue;
+};
+
+template <typename Weight>
+ContractionHierarchy<Weight>::ContractionHierarchy(const Graph& graph)
+    : ranks_(graph.GetVertexCount()) {
+    if (graph.GetEdgeCount() >= NO_HIERARCHY_EDGE) {
+        throw std::length_error("Too many edges for the contraction hierarchy");
+    }
+    Contract(graph);
+    BuildSearchGraphs();
+}
+
+template <typename Weight>
+ContractionHierarchy<Weight>::ContractionHierarchy(std::vector<Rank> ranks, std::vector<HierarchyEdge> edges)
+    : ranks_(std::move(ranks))
+    , edges_(std::move(edges)) {
+    BuildSearchGraphs();
+}
+
+template <typename Weight>
+void ContractionHierarchy<Weight>::Contract(const Graph& graph) {
+    const size_t vertex_count = graph.GetVertexCount();
+    ContractionState state(edges_, vertex_count);
+
+    // из параллельных рёбер в иерархию попадает самое лёгкое (при равенстве - первое)
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        std::unordered_map<VertexId, EdgeId> best_edges;
+        for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+            const auto& edge = graph.GetEdge(edge_id);
+            if (edge.weight < ZERO_WEIGHT) {
+                throw std::domain_error("Edges' weights should be non-negative");
+            }
+            if (edge.to == vertex) {
+                continue;
+            }
+            auto [it, inserted] = best_edges.emplace(edge.to, edge_id);
+            if (!inserted && edge.weight < graph.GetEdge(it->second).weight) {
+                it->second = edge_id;
+            }
+        }
+        std::vector<std::pair<VertexId, EdgeId>> sorted_edges(best_edges.begin(), best_edges.end());
+        std::sort(sorted_edges.begin(), sorted_edges.end());
+        for (const auto& [to, edge_id] : sorted_edges) {
+            state.AddEdge({vertex, to, graph.GetEdge(edge_id).weight, static_cast<HierarchyEdgeId>(edge_id)});
+        }
+    }
+
+    using QueueItem = std::pair<long long, VertexId>;
+    std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        queue.push({state.GetPriority(vertex), vertex});
+    }
+
+    // ленивое обновление: приоритет вершины пересчитывается при извлечении
+    Rank next_rank = 0;
+    while (!queue.empty()) {
+        const VertexId vertex = queue.top().second;
+        queue.pop();
+        if (state.contracted[vertex]) {
+            continue;
+        }
+        const long long priority = state.GetPriority(vertex);
+        if (!queue.empty() && priority > queue.top().first) {
+            queue.push({priority, vertex});
+            continue;
+        }
+        state.ContractVertex(vertex);
+        ranks_[vertex] = next_rank++;
+    }
+}
+
+template <typename Weight>
+void ContractionHierarchy<Weight>::BuildSearchGraphs() {
+    upward_edges_.assign(ranks_.size(), {});
+    downward_edges_.assign(ranks_.size(), {});
+    for (HierarchyEdgeId edge_id = 0; edge_id < edges_.size(); ++edge_id) {
+        const auto& edge = edges_[edge_id];
+        if (ranks_.at(edge.from) < ranks_.at(edge.to)) {
+            upward_edges_[edge.from].push_back(edge_id);
+        } else {
+            downward_edges_[edge.to].push_back(edge_id);
+        }
+    }
+}
+
+template <typename Weight>
+size_t ContractionHierarchy<Weight>::GetVertexCount() const {
+    return ranks_.size();
+}
+
+template <typename Weight>
+const std::vector<typename ContractionHierarchy<Weight>::Rank>& ContractionHierarchy<Weight>::GetRanks() const {
+    return ranks_;
+}
+
+template <typename Weight>
+const std::vector<typename ContractionHierarchy<Weight>::HierarchyEdge>& ContractionHierarchy<Weight>::GetEdges() const {
+    return edges_;
+}
+
+template <typename Weight>
+const std::vector<typename ContractionHierarchy<Weight>::HierarchyEdgeId>&
+ContractionHierarchy<Weight>::GetUpwardEdges(VertexId vertex) const {
+    return upward_edges_.at(vertex);
+}
+
+template <typename Weight>
+const std::vector<typename ContractionHierarchy<Weight>::HierarchyEdgeId>&
+ContractionHierarchy<Weight>::GetDownwardEdges(VertexId vertex) const {
+    return downward_edges_.at(vertex);
+}
+
+template <typename Weight>
+void ContractionHierarchy<Weight>::Unpack(HierarchyEdgeId edge_id, std::vector<EdgeId>& edges) const {
+    std::vector<HierarchyEdgeId> stack{edge_id};
+    while (!stack.empty()) {
+        const auto& edge = edges_.at(stack.back());
+        stack.pop_back();
+        if (edge.IsShortcut()) {
+            stack.push_back(edge.second);
+            stack.push_back(edge.first);
+        } else {
+            edges.push_back(edge.first);
+        }
+    }
+}
+
+/*
+ * Движок маршрутизации по иерархии сжатия: двунаправленный Дейкстра, в котором прямой поиск
+ * идёт только вверх по иерархии от вершины отправления, а обратный - вверх от вершины прибытия
+ */
+template <typename Weight>
+class ContractionHierarchyRouter final : public RouteBuilder<Weight> {
+private:
+    using Hierarchy = ContractionHierarchy<Weight>;
+    using HierarchyEdgeId = typename Hierarchy::HierarchyEdgeId;
+
+public:
+    using typename RouteBuilder<Weight>::RouteInfo;
+
+    explicit ContractionHierarchyRouter(const Hierarchy& hierarchy);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+
+private:
+    struct SearchLabel {
+        Weight weight;
+        HierarchyEdgeId prev_edge;
+    };
+    using SearchLabels = std::unordered_map<VertexId, SearchLabel>;
+
+    static constexpr Weight ZERO_WEIGHT{};
+    const Hierarchy& hierarchy_;
+};
+
+template <typename Weight>
+ContractionHierarchyRouter<Weight>::ContractionHierarchyRouter(const Hierarchy& hierarchy)
+    : hierarchy_(hierarchy) {
+}
+
+template <typename Weight>
+std::optional<typename ContractionHierarchyRouter<Weight>::RouteInfo>
+ContractionHierarchyRouter<Weight>::BuildRoute(VertexId from, VertexId to) const {
+    using QueueItem = std::pair<Weight, VertexId>;
+    using Queue = std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>>;
+
+    if (from >= hierarchy_.GetVertexCount() || to >= hierarchy_.GetVertexCount()) {
+        throw std::out_of_range("Vertex is out of the contraction hierarchy");
+    }
+
+    SearchLabels forward{{from, {ZERO_WEIGHT, Hierarchy::NO_HIERARCHY_EDGE}}};
+    SearchLabels backward{{to, {ZERO_WEIGHT, Hierarchy::NO_HIERARCHY_EDGE}}};
+    Queue forward_queue;
+    Queue backward_queue;
+    forward_queue.push({ZERO_WEIGHT, from});
+    backward_queue.push({ZERO_WEIGHT, to});
+
+    std::optional<Weight> best_weight;
+    VertexId meeting_vertex = from;
+
+    auto update_best = [&](VertexId vertex) {
+        const auto forward_it = forward.find(vertex);
+        const auto backward_it = backward.find(vertex);
+        if (forward_it == forward.end() || backward_it == backward.end()) {
+            return;
+        }
+        const Weight candidate = forward_it->second.weight + backward_it->second.weight;
+        if (!best_weight || candidate < *best_weight) {
+            best_weight = candidate;
+            meeting_vertex = vertex;
+        }
+    };
+
+    // шаг поиска: извлекает вершину из очереди и релаксирует рёбра, ведущие вверх по иерархии
+    auto step = [&](Queue& queue, SearchLabels& labels, bool is_forward) {
+        const auto [weight, vertex] = queue.top();
+        queue.pop();
+        if (weight > labels.at(vertex).weight) {
+            return;
+        }
+        update_best(vertex);
+        const auto& edge_ids = is_forward ? hierarchy_.GetUpwardEdges(vertex) : hierarchy_.GetDownwardEdges(vertex);
+        for (const HierarchyEdgeId edge_id : edge_ids) {
+            const auto& edge = hierarchy_.GetEdges()[edge_id];
+            const VertexId next = is_forward ? edge.to : edge.from;
+            const Weight candidate = weight + edge.weight;
+            auto [it, inserted] = labels.try_emplace(next, SearchLabel{candidate, edge_id});
+            if (inserted || candidate < it->second.weight) {
+                it->second = {candidate, edge_id};
+                queue.push({candidate, next});
+            }
+        }
+    };
+
+    while (!forward_queue.empty() || !backward_queue.empty()) {
+        const bool forward_done = forward_queue.empty() || (best_weight && forward_queue.top().first >= *best_weight);
+        const bool backward_done = backward_queue.empty() || (best_weight && backward_queue.top().first >= *best_weight);
+        if (forward_done && backward_done) {
+            break;
+        }
+        if (!forward_done && (backward_done || forward_queue.top().first <= backward_queue.top().first)) {
+            step(forward_queue, forward, true);
+        } else {
+            step(backward_queue, backward, false);
+        }
+    }
+
+    if (!best_weight) {
+        return std::nullopt;
+    }
+
+    std::vector<HierarchyEdgeId> forward_path;
+    for (VertexId vertex = meeting_vertex; forward.at(vertex).prev_edge != Hierarchy::NO_HIERARCHY_EDGE;) {
+        const HierarchyEdgeId edge_id = forward.at(vertex).prev_edge;
+        forward_path.push_back(edge_id);
+        vertex = hierarchy_.GetEdges()[edge_id].from;
+    }
+    std::reverse(forward_path.begin(), forward_path.end());
+
+    std::vector<EdgeId> edges;
+    for (const HierarchyEdgeId edge_id : forward_path) {
+        hierarchy_.Unpack(edge_id, edges);
+    }
+    for (VertexId vertex = meeting_vertex; backward.at(vertex).prev_edge != Hierarchy::NO_HIERARCHY_EDGE;) {
+        const HierarchyEdgeId edge_id = backward.at(vertex).prev_edge;
+        hierarchy_.Unpack(edge_id, edges);
+        vertex = hierarchy_.GetEdges()[edge_id].to;
+    }
+
+    return RouteInfo{*best_weight, std::move(edges)};
+}
+
+}  // namespace graph
@@ -0,0 +1,147 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+
+#include <algorithm>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+/*
+ * Движок маршрутизации без предпосчёта: на каждый запрос запускает алгоритм Дейкстры
+ * из вершины отправления. Деревья кратчайших путей хранятся в LRU-кэше ограниченного размера,
+ * поэтому повторные запросы из той же вершины обходятся без повторного поиска
+ */
+template <typename Weight>
+class DijkstraRouter final : public RouteBuilder<Weight> {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using typename RouteBuilder<Weight>::RouteInfo;
+
+    DijkstraRouter(const Graph& graph, size_t cache_size);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+
+private:
+    struct RouteInternalData {
+        Weight weight;
+        std::optional<EdgeId> prev_edge;
+    };
+    using ShortestPathTree = std::vector<std::optional<RouteInternalData>>;
+    using CacheOrder = std::list<VertexId>;
+
+    struct CacheEntry {
+        ShortestPathTree tree;
+        typename CacheOrder::iterator order_pos;
+    };
+
+    ShortestPathTree BuildShortestPathTree(VertexId from) const;
+    const ShortestPathTree& GetShortestPathTree(VertexId from) const;
+
+    static constexpr Weight ZERO_WEIGHT{};
+    const Graph& graph_;
+    size_t cache_size_;
+
+    mutable std::mutex cache_mutex_;
+    mutable CacheOrder cache_order_; // от недавно использованных к давно использованным
+    mutable std::unordered_map<VertexId, CacheEntry> cache_;
+};
+
+template <typename Weight>
+DijkstraRouter<Weight>::DijkstraRouter(const Graph& graph, size_t cache_size)
+    : graph_(graph)
+    , cache_size_(std::max<size_t>(cache_size, 1)) {
+}
+
+template <typename Weight>
+typename DijkstraRouter<Weight>::ShortestPathTree DijkstraRouter<Weight>::BuildShortestPathTree(VertexId from) const {
+    using QueueItem = std::pair<Weight, VertexId>;
+
+    ShortestPathTree tree(graph_.GetVertexCount());
+    std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+
+    tree.at(from) = RouteInternalData{ZERO_WEIGHT, std::nullopt};
+    queue.push({ZERO_WEIGHT, from});
+
+    while (!queue.empty()) {
+        const auto [weight, vertex] = queue.top();
+        queue.pop();
+        if (weight > tree[vertex]->weight) { // устаревшая запись в очереди
+            continue;
+        }
+        for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+            const auto& edge = graph_.GetEdge(edge_id);
+            if (edge.weight < ZERO_WEIGHT) {
+                throw std::domain_error("Edges' weights should be non-negative");
+            }
+            const Weight candidate_weight = weight + edge.weight;
+            auto& route_relaxing = tree[edge.to];
+            if (!route_relaxing || candidate_weight < route_relaxing->weight) {
+                route_relaxing = RouteInternalData{candidate_weight, edge_id};
+                queue.push({candidate_weight, edge.to});
+            }
+        }
+    }
+
+    return tree;
+}
+
+template <typename Weight>
+const typename DijkstraRouter<Weight>::ShortestPathTree& DijkstraRouter<Weight>::GetShortestPathTree(VertexId from) const {
+    if (auto it = cache_.find(from); it != cache_.end()) {
+        cache_order_.splice(cache_order_.begin(), cache_order_, it->second.order_pos);
+        return it->second.tree;
+    }
+
+    // дерево строится до изменения кэша: исключение при поиске (недопустимая вершина, нехватка памяти)
+    // оставляет кэш прежним, без записи с пустым деревом и недействительной позицией в cache_order_
+    ShortestPathTree tree = BuildShortestPathTree(from);
+    if (cache_.size() >= cache_size_) {
+        cache_.erase(cache_order_.back());
+        cache_order_.pop_back();
+    }
+    cache_order_.push_front(from);
+    try {
+        const auto it = cache_.emplace(from, CacheEntry{std::move(tree), cache_order_.begin()}).first;
+        return it->second.tree;
+    } catch (...) {
+        cache_order_.pop_front();
+        throw;
+    }
+}
+
+template <typename Weight>
+std::optional<typename DijkstraRouter<Weight>::RouteInfo> DijkstraRouter<Weight>::BuildRoute(VertexId from,
+                                                                                             VertexId to) const {
+    std::lock_guard guard(cache_mutex_);
+
+    const ShortestPathTree& tree = GetShortestPathTree(from);
+    const auto& route_internal_data = tree.at(to);
+    if (!route_internal_data) {
+        return std::nullopt;
+    }
+    const Weight weight = route_internal_data->weight;
+    std::vector<EdgeId> edges;
+    for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge;
+         edge_id;
+         edge_id = tree[graph_.GetEdge(*edge_id).from]->prev_edge)
+    {
+        edges.push_back(*edge_id);
+    }
+    std::reverse(edges.begin(), edges.end());
+
+    return RouteInfo{weight, std::move(edges)};
+}
+
+}  // namespace graph
@@ -11,10 +11,4 @@ Stop::Stop(std::string name, double latitude, double longitude)
 {
 }
 
-Bus::Bus(std::string bus, std::vector<Stop*> stops)
-: bus_name(std::move(bus))
-, bus_stops(std::move(stops))
-{
-}
-
 }  // namespace domain
\ No newline at end of file
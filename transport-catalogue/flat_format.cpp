@@ -0,0 +1,140 @@
+#include "flat_format.h"
+
+#include <algorithm>
+
+namespace serialization {
+
+namespace flat {
+
+namespace {
+
+size_t Align(size_t offset, size_t alignment) {
+    return (offset + alignment - 1) / alignment * alignment;
+}
+
+}  // namespace
+
+std::uint64_t ComputeChecksum(const char* data, size_t size) {
+    // FNV-1a по 8-байтовым словам: на порядок быстрее побайтового и достаточно для поиска повреждений
+    constexpr std::uint64_t OFFSET_BASIS = 14695981039346656037ull;
+    constexpr std::uint64_t PRIME = 1099511628211ull;
+    std::uint64_t hash = OFFSET_BASIS;
+    size_t i = 0;
+    for (; i + sizeof(std::uint64_t) <= size; i += sizeof(std::uint64_t)) {
+        std::uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        hash = (hash ^ word) * PRIME;
+    }
+    for (; i < size; ++i) {
+        hash = (hash ^ static_cast<unsigned char>(data[i])) * PRIME;
+    }
+    return hash ^ size;
+}
+
+// ---------------Writer---------------
+
+void Writer::AddBytes(SectionId id, const char* data, size_t size, size_t alignment, std::uint32_t flags) {
+    sections_.push_back({id, flags, data, size, alignment});
+}
+
+void Writer::Write(std::ostream& out) const {
+    FileHeader header{};
+    std::memcpy(header.magic, FILE_MAGIC, sizeof(header.magic));
+    header.version = FILE_VERSION;
+    header.byte_order_mark = BYTE_ORDER_MARK;
+    header.section_count = static_cast<std::uint32_t>(sections_.size());
+
+    std::vector<SectionEntry> entries;
+    entries.reserve(sections_.size());
+    size_t offset = sizeof(FileHeader) + sections_.size() * sizeof(SectionEntry);
+    for (const auto& section : sections_) {
+        offset = Align(offset, section.alignment);
+        entries.push_back({section.id, section.flags, offset, section.size, ComputeChecksum(section.data, section.size)});
+        offset += section.size;
+    }
+
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(SectionEntry)));
+    size_t position = sizeof(FileHeader) + entries.size() * sizeof(SectionEntry);
+    static const char zeros[4096] = {};
+    for (size_t i = 0; i < sections_.size(); ++i) {
+        for (size_t padding = entries[i].offset - position; padding != 0;) {
+            const size_t chunk = std::min(padding, sizeof(zeros));
+            out.write(zeros, static_cast<std::streamsize>(chunk));
+            padding -= chunk;
+        }
+        out.write(sections_[i].data, static_cast<std::streamsize>(sections_[i].size));
+        position = entries[i].offset + sections_[i].size;
+    }
+}
+
+// ---------------Reader---------------
+
+Reader::Reader(std::shared_ptr<const MappedFile> file)
+: file_(std::move(file)) {
+    if (!IsFlat(*file_)) {
+        throw std::runtime_error("Not a flat database file");
+    }
+    FileHeader header;
+    std::memcpy(&header, file_->GetData(), sizeof(header));
+    if (header.version != FILE_VERSION) {
+        throw std::runtime_error("Unsupported flat database version " + std::to_string(header.version));
+    }
+    if (header.byte_order_mark != BYTE_ORDER_MARK) {
+        throw std::runtime_error("Flat database was written on a machine with another byte order");
+    }
+    if (header.section_count > (file_->GetSize() - sizeof(FileHeader)) / sizeof(SectionEntry)) {
+        throw std::runtime_error("Flat database section directory is truncated");
+    }
+
+    sections_.resize(header.section_count);
+    std::memcpy(sections_.data(), file_->GetData() + sizeof(FileHeader), sections_.size() * sizeof(SectionEntry));
+    for (const auto& section : sections_) {
+        if (section.offset > file_->GetSize() || section.size > file_->GetSize() - section.offset) {
+            throw std::runtime_error("Flat section " + std::to_string(section.id) + " is out of the file");
+        }
+    }
+}
+
+bool Reader::IsFlat(const MappedFile& file) {
+    return file.GetSize() >= sizeof(FileHeader) && std::memcmp(file.GetData(), FILE_MAGIC, sizeof(FILE_MAGIC)) == 0;
+}
+
+bool Reader::HasSection(SectionId id) const {
+    return FindSection(id) != nullptr;
+}
+
+size_t Reader::GetSize(SectionId id) const {
+    const SectionEntry* section = FindSection(id);
+    if (section == nullptr) {
+        throw std::runtime_error("Flat section " + std::to_string(id) + " is missing");
+    }
+    return section->size;
+}
+
+std::string_view Reader::GetBytes(SectionId id) const {
+    const SectionEntry* section = FindSection(id);
+    if (section == nullptr) {
+        throw std::runtime_error("Flat section " + std::to_string(id) + " is missing");
+    }
+    const char* data = file_->GetData() + section->offset;
+    if ((section->flags & SECTION_LAZY) == 0 && ComputeChecksum(data, section->size) != section->checksum) {
+        throw std::runtime_error("Flat section " + std::to_string(id) + " is corrupted");
+    }
+    return {data, section->size};
+}
+
+const std::shared_ptr<const MappedFile>& Reader::GetFile() const {
+    return file_;
+}
+
+const SectionEntry* Reader::FindSection(SectionId id) const {
+    const auto it = std::find_if(sections_.begin(), sections_.end(), [id](const SectionEntry& section) {
+        return section.id == id;
+    });
+    return it == sections_.end() ? nullptr : &*it;
+}
+
+}  // namespace flat
+
+}  // namespace serialization
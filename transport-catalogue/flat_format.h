@@ -0,0 +1,115 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "mapped_file.h"
+#include "ranges.h"
+
+namespace serialization {
+
+/*
+ * Плоский файл секций: заголовок, каталог секций, затем сами секции. Секция - массив значений
+ * фиксированного размера, записанный как есть с выровненного смещения, так что из отображённого
+ * в память файла он читается на месте. Для каждой секции в каталоге хранятся номер, смещение,
+ * размер и контрольная сумма. Порядок байтов - как у записавшей машины, он проверяется по метке в заголовке
+ */
+namespace flat {
+
+using SectionId = std::uint32_t;
+
+inline constexpr char FILE_MAGIC[8] = {'T', 'C', 'F', 'L', 'A', 'T', '\0', '\0'};
+inline constexpr std::uint32_t FILE_VERSION = 1;
+inline constexpr std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+// Контрольная сумма секции не проверяется: проверка прочитала бы секцию целиком,
+// а большие секции (таблица маршрутов) читаются по запросу
+inline constexpr std::uint32_t SECTION_LAZY = 1;
+
+struct FileHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byte_order_mark;
+    std::uint32_t section_count;
+    std::uint32_t reserved;
+};
+
+struct SectionEntry {
+    SectionId id;
+    std::uint32_t flags;
+    std::uint64_t offset;
+    std::uint64_t size;
+    std::uint64_t checksum;
+};
+
+std::uint64_t ComputeChecksum(const char* data, size_t size);
+
+class Writer {
+public:
+    // Данные не копируются и должны жить до вызова Write
+    void AddBytes(SectionId id, const char* data, size_t size, size_t alignment = 8, std::uint32_t flags = 0);
+
+    template <typename T>
+    void AddArray(SectionId id, ranges::Span<T> array, size_t alignment = 8, std::uint32_t flags = 0) {
+        static_assert(std::is_trivially_copyable_v<T>, "Flat sections hold trivially copyable values");
+        AddBytes(id, reinterpret_cast<const char*>(array.data()), array.size() * sizeof(T),
+                 std::max(alignment, alignof(T)), flags);
+    }
+
+    void Write(std::ostream& out) const;
+
+private:
+    struct Section {
+        SectionId id;
+        std::uint32_t flags;
+        const char* data;
+        size_t size;
+        size_t alignment;
+    };
+    std::vector<Section> sections_;
+};
+
+class Reader {
+public:
+    // Проверяет заголовок и каталог; ошибка - std::runtime_error. Контрольная сумма секции
+    // проверяется при её получении, так что непрочитанные секции ничего не стоят
+    explicit Reader(std::shared_ptr<const MappedFile> file);
+
+    static bool IsFlat(const MappedFile& file);
+
+    bool HasSection(SectionId id) const;
+    // Размер секции в байтах; сама секция не читается
+    size_t GetSize(SectionId id) const;
+    std::string_view GetBytes(SectionId id) const;
+
+    template <typename T>
+    ranges::Span<T> GetArray(SectionId id) const {
+        static_assert(std::is_trivially_copyable_v<T>, "Flat sections hold trivially copyable values");
+        const std::string_view bytes = GetBytes(id);
+        if (bytes.size() % sizeof(T) != 0 || reinterpret_cast<std::uintptr_t>(bytes.data()) % alignof(T) != 0) {
+            throw std::runtime_error("Flat section " + std::to_string(id) + " does not hold an array of this type");
+        }
+        return {reinterpret_cast<const T*>(bytes.data()), bytes.size() / sizeof(T)};
+    }
+
+    const std::shared_ptr<const MappedFile>& GetFile() const;
+
+private:
+    std::shared_ptr<const MappedFile> file_;
+    std::vector<SectionEntry> sections_;
+
+    const SectionEntry* FindSection(SectionId id) const;
+};
+
+}  // namespace flat
+
+}  // namespace serialization
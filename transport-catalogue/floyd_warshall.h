@@ -0,0 +1,162 @@
+#pragma once
+
+#include "graph.h"
+#include "routes_table.h"
+#include "thread_pool.h"
+
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define GRAPH_FLOYD_WARSHALL_AVX2
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define GRAPH_FLOYD_WARSHALL_SSE2
+#endif
+
+namespace graph {
+
+namespace floyd_warshall {
+
+// на графах меньше этого размера накладные расходы на потоки превышают выигрыш
+inline constexpr size_t PARALLEL_THRESHOLD = 256;
+
+template <typename Weight>
+void RelaxRowScalar(const Weight* row_k, const TableEdgeId* prev_k, Weight* row_i, TableEdgeId* prev_i,
+                    Weight weight_ik, TableEdgeId prev_ik, size_t begin, size_t end) {
+    for (size_t j = begin; j < end; ++j) {
+        const Weight candidate_weight = weight_ik + row_k[j];
+        if (candidate_weight < row_i[j]) {
+            row_i[j] = candidate_weight;
+            prev_i[j] = prev_k[j] != NO_EDGE ? prev_k[j] : prev_ik;
+        }
+    }
+}
+
+// Релаксация участка [begin, end) строки i через вершину k: d[i][j] = min(d[i][j], d[i][k] + d[k][j])
+template <typename Weight>
+void RelaxRow(const Weight* row_k, const TableEdgeId* prev_k, Weight* row_i, TableEdgeId* prev_i,
+              Weight weight_ik, TableEdgeId prev_ik, size_t begin, size_t end) {
+    size_t j = begin;
+#if defined(GRAPH_FLOYD_WARSHALL_AVX2)
+    if constexpr (std::is_same_v<Weight, double>) {
+        const __m128i no_edge_x4 = _mm_set1_epi32(static_cast<int>(NO_EDGE));
+        const __m128i prev_ik_x4 = _mm_set1_epi32(static_cast<int>(prev_ik));
+        // маска сравнения 4 x 64 бит сжимается до 4 x 32 бит для плоскости рёбер
+        const __m256i mask_to_32 = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+        const __m256d weight_ik_x4 = _mm256_set1_pd(weight_ik);
+        for (; j + 4 <= end; j += 4) {
+            const __m256d candidate = _mm256_add_pd(weight_ik_x4, _mm256_loadu_pd(row_k + j));
+            const __m256d current = _mm256_loadu_pd(row_i + j);
+            const __m256d improved = _mm256_cmp_pd(candidate, current, _CMP_LT_OQ);
+            if (_mm256_movemask_pd(improved) == 0) {
+                continue;
+            }
+            const __m128i improved_32 = _mm256_castsi256_si128(
+                    _mm256_permutevar8x32_epi32(_mm256_castpd_si256(improved), mask_to_32));
+            const __m128i prev_kj = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prev_k + j));
+            const __m128i new_prev = _mm_blendv_epi8(prev_kj, prev_ik_x4, _mm_cmpeq_epi32(prev_kj, no_edge_x4));
+            // записываются только улучшенные ячейки: строку i не нужно читать заново и смешивать
+            _mm256_maskstore_pd(row_i + j, _mm256_castpd_si256(improved), candidate);
+            _mm_maskstore_epi32(reinterpret_cast<int*>(prev_i + j), improved_32, new_prev);
+        }
+    } else if constexpr (std::is_same_v<Weight, float>) {
+        const __m256i no_edge_x8 = _mm256_set1_epi32(static_cast<int>(NO_EDGE));
+        const __m256i prev_ik_x8 = _mm256_set1_epi32(static_cast<int>(prev_ik));
+        const __m256 weight_ik_x8 = _mm256_set1_ps(weight_ik);
+        for (; j + 8 <= end; j += 8) {
+            const __m256 candidate = _mm256_add_ps(weight_ik_x8, _mm256_loadu_ps(row_k + j));
+            const __m256 current = _mm256_loadu_ps(row_i + j);
+            const __m256 improved = _mm256_cmp_ps(candidate, current, _CMP_LT_OQ);
+            if (_mm256_movemask_ps(improved) == 0) {
+                continue;
+            }
+            const __m256i prev_kj = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(prev_k + j));
+            const __m256i new_prev = _mm256_blendv_epi8(prev_kj, prev_ik_x8, _mm256_cmpeq_epi32(prev_kj, no_edge_x8));
+            _mm256_maskstore_ps(row_i + j, _mm256_castps_si256(improved), candidate);
+            _mm256_maskstore_epi32(reinterpret_cast<int*>(prev_i + j), _mm256_castps_si256(improved), new_prev);
+        }
+    }
+#elif defined(GRAPH_FLOYD_WARSHALL_SSE2)
+    if constexpr (std::is_same_v<Weight, double>) {
+        const __m128d weight_ik_x2 = _mm_set1_pd(weight_ik);
+        for (; j + 2 <= end; j += 2) {
+            const __m128d candidate = _mm_add_pd(weight_ik_x2, _mm_loadu_pd(row_k + j));
+            const __m128d current = _mm_loadu_pd(row_i + j);
+            if (_mm_movemask_pd(_mm_cmplt_pd(candidate, current)) == 0) {
+                continue;
+            }
+            // маски 2 x 64 бит в SSE2 не сжать до 32 бит, поэтому редкие улучшения записываем поштучно
+            RelaxRowScalar(row_k, prev_k, row_i, prev_i, weight_ik, prev_ik, j, j + 2);
+        }
+    } else if constexpr (std::is_same_v<Weight, float>) {
+        const __m128i no_edge_x4 = _mm_set1_epi32(static_cast<int>(NO_EDGE));
+        const __m128i prev_ik_x4 = _mm_set1_epi32(static_cast<int>(prev_ik));
+        const __m128 weight_ik_x4 = _mm_set1_ps(weight_ik);
+        auto select = [](__m128i mask, __m128i if_set, __m128i if_unset) {
+            return _mm_or_si128(_mm_and_si128(mask, if_set), _mm_andnot_si128(mask, if_unset));
+        };
+        for (; j + 4 <= end; j += 4) {
+            const __m128 candidate = _mm_add_ps(weight_ik_x4, _mm_loadu_ps(row_k + j));
+            const __m128 current = _mm_loadu_ps(row_i + j);
+            const __m128 improved = _mm_cmplt_ps(candidate, current);
+            if (_mm_movemask_ps(improved) == 0) {
+                continue;
+            }
+            const __m128i improved_mask = _mm_castps_si128(improved);
+            const __m128i prev_kj = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prev_k + j));
+            const __m128i prev_ij = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prev_i + j));
+            const __m128i new_prev = select(_mm_cmpeq_epi32(prev_kj, no_edge_x4), prev_ik_x4, prev_kj);
+            _mm_storeu_ps(row_i + j, _mm_or_ps(_mm_and_ps(improved, candidate), _mm_andnot_ps(improved, current)));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(prev_i + j), select(improved_mask, new_prev, prev_ij));
+        }
+    }
+#endif
+    RelaxRowScalar(row_k, prev_k, row_i, prev_i, weight_ik, prev_ik, j, end);
+}
+
+/*
+ * Алгоритм Флойда-Уоршелла над таблицей RoutesTable.
+ * Вершины-посредники k перебираются строго по порядку, поэтому результат (включая выбор рёбер
+ * при равных весах) совпадает с последовательной реализацией бит в бит. Внутри шага k строки
+ * обрабатываются параллельно: при неотрицательных весах строка и столбец k на шаге k не меняются
+ */
+template <typename Weight>
+void RelaxAllPairs(RoutesTable<Weight>& table, concurrency::ThreadPool* pool) {
+    const size_t vertex_count = table.vertex_count;
+    Weight* weights = table.weights.data();
+    TableEdgeId* prev_edges = table.prev_edges.data();
+
+    for (size_t vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
+        const Weight* row_k = weights + vertex_through * vertex_count;
+        const TableEdgeId* prev_k = prev_edges + vertex_through * vertex_count;
+
+        // строки проходятся целиком и подряд: без блоков по k полосы столбцов не сокращают обмен с памятью,
+        // а короткие участки строк с большим шагом хуже предвыбираются
+        auto relax_rows = [&](size_t rows_begin, size_t rows_end) {
+            for (size_t vertex_from = rows_begin; vertex_from < rows_end; ++vertex_from) {
+                Weight* row_i = weights + vertex_from * vertex_count;
+                const Weight weight_ik = row_i[vertex_through];
+                if (weight_ik == RoutesTable<Weight>::UNREACHABLE) {
+                    continue;
+                }
+                RelaxRow(row_k, prev_k, row_i, prev_edges + vertex_from * vertex_count,
+                         weight_ik, prev_edges[vertex_from * vertex_count + vertex_through],
+                         0, vertex_count);
+            }
+        };
+
+        if (pool != nullptr && vertex_count >= PARALLEL_THRESHOLD) {
+            pool->ParallelFor(0, vertex_count, relax_rows);
+        } else {
+            relax_rows(0, vertex_count);
+        }
+    }
+}
+
+}  // namespace floyd_warshall
+
+}  // namespace graph
@@ -2,14 +2,22 @@
 
 #include "ranges.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <cstdlib>
-#include <vector>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
 #include <string_view>
+#include <unordered_map>
+#include <vector>
 
 namespace graph {
 
 using VertexId = size_t;
 using EdgeId = size_t;
+using NameId = std::uint32_t; // номер названия (автобуса или остановки) в таблице названий графа
 
 template <typename Weight>
 struct Edge {
@@ -17,74 +25,348 @@ struct Edge {
     VertexId to;
     Weight weight;
 
-    std::string name;
+    NameId name_id = 0;
     size_t span_count = 0;
 };
 
+/*
+ * Граф строится в два этапа. Сначала рёбра добавляются через AddEdge, затем Freeze переводит граф
+ * в неизменяемый CSR-вид: рёбра вершины лежат подряд, а их поля хранятся отдельными массивами.
+ * Номера рёбер назначаются при заморозке: рёбра упорядочиваются по начальной вершине, порядок
+ * рёбер одной вершины сохраняется. Названия хранятся один раз в таблице строк графа.
+ * Массивы замороженного графа либо свои, либо лежат во внешней памяти (отображённом файле базы)
+ * и читаются на месте
+ */
 template <typename Weight>
 class DirectedWeightedGraph {
 private:
-    using IncidenceList = std::vector<EdgeId>; // [Edge_id_1, Edge_id_2, Edge_id_3]
-    using IncidentEdgesRange = ranges::Range<typename IncidenceList::const_iterator>;
+    using IncidentEdgesRange = ranges::Range<ranges::IndexIterator<EdgeId>>;
 
 public:
-    DirectedWeightedGraph() = default;
+    using Index = std::uint32_t; // номера вершин и рёбер, счётчики пролётов в CSR-массивах
+
+    // CSR-массивы: offsets[v]..offsets[v + 1] - рёбра вершины v, sources - начальные вершины рёбер;
+    // таблица названий - символы подряд и смещения начала каждого названия (на одно больше, чем названий)
+    struct Arrays {
+        ranges::Span<Index> offsets;
+        ranges::Span<Index> sources;
+        ranges::Span<Index> targets;
+        ranges::Span<Weight> weights;
+        ranges::Span<NameId> name_ids;
+        ranges::Span<Index> span_counts;
+        ranges::Span<char> name_chars;
+        ranges::Span<std::uint32_t> name_offsets;
+    };
+
+    DirectedWeightedGraph();
     explicit DirectedWeightedGraph(size_t vertex_count);
 
+    // Замороженный граф из готовых CSR-массивов
+    DirectedWeightedGraph(std::vector<Index> offsets,
+                          std::vector<Index> targets,
+                          std::vector<Weight> weights,
+                          std::vector<NameId> name_ids,
+                          std::vector<Index> span_counts,
+                          const std::vector<std::string>& names);
+    // Замороженный граф над массивами во внешней памяти, которую держит storage;
+    // пустые sources при непустых рёбрах восстанавливаются по offsets в свой массив
+    DirectedWeightedGraph(const Arrays& arrays, std::shared_ptr<const void> storage);
 
-    DirectedWeightedGraph(std::vector<Edge<Weight>> edges,
-                          std::vector<IncidenceList> incidence_lists);
+    // Массивы векторов при перемещении остаются на месте, поэтому arrays_ остаются верными
+    DirectedWeightedGraph(DirectedWeightedGraph&&) = default;
+    DirectedWeightedGraph& operator=(DirectedWeightedGraph&&) = default;
+    DirectedWeightedGraph(const DirectedWeightedGraph&) = delete;
+    DirectedWeightedGraph& operator=(const DirectedWeightedGraph&) = delete;
 
-    EdgeId AddEdge(const Edge<Weight>& edge);
+    // Только до заморозки
+    NameId AddName(std::string_view name);
+    void AddEdge(const Edge<Weight>& edge);
+    void Freeze();
+
+    bool IsFrozen() const;
 
     size_t GetVertexCount() const;
     size_t GetEdgeCount() const;
-    const Edge<Weight>& GetEdge(EdgeId edge_id) const;
+    Edge<Weight> GetEdge(EdgeId edge_id) const;
     IncidentEdgesRange GetIncidentEdges(VertexId vertex) const;
+    size_t GetNameCount() const;
+    std::string_view GetName(NameId name_id) const;
+
+    const Arrays& GetArrays() const;
+    ranges::Span<Index> GetOffsets() const;
+    ranges::Span<Index> GetTargets() const;
+    ranges::Span<Weight> GetWeights() const;
+    ranges::Span<NameId> GetNameIds() const;
+    ranges::Span<Index> GetSpanCounts() const;
 
 private:
-    std::vector<Edge<Weight>> edges_;
-    std::vector<IncidenceList> incidence_lists_; // ребра, выходящие из одной точки
+    size_t vertex_count_ = 0;
+    bool is_frozen_ = false;
+    Arrays arrays_;
+    std::shared_ptr<const void> storage_; // внешняя память, на которую указывают arrays_
+
+    // свои массивы
+    std::vector<Index> offsets_;
+    std::vector<Index> sources_;
+    std::vector<Index> targets_;
+    std::vector<Weight> weights_;
+    std::vector<NameId> name_ids_;
+    std::vector<Index> span_counts_;
+    std::vector<char> name_chars_;
+    std::vector<std::uint32_t> name_offsets_{0};
+
+    // до заморозки
+    std::vector<Edge<Weight>> pending_edges_;
+    std::unordered_map<std::string, NameId> name_index_;
+
+    void CheckNotFrozen() const;
+    void CheckArrays() const;
+    void FillSources(ranges::Span<Index> offsets);
+    void BindOwnArrays();
 };
 
+template <typename Weight>
+DirectedWeightedGraph<Weight>::DirectedWeightedGraph()
+    : offsets_(1, 0) {
+    BindOwnArrays();
+}
+
 template <typename Weight>
 DirectedWeightedGraph<Weight>::DirectedWeightedGraph(size_t vertex_count)
-    : incidence_lists_(vertex_count) {
+    : vertex_count_(vertex_count)
+    , offsets_(vertex_count + 1, 0) {
+    BindOwnArrays();
+}
+
+template <typename Weight>
+DirectedWeightedGraph<Weight>::DirectedWeightedGraph(std::vector<Index> offsets,
+                                                     std::vector<Index> targets,
+                                                     std::vector<Weight> weights,
+                                                     std::vector<NameId> name_ids,
+                                                     std::vector<Index> span_counts,
+                                                     const std::vector<std::string>& names)
+    : vertex_count_(offsets.empty() ? 0 : offsets.size() - 1)
+    , is_frozen_(true)
+    , offsets_(std::move(offsets))
+    , targets_(std::move(targets))
+    , weights_(std::move(weights))
+    , name_ids_(std::move(name_ids))
+    , span_counts_(std::move(span_counts)) {
+    if (offsets_.empty()) {
+        offsets_.push_back(0);
+    }
+    for (const auto& name : names) {
+        name_chars_.insert(name_chars_.end(), name.begin(), name.end());
+        name_offsets_.push_back(static_cast<std::uint32_t>(name_chars_.size()));
+    }
+    const size_t edge_count = targets_.size();
+    if (offsets_.front() != 0 || offsets_.back() != edge_count) {
+        throw std::invalid_argument("Inconsistent CSR graph arrays");
+    }
+    for (size_t vertex = 0; vertex < vertex_count_; ++vertex) {
+        if (offsets_[vertex] > offsets_[vertex + 1]) {
+            throw std::invalid_argument("CSR graph offsets should be non-decreasing");
+        }
+    }
+    FillSources(offsets_);
+    BindOwnArrays();
+    CheckArrays();
+}
+
+template <typename Weight>
+DirectedWeightedGraph<Weight>::DirectedWeightedGraph(const Arrays& arrays, std::shared_ptr<const void> storage)
+    : vertex_count_(arrays.offsets.empty() ? 0 : arrays.offsets.size() - 1)
+    , is_frozen_(true)
+    , arrays_(arrays)
+    , storage_(std::move(storage)) {
+    if (arrays_.sources.empty() && !arrays_.targets.empty() && !arrays_.offsets.empty()
+        && arrays_.offsets.back() == arrays_.targets.size()) {
+        FillSources(arrays_.offsets);
+        arrays_.sources = sources_;
+    }
+    CheckArrays();
+}
+
+template <typename Weight>
+NameId DirectedWeightedGraph<Weight>::AddName(std::string_view name) {
+    CheckNotFrozen();
+    const auto [it, inserted] = name_index_.emplace(std::string(name), static_cast<NameId>(name_offsets_.size() - 1));
+    if (inserted) {
+        name_chars_.insert(name_chars_.end(), name.begin(), name.end());
+        name_offsets_.push_back(static_cast<std::uint32_t>(name_chars_.size()));
+    }
+    return it->second;
+}
+
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::AddEdge(const Edge<Weight>& edge) {
+    CheckNotFrozen();
+    if (edge.from >= vertex_count_ || edge.to >= vertex_count_) {
+        throw std::out_of_range("Edge vertex is out of the graph");
+    }
+    pending_edges_.push_back(edge);
 }
 
 template <typename Weight>
-DirectedWeightedGraph<Weight>::DirectedWeightedGraph(std::vector<Edge<Weight>> edges,
-                                                     std::vector<IncidenceList> incidence_lists)
-    : edges_(std::move(edges))
-    , incidence_lists_(std::move(incidence_lists)) {
+void DirectedWeightedGraph<Weight>::Freeze() {
+    CheckNotFrozen();
+    if (pending_edges_.size() >= std::numeric_limits<Index>::max()
+        || vertex_count_ >= std::numeric_limits<Index>::max()) {
+        throw std::length_error("Too many edges for the CSR graph");
+    }
+
+    // сортировка подсчётом по начальной вершине сохраняет порядок добавления рёбер вершины
+    offsets_.assign(vertex_count_ + 1, 0);
+    for (const auto& edge : pending_edges_) {
+        ++offsets_[edge.from + 1];
+    }
+    for (size_t vertex = 0; vertex < vertex_count_; ++vertex) {
+        offsets_[vertex + 1] += offsets_[vertex];
+    }
+
+    const size_t edge_count = pending_edges_.size();
+    targets_.resize(edge_count);
+    weights_.resize(edge_count);
+    name_ids_.resize(edge_count);
+    span_counts_.resize(edge_count);
+    std::vector<Index> positions(offsets_.begin(), offsets_.end() - 1);
+    for (const auto& edge : pending_edges_) {
+        const Index edge_id = positions[edge.from]++;
+        targets_[edge_id] = static_cast<Index>(edge.to);
+        weights_[edge_id] = edge.weight;
+        name_ids_[edge_id] = edge.name_id;
+        span_counts_[edge_id] = static_cast<Index>(edge.span_count);
+    }
+
+    pending_edges_ = {};
+    name_index_ = {};
+    is_frozen_ = true;
+    FillSources(offsets_);
+    BindOwnArrays();
 }
 
 template <typename Weight>
-EdgeId DirectedWeightedGraph<Weight>::AddEdge(const Edge<Weight>& edge) {
-    edges_.push_back(edge);
-    const EdgeId id = edges_.size() - 1;
-    incidence_lists_.at(edge.from).push_back(id);
-    return id;
+bool DirectedWeightedGraph<Weight>::IsFrozen() const {
+    return is_frozen_;
 }
 
 template <typename Weight>
 size_t DirectedWeightedGraph<Weight>::GetVertexCount() const {
-    return incidence_lists_.size();
+    return vertex_count_;
 }
 
 template <typename Weight>
 size_t DirectedWeightedGraph<Weight>::GetEdgeCount() const {
-    return edges_.size();
+    return arrays_.targets.size();
 }
 
 template <typename Weight>
-const Edge<Weight>& DirectedWeightedGraph<Weight>::GetEdge(EdgeId edge_id) const {
-    return edges_.at(edge_id);
+Edge<Weight> DirectedWeightedGraph<Weight>::GetEdge(EdgeId edge_id) const {
+    return {arrays_.sources.at(edge_id), arrays_.targets[edge_id], arrays_.weights[edge_id],
+            arrays_.name_ids[edge_id], arrays_.span_counts[edge_id]};
 }
 
 template <typename Weight>
 typename DirectedWeightedGraph<Weight>::IncidentEdgesRange
 DirectedWeightedGraph<Weight>::GetIncidentEdges(VertexId vertex) const {
-    return ranges::AsRange(incidence_lists_.at(vertex));
+    return ranges::AsIndexRange<EdgeId>(arrays_.offsets.at(vertex), arrays_.offsets.at(vertex + 1));
+}
+
+template <typename Weight>
+size_t DirectedWeightedGraph<Weight>::GetNameCount() const {
+    return arrays_.name_offsets.size() - 1;
+}
+
+template <typename Weight>
+std::string_view DirectedWeightedGraph<Weight>::GetName(NameId name_id) const {
+    const auto begin = arrays_.name_offsets.at(name_id);
+    return {arrays_.name_chars.data() + begin, arrays_.name_offsets.at(name_id + 1) - begin};
+}
+
+template <typename Weight>
+const typename DirectedWeightedGraph<Weight>::Arrays& DirectedWeightedGraph<Weight>::GetArrays() const {
+    return arrays_;
+}
+
+template <typename Weight>
+ranges::Span<typename DirectedWeightedGraph<Weight>::Index> DirectedWeightedGraph<Weight>::GetOffsets() const {
+    return arrays_.offsets;
+}
+
+template <typename Weight>
+ranges::Span<typename DirectedWeightedGraph<Weight>::Index> DirectedWeightedGraph<Weight>::GetTargets() const {
+    return arrays_.targets;
+}
+
+template <typename Weight>
+ranges::Span<Weight> DirectedWeightedGraph<Weight>::GetWeights() const {
+    return arrays_.weights;
+}
+
+template <typename Weight>
+ranges::Span<NameId> DirectedWeightedGraph<Weight>::GetNameIds() const {
+    return arrays_.name_ids;
+}
+
+template <typename Weight>
+ranges::Span<typename DirectedWeightedGraph<Weight>::Index> DirectedWeightedGraph<Weight>::GetSpanCounts() const {
+    return arrays_.span_counts;
+}
+
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::CheckNotFrozen() const {
+    if (is_frozen_) {
+        throw std::logic_error("Graph is frozen");
+    }
+}
+
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::CheckArrays() const {
+    const auto& offsets = arrays_.offsets;
+    const size_t edge_count = arrays_.targets.size();
+    const size_t name_count = arrays_.name_offsets.empty() ? 0 : arrays_.name_offsets.size() - 1;
+    if (offsets.empty() || offsets.front() != 0 || offsets.back() != edge_count
+        || arrays_.sources.size() != edge_count || arrays_.weights.size() != edge_count
+        || arrays_.name_ids.size() != edge_count || arrays_.span_counts.size() != edge_count
+        || arrays_.name_offsets.empty() || arrays_.name_offsets.front() != 0
+        || arrays_.name_offsets.back() != arrays_.name_chars.size()) {
+        throw std::invalid_argument("Inconsistent CSR graph arrays");
+    }
+    for (size_t vertex = 0; vertex < vertex_count_; ++vertex) {
+        if (offsets[vertex] > offsets[vertex + 1]) {
+            throw std::invalid_argument("CSR graph offsets should be non-decreasing");
+        }
+        for (Index edge_id = offsets[vertex]; edge_id < offsets[vertex + 1]; ++edge_id) {
+            if (arrays_.sources[edge_id] != vertex) {
+                throw std::invalid_argument("CSR graph edge source does not match offsets");
+            }
+        }
+    }
+    for (size_t name_id = 0; name_id < name_count; ++name_id) {
+        if (arrays_.name_offsets[name_id] > arrays_.name_offsets[name_id + 1]) {
+            throw std::invalid_argument("CSR graph name offsets should be non-decreasing");
+        }
+    }
+    for (size_t edge_id = 0; edge_id < edge_count; ++edge_id) {
+        if (arrays_.targets[edge_id] >= vertex_count_ || arrays_.name_ids[edge_id] >= name_count) {
+            throw std::invalid_argument("CSR graph edge is out of range");
+        }
+    }
+}
+
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::FillSources(ranges::Span<Index> offsets) {
+    sources_.resize(offsets.back());
+    for (size_t vertex = 0; vertex < vertex_count_; ++vertex) {
+        if (offsets[vertex] > offsets[vertex + 1]) {
+            throw std::invalid_argument("CSR graph offsets should be non-decreasing");
+        }
+        std::fill(sources_.begin() + offsets[vertex], sources_.begin() + offsets[vertex + 1], static_cast<Index>(vertex));
+    }
+}
+
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::BindOwnArrays() {
+    arrays_ = {offsets_, sources_, targets_, weights_, name_ids_, span_counts_, name_chars_, name_offsets_};
 }
 }  // namespace graph
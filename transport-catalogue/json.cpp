@@ -1,220 +1,22 @@
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <iterator>
 #include <stdexcept>
 #include <sstream>
+#include <tuple>
 
 #include "json.h"
+#include "string_scan.h"
 
 namespace json {
 
 namespace {
 using namespace std::literals;
 
-Node LoadNode(std::istream& input);
-Node LoadString(std::istream& input);
-
-std::string LoadLiteral(std::istream& input) {
-    std::string s;
-    while (std::isalpha(input.peek())) {
-        s.push_back(static_cast<char>(input.get()));
-    }
-    return s;
-}
-
-Node LoadArray(std::istream& input) {
-    std::vector<Node> result;
-
-    for (char c; input >> c && c != ']';) {
-        if (c != ',') {
-            input.putback(c);
-        }
-        result.push_back(LoadNode(input));
-    }
-    if (!input) {
-        throw ParsingError("Array parsing error"s);
-    }
-    return Node(std::move(result));
-}
-
-Node LoadDict(std::istream& input) {
-    Dict dict;
-
-    for (char c; input >> c && c != '}';) {
-        if (c == '"') {
-            std::string key = LoadString(input).AsString();
-            if (input >> c && c == ':') {
-                if (dict.find(key) != dict.end()) {
-                    throw ParsingError("Duplicate key '"s + key + "' have been found");
-                }
-                dict.emplace(std::move(key), LoadNode(input));
-            } else {
-                throw ParsingError(": is expected but '"s + c + "' has been found"s);
-            }
-        } else if (c != ',') {
-            throw ParsingError(R"(',' is expected but ')"s + c + "' has been found"s);
-        }
-    }
-    if (!input) {
-        throw ParsingError("Dictionary parsing error"s);
-    }
-    return Node(std::move(dict));
-}
-
-Node LoadString(std::istream& input) {
-    auto it = std::istreambuf_iterator<char>(input);
-    auto end = std::istreambuf_iterator<char>();
-    std::string s;
-    while (true) {
-        if (it == end) {
-            throw ParsingError("String parsing error");
-        }
-        const char ch = *it;
-        if (ch == '"') {
-            ++it;
-            break;
-        } else if (ch == '\\') {
-            ++it;
-            if (it == end) {
-                throw ParsingError("String parsing error");
-            }
-            const char escaped_char = *(it);
-            switch (escaped_char) {
-                case 'n':
-                    s.push_back('\n');
-                    break;
-                case 't':
-                    s.push_back('\t');
-                    break;
-                case 'r':
-                    s.push_back('\r');
-                    break;
-                case '"':
-                    s.push_back('"');
-                    break;
-                case '\\':
-                    s.push_back('\\');
-                    break;
-                default:
-                    throw ParsingError("Unrecognized escape sequence \\"s + escaped_char);
-            }
-        } else if (ch == '\n' || ch == '\r') {
-            throw ParsingError("Unexpected end of line"s);
-        } else {
-            s.push_back(ch);
-        }
-        ++it;
-    }
-
-    return Node(std::move(s));
-}
-
-Node LoadBool(std::istream& input) {
-    const auto s = LoadLiteral(input);
-    if (s == "true"sv) {
-        return Node{true};
-    } else if (s == "false"sv) {
-        return Node{false};
-    } else {
-        throw ParsingError("Failed to parse '"s + s + "' as bool"s);
-    }
-}
-
-Node LoadNull(std::istream& input) {
-    if (auto literal = LoadLiteral(input); literal == "null"sv) {
-        return Node{nullptr};
-    } else {
-        throw ParsingError("Failed to parse '"s + literal + "' as null"s);
-    }
-}
-
-Node LoadNumber(std::istream& input) {
-    std::string parsed_num;
-
-    // Считывает в parsed_num очередной символ из input
-    auto read_char = [&parsed_num, &input] {
-        parsed_num += static_cast<char>(input.get());
-        if (!input) {
-            throw ParsingError("Failed to read number from stream"s);
-        }
-    };
-
-    // Считывает одну или более цифр в parsed_num из input
-    auto read_digits = [&input, read_char] {
-        if (!std::isdigit(input.peek())) {
-            throw ParsingError("A digit is expected"s);
-        }
-        while (std::isdigit(input.peek())) {
-            read_char();
-        }
-    };
-
-    if (input.peek() == '-') {
-        read_char();
-    }
-    // Парсим целую часть числа
-    if (input.peek() == '0') {
-        read_char();
-        // После 0 в JSON не могут идти другие цифры
-    } else {
-        read_digits();
-    }
-
-    bool is_int = true;
-    // Парсим дробную часть числа
-    if (input.peek() == '.') {
-        read_char();
-        read_digits();
-        is_int = false;
-    }
-
-    // Парсим экспоненциальную часть числа
-    if (int ch = input.peek(); ch == 'e' || ch == 'E') {
-        read_char();
-        if (ch = input.peek(); ch == '+' || ch == '-') {
-            read_char();
-        }
-        read_digits();
-        is_int = false;
-    }
-
-    try {
-        if (is_int) {
-            // Сначала пробуем преобразовать строку в int
-            try {
-                return std::stoi(parsed_num);
-            } catch (...) {
-                // В случае неудачи, например, при переполнении
-                // код ниже попробует преобразовать строку в double
-            }
-        }
-        return std::stod(parsed_num);
-    } catch (...) {
-        throw ParsingError("Failed to convert "s + parsed_num + " to number"s);
-    }
-}
-
-Node LoadNode(std::istream& input) {
-    char c;
-    if (!(input >> c)) {
-        throw ParsingError("Unexpected EOF"s);
-    }
-    switch (c) {
-        case '[':
-            return LoadArray(input);
-        case '{':
-            return LoadDict(input);
-        case '"':
-            return LoadString(input);
-        case 't':
-            [[fallthrough]];
-        case 'f':
-            input.putback(c);
-            return LoadBool(input);
-        case 'n':
-            input.putback(c);
-            return LoadNull(input);
-        default:
-            input.putback(c);
-            return LoadNumber(input);
-    }
+// Символы, которые могут входить в запись числа JSON
+bool IsNumberChar(char ch) {
+    return (ch >= '0' && ch <= '9') || ch == '-' || ch == '+' || ch == '.' || ch == 'e' || ch == 'E';
 }
 
 struct PrintContext {
@@ -240,7 +42,7 @@ void PrintValue(const Value& value, const PrintContext& ctx) {
     ctx.out << value;
 }
 
-void PrintString(const std::string& value, std::ostream& out) {
+void PrintString(std::string_view value, std::ostream& out) {
     out.put('"');
     for (const char c : value) {
         switch (c) {
@@ -265,7 +67,7 @@ void PrintString(const std::string& value, std::ostream& out) {
 }
 
 template <>
-void PrintValue<std::string>(const std::string& value, const PrintContext& ctx) {
+void PrintValue<String>(const String& value, const PrintContext& ctx) {
     PrintString(value, ctx.out);
 }
 
@@ -331,6 +133,99 @@ void PrintNode(const Node& node, const PrintContext& ctx) {
 
 }  // namespace
 
+// ---------------Dict---------------
+
+Dict::Dict(std::pmr::memory_resource* resource)
+        : items_(resource) {
+}
+
+const Node& Dict::at(std::string_view key) const {
+    const auto it = find(key);
+    if (it == end()) {
+        throw std::out_of_range("Key '"s + std::string(key) + "' is not found"s);
+    }
+    return it->second;
+}
+
+Node& Dict::at(std::string_view key) {
+    return const_cast<Node&>(std::as_const(*this).at(key));
+}
+
+Dict::const_iterator Dict::find(std::string_view key) const {
+    const auto it = LowerBound(key);
+    return it != items_.end() && it->first == key ? it : items_.end();
+}
+
+Dict::iterator Dict::find(std::string_view key) {
+    const auto it = LowerBound(key);
+    return it != items_.end() && it->first == key ? it : items_.end();
+}
+
+size_t Dict::count(std::string_view key) const {
+    return find(key) == end() ? 0 : 1;
+}
+
+Node& Dict::operator[](std::string_view key) {
+    if (const auto it = find(key); it != end()) {
+        return it->second;
+    }
+    return emplace(String(key, items_.get_allocator()), Node{}).first->second;
+}
+
+std::pair<Dict::iterator, bool> Dict::emplace(String key, Node value) {
+    // ключ больше всех прежних (например, при разборе вывода Print) дописывается в конец без поиска
+    auto it = items_.empty() || items_.back().first < key ? items_.end() : LowerBound(key);
+    if (it != items_.end() && it->first == key) {
+        return {it, false};
+    }
+    it = items_.emplace(it, std::piecewise_construct, std::forward_as_tuple(std::move(key)), std::forward_as_tuple(std::move(value)));
+    return {it, true};
+}
+
+Dict::const_iterator Dict::begin() const {
+    return items_.begin();
+}
+
+Dict::const_iterator Dict::end() const {
+    return items_.end();
+}
+
+Dict::iterator Dict::begin() {
+    return items_.begin();
+}
+
+Dict::iterator Dict::end() {
+    return items_.end();
+}
+
+size_t Dict::size() const {
+    return items_.size();
+}
+
+bool Dict::empty() const {
+    return items_.empty();
+}
+
+Dict::const_iterator Dict::LowerBound(std::string_view key) const {
+    return std::lower_bound(items_.begin(), items_.end(), key, [](const value_type& item, std::string_view key) {
+        return item.first < key;
+    });
+}
+
+Dict::iterator Dict::LowerBound(std::string_view key) {
+    return std::lower_bound(items_.begin(), items_.end(), key, [](const value_type& item, std::string_view key) {
+        return item.first < key;
+    });
+}
+
+bool operator==(const Dict& lhs, const Dict& rhs) {
+    return lhs.items_ == rhs.items_;
+}
+
+bool operator!=(const Dict& lhs, const Dict& rhs) {
+    return !(lhs == rhs);
+}
+
 // ---------------Node---------------
 
 bool Node::IsInt() const {
@@ -350,7 +245,7 @@ bool Node::IsBool() const {
 }
 
 bool Node::IsString() const {
-    return std::holds_alternative<std::string>(*this);
+    return std::holds_alternative<String>(*this);
 }
 
 bool Node::IsNull() const {
@@ -390,11 +285,11 @@ double Node::AsDouble() const {
     return std::get<double>(*this);
 }
 
-const std::string& Node::AsString() const {
+std::string_view Node::AsString() const {
     if (!IsString()) {
         throw std::logic_error("Failed cast to <std::string>");
     }
-    return std::get<std::string>(*this);
+    return std::get<String>(*this);
 }
 
 const Array& Node::AsArray() const {
@@ -441,18 +336,489 @@ bool operator!=(const Node& lhs, const Node& rhs) {
 }
 
 
+// ---------------Parser---------------
+
+Parser::Parser(std::string_view input)
+        : input_(input) {
+}
+
+Parser::Parser(std::istream& input)
+        : stream_(&input) {
+    window_.reserve(2 * WINDOW_SIZE);
+}
+
+Event Parser::Next() {
+    // ссылки прошлого события больше не нужны: разобранное начало окна отбрасывается
+    if (stream_ != nullptr && pos_ >= WINDOW_SIZE) {
+        window_.erase(0, pos_);
+        input_ = window_;
+        pos_ = 0;
+    }
+    SkipSpaces();
+    if (stack_.empty()) {
+        if (!is_root_read_) {
+            return ReadValue();
+        }
+        if (IsAvailable(pos_ + 1)) {
+            throw ParsingError("Unexpected characters after the document"s);
+        }
+        return Event::END_DOCUMENT;
+    }
+    if (is_after_key_) {
+        is_after_key_ = false;
+        return ReadValue();
+    }
+    const bool is_array = stack_.back() == Container::ARRAY;
+    if (Peek() == (is_array ? ']' : '}')) {
+        ++pos_;
+        stack_.pop_back();
+        OnValueEnd();
+        return is_array ? Event::END_ARRAY : Event::END_DICT;
+    }
+    if (need_comma_) {
+        if (Peek() != ',') {
+            throw ParsingError(R"(',' is expected but ')"s + Peek() + "' has been found"s);
+        }
+        ++pos_;
+        SkipSpaces();
+    }
+    if (is_array) {
+        return ReadValue();
+    }
+    if (Peek() != '"') {
+        throw ParsingError("A key is expected but '"s + Peek() + "' has been found"s);
+    }
+    ++pos_;
+    ReadString();
+    SkipSpaces();
+    if (Peek() != ':') {
+        throw ParsingError(": is expected but '"s + Peek() + "' has been found"s);
+    }
+    ++pos_;
+    is_after_key_ = true;
+    return Event::KEY;
+}
+
+std::string_view Parser::GetString() const {
+    return string_;
+}
+
+int Parser::GetInt() const {
+    return int_;
+}
+
+double Parser::GetDouble() const {
+    return double_;
+}
+
+bool Parser::GetBool() const {
+    return bool_;
+}
+
+void Parser::SkipValue(Event event) {
+    if (event != Event::BEGIN_ARRAY && event != Event::BEGIN_DICT) {
+        return;
+    }
+    for (size_t depth = 1; depth != 0;) {
+        switch (Next()) {
+            case Event::BEGIN_ARRAY:
+            case Event::BEGIN_DICT:
+                ++depth;
+                break;
+            case Event::END_ARRAY:
+            case Event::END_DICT:
+                --depth;
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+bool Parser::IsAvailable(size_t end) {
+    while (input_.size() < end) {
+        if (!Refill()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Parser::Refill() {
+    if (stream_ == nullptr) {
+        return false;
+    }
+    std::streambuf* const stream_buffer = stream_->rdbuf();
+    if (stream_buffer == nullptr || stream_buffer->sgetc() == std::char_traits<char>::eof()) {
+        stream_->setstate(std::ios::eofbit);
+        return false;
+    }
+    // берётся то, что уже есть в буфере потока: ответ не ждёт, пока канал наполнит целый блок
+    const std::streamsize available = stream_buffer->in_avail();
+    const std::streamsize chunk_size = available > 0 ? std::min<std::streamsize>(available, WINDOW_SIZE) : WINDOW_SIZE;
+    const size_t size = window_.size();
+    window_.resize(size + static_cast<size_t>(chunk_size));
+    const std::streamsize read_size = stream_buffer->sgetn(window_.data() + size, chunk_size);
+    window_.resize(size + static_cast<size_t>(read_size));
+    input_ = window_;
+    return read_size > 0;
+}
+
+char Parser::Peek() {
+    if (!IsAvailable(pos_ + 1)) {
+        throw ParsingError("Unexpected EOF"s);
+    }
+    return input_[pos_];
+}
+
+void Parser::SkipSpaces() {
+    // окно дочитывается, только когда пробелы дошли до его конца
+    do {
+        while (pos_ < input_.size()
+               && (input_[pos_] == ' ' || input_[pos_] == '\n' || input_[pos_] == '\r' || input_[pos_] == '\t')) {
+            ++pos_;
+        }
+    } while (pos_ == input_.size() && Refill());
+}
+
+Event Parser::ReadValue() {
+    switch (Peek()) {
+        case '[':
+            ++pos_;
+            stack_.push_back(Container::ARRAY);
+            need_comma_ = false;
+            return Event::BEGIN_ARRAY;
+        case '{':
+            ++pos_;
+            stack_.push_back(Container::DICT);
+            need_comma_ = false;
+            return Event::BEGIN_DICT;
+        case '"':
+            ++pos_;
+            ReadString();
+            OnValueEnd();
+            return Event::STRING;
+        case 't':
+            ReadLiteral("true"sv);
+            bool_ = true;
+            return Event::BOOL;
+        case 'f':
+            ReadLiteral("false"sv);
+            bool_ = false;
+            return Event::BOOL;
+        case 'n':
+            ReadLiteral("null"sv);
+            return Event::NULL_VALUE;
+        default:
+            if (Peek() != '-' && (Peek() < '0' || Peek() > '9')) {
+                throw ParsingError("A value is expected but '"s + Peek() + "' has been found"s);
+            }
+            return ReadNumber();
+    }
+}
+
+void Parser::ReadString() {
+    // строка без escape-последовательностей остаётся ссылкой на вход
+    const size_t begin = pos_;
+    pos_ = string_scan::FindFirstOf<'"', '\\', '\n', '\r'>(input_, pos_);
+    while (pos_ == input_.size() && Refill()) {
+        pos_ = string_scan::FindFirstOf<'"', '\\', '\n', '\r'>(input_, pos_);
+    }
+    if (pos_ == input_.size()) {
+        throw ParsingError("String parsing error"s);
+    }
+    if (input_[pos_] == '"') {
+        string_ = input_.substr(begin, pos_ - begin);
+        ++pos_;
+        return;
+    }
+    if (input_[pos_] == '\\') {
+        ReadEscaped(begin);
+        return;
+    }
+    throw ParsingError("Unexpected end of line"s);
+}
+
+void Parser::ReadEscaped(size_t begin) {
+    unescaped_.assign(input_.substr(begin, pos_ - begin));
+    auto read_hex = [this]() {
+        if (!IsAvailable(pos_ + 4)) {
+            throw ParsingError("String parsing error"s);
+        }
+        unsigned code = 0;
+        const auto [end, error] = std::from_chars(input_.data() + pos_, input_.data() + pos_ + 4, code, 16);
+        if (error != std::errc{} || end != input_.data() + pos_ + 4) {
+            throw ParsingError("Invalid \\u escape sequence"s);
+        }
+        pos_ += 4;
+        return code;
+    };
+    while (true) {
+        // участок до следующего особого символа копируется целиком
+        const size_t special = string_scan::FindFirstOf<'"', '\\', '\n', '\r'>(input_, pos_);
+        unescaped_.append(input_.substr(pos_, special - pos_));
+        pos_ = special;
+        if (pos_ == input_.size()) {
+            if (Refill()) {
+                continue;
+            }
+            throw ParsingError("String parsing error"s);
+        }
+        const char ch = input_[pos_++];
+        if (ch == '"') {
+            break;
+        }
+        if (ch == '\n' || ch == '\r') {
+            throw ParsingError("Unexpected end of line"s);
+        }
+        if (!IsAvailable(pos_ + 1)) {
+            throw ParsingError("String parsing error"s);
+        }
+        const char escaped_char = input_[pos_++];
+        switch (escaped_char) {
+            case 'n':
+                unescaped_.push_back('\n');
+                break;
+            case 't':
+                unescaped_.push_back('\t');
+                break;
+            case 'r':
+                unescaped_.push_back('\r');
+                break;
+            case 'b':
+                unescaped_.push_back('\b');
+                break;
+            case 'f':
+                unescaped_.push_back('\f');
+                break;
+            case '"':
+            case '\\':
+            case '/':
+                unescaped_.push_back(escaped_char);
+                break;
+            case 'u': {
+                // символ UTF-16, вне базовой плоскости - суррогатной парой, пишется в UTF-8
+                unsigned code = read_hex();
+                if (code >= 0xD800 && code < 0xDC00 && IsAvailable(pos_ + 2) && input_.substr(pos_, 2) == "\\u"sv) {
+                    pos_ += 2;
+                    const unsigned low = read_hex();
+                    if (low < 0xDC00 || low >= 0xE000) {
+                        throw ParsingError("Invalid surrogate pair"s);
+                    }
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                }
+                if (code < 0x80) {
+                    unescaped_.push_back(static_cast<char>(code));
+                } else if (code < 0x800) {
+                    unescaped_.push_back(static_cast<char>(0xC0 | (code >> 6)));
+                    unescaped_.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+                } else if (code < 0x10000) {
+                    unescaped_.push_back(static_cast<char>(0xE0 | (code >> 12)));
+                    unescaped_.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+                    unescaped_.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+                } else {
+                    unescaped_.push_back(static_cast<char>(0xF0 | (code >> 18)));
+                    unescaped_.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+                    unescaped_.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+                    unescaped_.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+                }
+                break;
+            }
+            default:
+                throw ParsingError("Unrecognized escape sequence \\"s + escaped_char);
+        }
+    }
+    string_ = unescaped_;
+}
+
+Event Parser::ReadNumber() {
+    // лексема числа сначала дочитывается в окно целиком, дальше разбор идёт без проверок конца входа
+    size_t end = pos_;
+    do {
+        while (end < input_.size() && IsNumberChar(input_[end])) {
+            ++end;
+        }
+    } while (end == input_.size() && Refill());
+    const char* const first = input_.data() + pos_;
+    const char* const last = input_.data() + end;
+    const char* it = first;
+    auto read_digits = [&it, last]() {
+        if (it == last || *it < '0' || *it > '9') {
+            throw ParsingError("A digit is expected"s);
+        }
+        while (it != last && *it >= '0' && *it <= '9') {
+            ++it;
+        }
+    };
+
+    if (*it == '-') {
+        ++it;
+    }
+    // после 0 в JSON не могут идти другие цифры
+    if (it != last && *it == '0') {
+        ++it;
+    } else {
+        read_digits();
+    }
+    bool is_int = true;
+    if (it != last && *it == '.') {
+        ++it;
+        read_digits();
+        is_int = false;
+    }
+    if (it != last && (*it == 'e' || *it == 'E')) {
+        ++it;
+        if (it != last && (*it == '+' || *it == '-')) {
+            ++it;
+        }
+        read_digits();
+        is_int = false;
+    }
+    // остаток лексемы (например, второй знак) - уже не число
+    pos_ += it - first;
+    OnValueEnd();
+    // целое, не помещающееся в int, читается как double
+    if (is_int) {
+        if (const auto [number_end, error] = std::from_chars(first, it, int_); error == std::errc{} && number_end == it) {
+            double_ = int_;
+            return Event::INT;
+        }
+    }
+    if (const auto [number_end, error] = std::from_chars(first, it, double_); error != std::errc{} || number_end != it) {
+        throw ParsingError("Failed to convert "s + std::string(first, it) + " to number"s);
+    }
+    return Event::DOUBLE;
+}
+
+void Parser::ReadLiteral(std::string_view literal) {
+    // литерал продолжается до первой не-буквы, как и прежде
+    size_t end = pos_;
+    while (IsAvailable(end + 1) && std::isalpha(static_cast<unsigned char>(input_[end]))) {
+        ++end;
+    }
+    if (input_.substr(pos_, end - pos_) != literal) {
+        throw ParsingError("Failed to parse '"s + std::string(input_.substr(pos_, end - pos_)) + "' as "s
+                           + (literal == "null"sv ? "null"s : "bool"s));
+    }
+    pos_ = end;
+    OnValueEnd();
+}
+
+void Parser::OnValueEnd() {
+    need_comma_ = true;
+    if (stack_.empty()) {
+        is_root_read_ = true;
+    }
+}
+
+// ---------------NodeLoader---------------
+
+NodeLoader::NodeLoader(std::pmr::memory_resource* resource)
+        : resource_(resource) {
+}
+
+Node NodeLoader::Load(Parser& parser, Event event) {
+    switch (event) {
+        case Event::BEGIN_ARRAY: {
+            // вложенные значения копятся в том же буфере выше начала этого массива
+            const size_t begin = items_.size();
+            for (Event item = parser.Next(); item != Event::END_ARRAY; item = parser.Next()) {
+                Node value = Load(parser, item);
+                items_.push_back(std::move(value));
+            }
+            Array result(std::make_move_iterator(items_.begin() + begin), std::make_move_iterator(items_.end()), resource_);
+            items_.erase(items_.begin() + begin, items_.end());
+            return Node(std::move(result));
+        }
+        case Event::BEGIN_DICT: {
+            const size_t begin = members_.size();
+            for (Event item = parser.Next(); item != Event::END_DICT; item = parser.Next()) {
+                String key(parser.GetString(), resource_);
+                Node value = Load(parser, parser.Next());
+                members_.emplace_back(std::move(key), std::move(value));
+            }
+            const auto first = members_.begin() + begin;
+            std::sort(first, members_.end(), [](const Dict::value_type& lhs, const Dict::value_type& rhs) {
+                return lhs.first < rhs.first;
+            });
+            const auto duplicate = std::adjacent_find(first, members_.end(), [](const Dict::value_type& lhs, const Dict::value_type& rhs) {
+                return lhs.first == rhs.first;
+            });
+            if (duplicate != members_.end()) {
+                throw ParsingError("Duplicate key '"s + std::string(duplicate->first) + "' have been found");
+            }
+            Dict result(resource_);
+            result.items_.assign(std::make_move_iterator(first), std::make_move_iterator(members_.end()));
+            members_.erase(first, members_.end());
+            return Node(std::move(result));
+        }
+        case Event::STRING:
+            return Node(String(parser.GetString(), resource_));
+        case Event::INT:
+            return Node(parser.GetInt());
+        case Event::DOUBLE:
+            return Node(parser.GetDouble());
+        case Event::BOOL:
+            return Node(parser.GetBool());
+        case Event::NULL_VALUE:
+            return Node(nullptr);
+        default:
+            throw ParsingError("A value is expected"s);
+    }
+}
+
+Node LoadNode(Parser& parser, Event event, std::pmr::memory_resource* resource) {
+    return NodeLoader(resource).Load(parser, event);
+}
+
+std::string ReadInput(std::istream& input) {
+    constexpr std::streamsize CHUNK_SIZE = 1 << 16;
+    std::string buffer;
+    std::streambuf* const stream_buffer = input.rdbuf();
+    if (stream_buffer == nullptr) {
+        input.setstate(std::ios::badbit);
+        return buffer;
+    }
+    for (size_t size = 0;;) {
+        buffer.resize(size + CHUNK_SIZE);
+        const std::streamsize read_size = stream_buffer->sgetn(buffer.data() + size, CHUNK_SIZE);
+        size += static_cast<size_t>(read_size);
+        if (read_size < CHUNK_SIZE) {
+            buffer.resize(size);
+            break;
+        }
+    }
+    input.setstate(std::ios::eofbit);
+    return buffer;
+}
+
+
 // ---------------Document---------------
 
 Document::Document(Node root)
-        : root_(move(root)) {
+        : root_(std::move(root)) {
+}
+
+Document::Document(Node root, std::shared_ptr<std::pmr::monotonic_buffer_resource> arena)
+        : arena_(std::move(arena))
+        , root_(std::move(root)) {
 }
 
 const Node& Document::GetRoot() const {
     return root_;
 }
 
+Document Load(std::string_view input) {
+    Parser parser(input);
+    auto arena = std::make_shared<std::pmr::monotonic_buffer_resource>();
+    Node root = LoadNode(parser, parser.Next(), arena.get());
+    parser.Next();
+    return Document{std::move(root), std::move(arena)};
+}
+
 Document Load(std::istream& input) {
-    return Document{LoadNode(input)};
+    const std::string buffer = ReadInput(input);
+    return Load(buffer);
 }
 
 void Print(const Document& doc, std::ostream& output) {
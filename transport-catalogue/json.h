@@ -1,8 +1,13 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
-#include <map>
+#include <memory>
+#include <memory_resource>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 #include <variant>
 #include <stdexcept>
@@ -14,9 +19,55 @@ using namespace std::literals;
 
 // ---------------Node---------------
 
+/*
+ * Строки, массивы и словари узлов берут память из std::pmr::memory_resource. Документ, загруженный Load,
+ * размещает все узлы в своей монотонной арене и освобождает её разом; копия узла берёт память
+ * из ресурса по умолчанию (кучи) и от арены не зависит. Короткие строки хранятся внутри узла (SSO)
+ */
 class Node;
-using Dict = std::map<std::string, Node>;
-using Array = std::vector<Node>;
+using String = std::pmr::string;
+using Array = std::pmr::vector<Node>;
+
+// Словарь - отсортированный по ключам плоский массив пар: поиск двоичный, обход по алфавиту, как у std::map
+class Dict {
+public:
+    using value_type = std::pair<String, Node>;
+    using iterator = std::pmr::vector<value_type>::iterator;
+    using const_iterator = std::pmr::vector<value_type>::const_iterator;
+
+    Dict() = default;
+    explicit Dict(std::pmr::memory_resource* resource);
+
+    // Отсутствующий ключ - std::out_of_range
+    const Node& at(std::string_view key) const;
+    Node& at(std::string_view key);
+    const_iterator find(std::string_view key) const;
+    iterator find(std::string_view key);
+    size_t count(std::string_view key) const;
+    // Отсутствующий ключ добавляется со значением null
+    Node& operator[](std::string_view key);
+    // Ключ уже есть - словарь не меняется, second == false. Ключ из того же ресурса, что и словарь, не копируется
+    std::pair<iterator, bool> emplace(String key, Node value);
+
+    const_iterator begin() const;
+    const_iterator end() const;
+    iterator begin();
+    iterator end();
+    size_t size() const;
+    bool empty() const;
+
+    friend bool operator==(const Dict& lhs, const Dict& rhs);
+    friend bool operator!=(const Dict& lhs, const Dict& rhs);
+
+private:
+    // собирает пары, уже упорядоченные по ключам, прямо в items_
+    friend class NodeLoader;
+
+    std::pmr::vector<value_type> items_;
+
+    const_iterator LowerBound(std::string_view key) const;
+    iterator LowerBound(std::string_view key);
+};
 
 // Эта ошибка должна выбрасываться при ошибках парсинга JSON
 class ParsingError : public std::runtime_error {
@@ -25,13 +76,16 @@ public:
 };
 
 class Node final
-        : private std::variant<std::nullptr_t, Array, Dict, bool, int, double, std::string> {
+        : private std::variant<std::nullptr_t, Array, Dict, bool, int, double, String> {
 public:
     using variant::variant;
     using Value = variant;
 
     Node(Value value)
-    : Value(value) {
+    : Value(std::move(value)) {
+    }
+    Node(const std::string& value)
+    : Value(String(value)) {
     }
 
     bool IsInt() const;
@@ -46,7 +100,7 @@ public:
     int AsInt() const;
     bool AsBool() const;
     double AsDouble() const;
-    const std::string& AsString() const;
+    std::string_view AsString() const;
     const Array& AsArray() const;
     Array& AsArray();
     const Dict& AsDict() const;
@@ -64,13 +118,138 @@ bool operator!=(const Node& lhs, const Node& rhs);
 class Document {
 public:
     explicit Document(Node root);
+    // Документ, узлы которого размещены в арене arena
+    Document(Node root, std::shared_ptr<std::pmr::monotonic_buffer_resource> arena);
 
     const Node& GetRoot() const;
 
 private:
+    // арена объявлена первой: узлы корня разрушаются раньше неё
+    std::shared_ptr<std::pmr::monotonic_buffer_resource> arena_;
     Node root_;
 };
 
+// ---------------Parser---------------
+
+// События разбора: границы массивов и словарей, ключи словарей и значения
+enum class Event : std::uint8_t {
+    BEGIN_ARRAY,
+    END_ARRAY,
+    BEGIN_DICT,
+    END_DICT,
+    KEY,
+    NULL_VALUE,
+    BOOL,
+    INT,
+    DOUBLE,
+    STRING,
+    END_DOCUMENT
+};
+
+/*
+ * Потоковый (pull) разбор JSON из непрерывного буфера: Next() возвращает очередное событие, значение
+ * события - GetString/GetInt/GetDouble/GetBool. Строка без escape-последовательностей - ссылка на буфер,
+ * иначе на внутренний буфер разбора; ссылки действительны до следующего Next(). Буфер должен жить
+ * всё время разбора. После корневого значения допустимы только пробельные символы.
+ * Разбор из потока идёт по окну: прочитанное отбрасывается, окно дочитывается блоками по WINDOW_SIZE,
+ * так что память - O(WINDOW_SIZE + длина самой длинной лексемы), а не O(входа)
+ */
+class Parser {
+public:
+    static constexpr size_t WINDOW_SIZE = 1 << 16;
+
+    explicit Parser(std::string_view input);
+    // Поток должен жить всё время разбора
+    explicit Parser(std::istream& input);
+
+    Event Next();
+
+    // Ключ (KEY) или строка (STRING)
+    std::string_view GetString() const;
+    int GetInt() const;
+    // Число: DOUBLE или INT
+    double GetDouble() const;
+    bool GetBool() const;
+
+    // Пропускает значение, начатое событием event: у BEGIN_ARRAY и BEGIN_DICT - до парного конца
+    void SkipValue(Event event);
+
+private:
+    enum class Container : std::uint8_t { ARRAY, DICT };
+
+    std::string_view input_;
+    size_t pos_ = 0;
+    // при разборе из потока input_ - окно window_ над ним
+    std::istream* stream_ = nullptr;
+    std::string window_;
+    std::vector<Container> stack_;
+    // в текущем массиве или словаре уже есть элемент, следующему предшествует запятая
+    bool need_comma_ = false;
+    // прочитан ключ, следующее событие - его значение
+    bool is_after_key_ = false;
+    bool is_root_read_ = false;
+
+    std::string_view string_;
+    std::string unescaped_;
+    int int_ = 0;
+    double double_ = 0.0;
+    bool bool_ = false;
+
+    // Есть ли вход до позиции end; из потока окно при необходимости дочитывается
+    bool IsAvailable(size_t end);
+    bool Refill();
+    char Peek();
+    void SkipSpaces();
+    Event ReadValue();
+    void ReadString();
+    void ReadEscaped(size_t begin);
+    Event ReadNumber();
+    void ReadLiteral(std::string_view literal);
+    void OnValueEnd();
+};
+
+/*
+ * Строит из событий Parser деревья узлов с памятью из resource. Элементы массива и словаря копятся
+ * в своих буферах загрузчика, а в узел переносятся разом: память под них выделяется один раз точного размера,
+ * словарь сортируется один раз. Буферы переиспользуются от значения к значению
+ */
+class NodeLoader {
+public:
+    explicit NodeLoader(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    // Значение, начатое событием event
+    Node Load(Parser& parser, Event event);
+
+private:
+    std::pmr::memory_resource* resource_;
+    std::vector<Node> items_;
+    std::vector<Dict::value_type> members_;
+};
+
+// Значение, начатое событием event, деревом узлов с памятью из resource
+Node LoadNode(Parser& parser, Event event, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+// Обходит массив, начатый событием event: каждый элемент передаётся в on_item деревом узлов в арене,
+// которая опустошается после каждого элемента, так что память под узлы выделяется один раз на весь массив.
+// Узлы действительны только внутри on_item
+template <typename OnItem>
+void ForEachItem(Parser& parser, Event event, OnItem on_item) {
+    if (event != Event::BEGIN_ARRAY) {
+        throw ParsingError("An array is expected"s);
+    }
+    std::vector<std::byte> buffer(64 * 1024);
+    std::pmr::monotonic_buffer_resource arena(buffer.data(), buffer.size());
+    NodeLoader loader(&arena);
+    for (Event item = parser.Next(); item != Event::END_ARRAY; item = parser.Next()) {
+        on_item(loader.Load(parser, item));
+        arena.release();
+    }
+}
+
+// Вход целиком в память: разбор идёт по непрерывному буферу
+std::string ReadInput(std::istream& input);
+
+Document Load(std::string_view input);
 Document Load(std::istream& input);
 
 void Print(const Document& doc, std::ostream& output);
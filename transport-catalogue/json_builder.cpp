@@ -96,7 +96,7 @@ Builder::DictItemContext Builder::StartDict() {
             back_node->AsArray().emplace_back(Dict{});
             nodes_stack_.push_back(&back_node->AsArray().back());
         } else if (back_node->IsString()) { // последняя нода - ключ словаря
-            auto key = back_node->AsString();
+            const std::string key(back_node->AsString());
             nodes_stack_.pop_back();
             nodes_stack_.back()->AsDict().at(key) = Dict{};
             nodes_stack_.push_back(&(nodes_stack_.back()->AsDict().at(key)));
@@ -120,7 +120,7 @@ Builder::ArrayItemContext Builder::StartArray() {
             back_node->AsArray().emplace_back(Array{});
             nodes_stack_.push_back(&back_node->AsArray().back());
         } else if (back_node->IsString()) { // последняя нода - ключ словаря
-            auto key = back_node->AsString();
+            const std::string key(back_node->AsString());
             nodes_stack_.pop_back();
             nodes_stack_.back()->AsDict().at(key) = Array{};
             nodes_stack_.push_back(&(nodes_stack_.back()->AsDict().at(key)));
@@ -1,15 +1,94 @@
+#include <algorithm>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <cassert>
 #include <map>
+#include <set>
 
 #include "json_reader.h"
 
 namespace json_reader {
 
-JsonReader::JsonReader(std::istream& input, int cas)
-: document_(Load(input)) {
-    ParseDocument(cas);
+namespace {
+
+// Хеш узла JSON по его значению: FNV-1a по типу и содержимому каждого узла. Он не зависит от сборки
+// и от форматирования входного файла, так что хеши из прежней базы сравнимы с новыми
+class NodeHasher {
+public:
+    void Add(const Node& node) {
+        if (node.IsNull()) {
+            AddValue(Type::NULL_VALUE);
+        } else if (node.IsArray()) {
+            AddValue(Type::ARRAY);
+            AddValue(node.AsArray().size());
+            for (const auto& item : node.AsArray()) {
+                Add(item);
+            }
+        } else if (node.IsDict()) {
+            AddValue(Type::DICT);
+            AddValue(node.AsDict().size());
+            for (const auto& [key, value] : node.AsDict()) {
+                AddString(key);
+                Add(value);
+            }
+        } else if (node.IsBool()) {
+            AddValue(Type::BOOL);
+            AddValue(node.AsBool());
+        } else if (node.IsInt()) {
+            AddValue(Type::INT);
+            AddValue(node.AsInt());
+        } else if (node.IsPureDouble()) {
+            AddValue(Type::DOUBLE);
+            AddValue(node.AsDouble());
+        } else {
+            AddValue(Type::STRING);
+            AddString(node.AsString());
+        }
+    }
+
+    std::uint64_t Get() const {
+        return hash_;
+    }
+
+private:
+    enum class Type : std::uint8_t { NULL_VALUE, ARRAY, DICT, BOOL, INT, DOUBLE, STRING };
+
+    std::uint64_t hash_ = 14695981039346656037ULL;
+
+    void AddBytes(const void* data, size_t size) {
+        const auto* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            hash_ = (hash_ ^ bytes[i]) * 1099511628211ULL;
+        }
+    }
+    template <typename T>
+    void AddValue(T value) {
+        AddBytes(&value, sizeof(value));
+    }
+    void AddString(std::string_view value) {
+        AddValue(value.size());
+        AddBytes(value.data(), value.size());
+    }
+};
+
+}  // namespace
+
+JsonReader::JsonReader(std::istream& input, int cas) {
+    if (cas == 4) { // process_requests --stream: вход не копируется в память целиком
+        stream_parser_ = std::make_unique<Parser>(input);
+        ParseDocument(*stream_parser_, cas);
+        return;
+    }
+    const std::string buffer = ReadInput(input);
+    Parser parser(buffer);
+    ParseDocument(parser, cas);
+}
+
+JsonReader::JsonReader(std::string_view input, int cas)
+: input_(input) {
+    Parser parser(input);
+    ParseDocument(parser, cas);
 }
 
 const SourseStatRequests& JsonReader::GetRequestsStat() const {
@@ -20,76 +99,192 @@ Dict JsonReader::GetSerializationSettings() const {
     return serialization_settings_;
 }
 
+const std::vector<std::string>& JsonReader::GetStatRequestTypes() const {
+    return request_types_;
+}
+
+bool JsonReader::HasStatRequestTypes() const {
+    return !is_stat_requests_pending_;
+}
+
+const serialization::InputHashes& JsonReader::GetInputHashes() const {
+    return input_hashes_;
+}
+
 // ---------------Parsing JSON---------------
 
-void JsonReader::ParseDocument(int cas) {
+void JsonReader::ParseDocument(Parser& parser, int cas) {
+    // разделы разбираются по ходу чтения, ненужные режиму пропускаются без построения узлов
+    if (parser.Next() != Event::BEGIN_DICT) {
+        throw ParsingError("Requests should be a dictionary"s);
+    }
+    std::set<std::string, std::less<>> sections;
+    for (Event event = parser.Next(); event != Event::END_DICT; event = parser.Next()) {
+        const auto [section, is_new] = sections.emplace(parser.GetString());
+        if (!is_new) {
+            throw ParsingError("Duplicate key '"s + *section + "' have been found");
+        }
+        const std::string_view key = *section;
+        const Event value = parser.Next();
+        if (key == "serialization_settings"sv) {
+            serialization_settings_ = LoadNode(parser, value).AsDict();
+        } else if (key == "base_requests"sv && cas == 0) { // make_base
+            ParseBaseRequests(parser, value);
+        } else if (key == "base_requests"sv && cas == 2) { // make_delta
+            ParseDeltaRequests(parser, value);
+        } else if (key == "stat_requests"sv && cas == 1) { // process_requests
+            ParseStatRequests(parser, value);
+        } else if (key == "stat_requests"sv && cas == 4 && !input_.empty()) { // process_requests --stream
+            ScanStatRequests(parser, value);
+        } else if (key == "stat_requests"sv && cas == 4 && sections.count("serialization_settings"sv) == 0) {
+            ParseStatRequests(parser, value); // из потока, но настройки базы ещё впереди: запросы разбираются заранее
+        } else if (key == "stat_requests"sv && cas == 4) { // из потока: запросы читаются по ходу ответов
+            if (value != Event::BEGIN_ARRAY) {
+                throw ParsingError("An array of requests is expected"s);
+            }
+            is_stat_requests_pending_ = true;
+            return;
+        } else if (key == "routing_settings"sv && cas == 0) {
+            const Node routing_settings = LoadNode(parser, value);
+            NodeHasher routing_settings_hasher;
+            routing_settings_hasher.Add(routing_settings);
+            input_hashes_.routing_settings = routing_settings_hasher.Get();
+            routing_settings_ = routing_settings.AsDict();
+        } else if (key == "render_settings"sv && cas == 0) {
+            const Node render_settings = LoadNode(parser, value);
+            NodeHasher render_settings_hasher;
+            render_settings_hasher.Add(render_settings);
+            input_hashes_.render_settings = render_settings_hasher.Get();
+            render_settings_ = render_settings.AsDict();
+        } else {
+            parser.SkipValue(value);
+        }
+    }
+    parser.Next();
+
+    std::vector<std::string_view> required{"serialization_settings"sv};
     if (cas == 0) { // make_base
-        const Array& base = document_.GetRoot().AsDict().at("base_requests"s).AsArray();
-        routing_settings_ = document_.GetRoot().AsDict().at("routing_settings"s).AsDict();
-        render_settings_ = document_.GetRoot().AsDict().at("render_settings"s).AsDict();
-        serialization_settings_ = document_.GetRoot().AsDict().at("serialization_settings"s).AsDict();
-        ParseBaseRequests(base);
-    } else if (cas == 1) { // process_requests
-        const Array& stat = document_.GetRoot().AsDict().at("stat_requests"s).AsArray();
-        serialization_settings_ = document_.GetRoot().AsDict().at("serialization_settings"s).AsDict();
-        ParseStatRequests(stat);
+        required.insert(required.end(), {"base_requests"sv, "routing_settings"sv, "render_settings"sv});
+    } else if (cas == 1 || cas == 4) { // process_requests
+        required.push_back("stat_requests"sv);
+    } else if (cas == 2) { // make_delta
+        required.push_back("base_requests"sv);
+    }
+    for (const std::string_view section : required) {
+        if (sections.find(section) == sections.end()) {
+            throw ParsingError("Section '"s + std::string(section) + "' is missing"s);
+        }
     }
 }
 
-void JsonReader::ParseBaseRequests(const Array& base_requests) {
-    for (auto it = base_requests.begin(); it != base_requests.end(); ++it) {
-        const Dict& request = it->AsDict();
-        if (request.at("type"s) == "Stop"s) {
+void JsonReader::ParseBaseRequests(Parser& parser, Event base_requests) {
+    // остановки и автобусы хешируются раздельно: отчёт make_base называет изменившийся раздел
+    NodeHasher stops_hasher;
+    NodeHasher buses_hasher;
+    ForEachItem(parser, base_requests, [&](const Node& node) {
+        const Dict& request = node.AsDict();
+        if (request.at("type"s).AsString() == "Stop"sv) {
             ParseBaseStopRequests(request);
-        } else if (request.at("type"s) == "Bus"s) {
+            stops_hasher.Add(node);
+        } else if (request.at("type"s).AsString() == "Bus"sv) {
             ParseBaseBusRequests(request);
+            buses_hasher.Add(node);
         } else {
             assert(false);
         }
-    }
+    });
+    input_hashes_.stops = stops_hasher.Get();
+    input_hashes_.buses = buses_hasher.Get();
 }
 
-void JsonReader::ParseStatRequests(const Array& stat_requests) {
-    for (auto it = stat_requests.begin(); it != stat_requests.end(); ++it) {
-        const Dict& request = it->AsDict();
-        if (request.at("type"s) == "Stop"s) {
-            ParseStatStopRequests(request);
-        } else if (request.at("type"s) == "Bus"s) {
-            ParseStatBusRequests(request);
-        } else if (request.at("type") == "Map"s) {
-            ParseStatMapRequests(request);
-        } else if (request.at("type") == "Route"s) {
-            ParseStatRouteRequests(request);
-        }
-        else {
+void JsonReader::ParseDeltaRequests(Parser& parser, Event delta_requests) {
+    // запрос с "removed": true удаляет остановку или автобус по названию, остальные - как в make_base
+    ForEachItem(parser, delta_requests, [this](const Node& node) {
+        const Dict& request = node.AsDict();
+        const auto removed = request.find("removed"s);
+        const bool is_removed = removed != request.end() && removed->second.AsBool();
+        if (request.at("type"s).AsString() == "Stop"sv) {
+            if (is_removed) {
+                removed_stops_.emplace_back(request.at("name"s).AsString());
+            } else {
+                ParseBaseStopRequests(request);
+            }
+        } else if (request.at("type"s).AsString() == "Bus"sv) {
+            if (is_removed) {
+                removed_buses_.emplace_back(request.at("name"s).AsString());
+            } else {
+                ParseBaseBusRequests(request);
+            }
+        } else {
             assert(false);
         }
+    });
+}
+
+void JsonReader::ParseStatRequests(Parser& parser, Event stat_requests) {
+    ForEachItem(parser, stat_requests, [this](const Node& node) {
+        request_stat_.push_back(ParseStatRequest(node.AsDict()));
+        AddStatRequestType(request_stat_.back().at("type"s));
+    });
+}
+
+void JsonReader::ScanStatRequests(Parser& parser, Event stat_requests) {
+    // запросы здесь не разбираются, только собираются их типы: по ним выбираются нужные части базы
+    if (stat_requests != Event::BEGIN_ARRAY) {
+        throw ParsingError("An array of requests is expected"s);
+    }
+    for (Event item = parser.Next(); item != Event::END_ARRAY; item = parser.Next()) {
+        if (item != Event::BEGIN_DICT) {
+            throw ParsingError("A request should be a dictionary"s);
+        }
+        for (Event field = parser.Next(); field != Event::END_DICT; field = parser.Next()) {
+            const bool is_type = parser.GetString() == "type"sv;
+            const Event value = parser.Next();
+            if (is_type && value == Event::STRING) {
+                AddStatRequestType(parser.GetString());
+            }
+            parser.SkipValue(value);
+        }
+    }
+}
+
+void JsonReader::SkipRestOfDocument(Parser& parser) {
+    // разделы после stat_requests потоковому режиму не нужны
+    for (Event event = parser.Next(); event != Event::END_DICT; event = parser.Next()) {
+        parser.SkipValue(parser.Next());
+    }
+    parser.Next();
+}
+
+void JsonReader::AddStatRequestType(std::string_view type) {
+    if (std::find(request_types_.begin(), request_types_.end(), type) == request_types_.end()) {
+        request_types_.emplace_back(type);
     }
 }
 
 void JsonReader::ParseBaseStopRequests(const Dict& stop_request) {
-    std::string name = stop_request.at("name"s).AsString();
+    std::string name(stop_request.at("name"s).AsString());
     double latitude = stop_request.at("latitude"s).AsDouble();
     double longitude = stop_request.at("longitude"s).AsDouble();
     domain::Stop stop(std::move(name), latitude, longitude);
 
     std::map<std::string, int> distance_to_stop;
     for(const auto& [stop_, distance_] : stop_request.at("road_distances"s).AsDict()) {
-        distance_to_stop.insert({stop_, distance_.AsInt()});
+        distance_to_stop.emplace(stop_, distance_.AsInt());
     }
 
     request_stops_.push_back({std::move(stop), std::move(distance_to_stop)});
 }
 
 void JsonReader::ParseBaseBusRequests(const Dict& bus_request) {
-    std::string name = bus_request.at("name"s).AsString();
+    std::string name(bus_request.at("name"s).AsString());
     bool is_roundtrip = bus_request.at("is_roundtrip"s).AsBool();
 
     std::vector<std::string> bus;
     bus.push_back(std::move(name));
 
     for (const auto& stop : bus_request.at("stops"s).AsArray()) {
-        bus.push_back(stop.AsString());
+        bus.emplace_back(stop.AsString());
     }
 
     if (!is_roundtrip) {
@@ -101,200 +296,83 @@ void JsonReader::ParseBaseBusRequests(const Dict& bus_request) {
     request_buses_.push_back({std::move(bus), is_roundtrip});
 }
 
-void JsonReader::ParseStatStopRequests(const Dict& stop_request) {
+std::map<std::string, std::string> JsonReader::ParseStatRequest(const Dict& request) {
+    if (request.at("type"s).AsString() == "Stop"sv) {
+        return ParseStatStopRequests(request);
+    } else if (request.at("type"s).AsString() == "Bus"sv) {
+        return ParseStatBusRequests(request);
+    } else if (request.at("type"s).AsString() == "Map"sv) {
+        return ParseStatMapRequests(request);
+    } else if (request.at("type"s).AsString() == "Route"sv) {
+        return ParseStatRouteRequests(request);
+    }
+    throw std::invalid_argument("Unknown request type "s + std::string(request.at("type"s).AsString()));
+}
+
+std::map<std::string, std::string> JsonReader::ParseStatStopRequests(const Dict& stop_request) {
     std::map<std::string, std::string> request;
     request.insert({"id"s, std::to_string(stop_request.at("id"s).AsInt())});
     request.insert({"type"s, "Stop"s});
-    request.insert({"name"s, stop_request.at("name"s).AsString()});
+    request.emplace("name"s, stop_request.at("name"s).AsString());
 
-    request_stat_.push_back(std::move(request));
+    return request;
 }
 
-void JsonReader::ParseStatBusRequests(const Dict& bus_request) {
+std::map<std::string, std::string> JsonReader::ParseStatBusRequests(const Dict& bus_request) {
     std::map<std::string, std::string> request;
     request.insert({"id"s, std::to_string(bus_request.at("id"s).AsInt())});
     request.insert({"type"s, "Bus"s});
-    request.insert({"name"s, bus_request.at("name"s).AsString()});
+    request.emplace("name"s, bus_request.at("name"s).AsString());
 
-    request_stat_.push_back(std::move(request));
+    return request;
 }
 
-void JsonReader::ParseStatMapRequests(const Dict& map_request) {
+std::map<std::string, std::string> JsonReader::ParseStatMapRequests(const Dict& map_request) {
     std::map<std::string, std::string> request;
     request.insert({"id"s, std::to_string(map_request.at("id"s).AsInt())});
     request.insert({"type"s, "Map"s});
 
-    request_stat_.push_back(std::move(request));
+    return request;
 }
 
-void JsonReader::ParseStatRouteRequests(const Dict& route_request) {
+std::map<std::string, std::string> JsonReader::ParseStatRouteRequests(const Dict& route_request) {
     std::map<std::string, std::string> request;
     request.insert({"id"s, std::to_string(route_request.at("id"s).AsInt())});
     request.insert({"type"s, "Route"s});
-    request.insert({"from"s, route_request.at("from"s).AsString()});
-    request.insert({"to"s, route_request.at("to"s).AsString()});
+    request.emplace("from"s, route_request.at("from"s).AsString());
+    request.emplace("to"s, route_request.at("to"s).AsString());
+    // необязательные ограничение числа пересадок и запрос всех Парето-оптимальных вариантов
+    if (const auto it = route_request.find("max_transfers"s); it != route_request.end()) {
+        const int max_transfers = it->second.AsInt();
+        if (max_transfers < 0) {
+            throw ParsingError("max_transfers should be non-negative"s);
+        }
+        request.insert({"max_transfers"s, std::to_string(max_transfers)});
+    }
+    if (const auto it = route_request.find("pareto"s); it != route_request.end() && it->second.AsBool()) {
+        request.insert({"pareto"s, "true"s});
+    }
 
-    request_stat_.push_back(std::move(request));
+    return request;
 }
 
 
 // ---------------Creating Transport Catalogue---------------
 
 TransportCatalogue JsonReader::CreateTransportCatalogue() const {
-    Stops stops_to_tc;
-    PeekStops peek_stops_to_tc;
-    domain::DistanceBetweenStops distance_between_stops_to_tc;
-    CreateStops(stops_to_tc, peek_stops_to_tc, distance_between_stops_to_tc);
-
-    Buses buses_to_tc;
-    PeekBuses peek_buses_to_tc;
-    CreateBus(peek_stops_to_tc, buses_to_tc, peek_buses_to_tc);
-
-    StopBuses stop_buses_to_tc;
-    CreateStopBuses(buses_to_tc, stop_buses_to_tc, stops_to_tc);
-
-    return TransportCatalogue(std::move(stops_to_tc),
-                              std::move(peek_stops_to_tc),
-                              std::move(buses_to_tc),
-                              std::move(peek_buses_to_tc),
-                              std::move(stop_buses_to_tc),
-                              std::move(distance_between_stops_to_tc));
-}
-
-void JsonReader::AddPeekStop(const Stops::iterator pos, PeekStops& peek_stops) const {
-    peek_stops[pos->stop_name] = &(*pos);
-}
-
-void JsonReader::AddStop(const Stop& stop, Stops& stops, PeekStops& peek_stops) const {
-    AddPeekStop(stops.insert(stops.end(), stop), peek_stops);
-}
-
-void JsonReader::CreateStops(Stops& stops, PeekStops& peek_stops, domain::DistanceBetweenStops& distance_between_stops) const {
-    for (const auto& stop : request_stops_) {
-        AddStop(stop.first, stops, peek_stops);
-    }
-
-    for (const auto& stop : request_stops_) {
-        const std::string& stop_from = stop.first.stop_name;
-        Stop* stop_from_address = peek_stops.at(stop_from);
-
-        for (const auto& [stop_to, distance] : stop.second) {
-            Stop* stop_to_address = peek_stops.at(stop_to);
-            if (distance_between_stops.find({stop_to_address, stop_from_address}) != distance_between_stops.end()) {
-                distance_between_stops[{stop_from_address, stop_to_address}] = distance;
-                continue;
-            }
-            distance_between_stops[{stop_from_address, stop_to_address}] = distance;
-            distance_between_stops[{stop_to_address, stop_from_address}] = distance;
-        }
-    }
-}
-
-void JsonReader::AddPeekBus(const Buses::iterator pos, PeekBuses& peek_buses) const {
-    peek_buses[pos->bus_name] = &(*pos);
-}
-void JsonReader::AddBus(const std::string& name, std::vector<Stop*> stops, Buses& buses, PeekBuses& peek_buses, bool is_roundtrip) const {
-    Bus bus(name, std::move(stops));
-    bus.is_roundtrip = is_roundtrip;
-    AddPeekBus(buses.insert(buses.end(), std::move(bus)), peek_buses);
-}
-void JsonReader::CreateBus(const PeekStops& peek_stops, Buses& buses, PeekBuses& peek_buses) const {
-    for (const auto& bus_pair : request_buses_) {
-        const auto& bus = bus_pair.first;
-        const std::string& name = bus.at(0);
-        std::vector<Stop*> stops;
-        for (size_t i = 1; i < bus.size(); ++i) {
-            const std::string& stop = bus.at(i);
-            stops.push_back(peek_stops.at(stop));
-        }
-        bool is_roundtrip = bus_pair.second;
-        AddBus(name, std::move(stops), buses, peek_buses, is_roundtrip);
-    }
+    return TransportCatalogue(request_stops_, request_buses_);
 }
 
-void JsonReader::CreateStopBuses(Buses& buses, StopBuses& stop_buses, Stops& stops) const {
-    for (const Bus& bus : buses) {
-        for (const Stop* stop : bus.bus_stops) {
-            stop_buses[stop->stop_name].insert(bus.bus_name);
-        }
-    }
 
-    for (const Stop& stop : stops) {
-        if (stop_buses.find(stop.stop_name) != stop_buses.end()) {
-            continue;
-        }
-        stop_buses.insert({stop.stop_name, {}});
-    }
+TransportCatalogue::Delta JsonReader::CreateDelta() const {
+    return TransportCatalogue::Delta{request_stops_, request_buses_, removed_stops_, removed_buses_};
 }
 
 
 // ---------------Creating Map Renderer---------------
 
 MapRenderer JsonReader::CreateMapRenderer() const {
-    Stops stops_to_mr;
-    PeekStops peek_stops_to_mr;
-    CreateStopsMap(stops_to_mr, peek_stops_to_mr);
-
-    Buses buses_to_mr;
-    PeekBuses peek_buses_to_mr;
-    ActualBuses actual_buses_to_mr;
-    ActualCoordinates actual_coordinates_to_mr;
-    ActualStops actual_stops_to_mr;
-    CreateBusMap(peek_stops_to_mr, buses_to_mr, peek_buses_to_mr,
-                 actual_buses_to_mr, actual_coordinates_to_mr, actual_stops_to_mr);
-
-    return MapRenderer(render_settings_,
-                       std::move(stops_to_mr),
-                       std::move(peek_stops_to_mr),
-                       std::move(buses_to_mr),
-                       std::move(peek_buses_to_mr),
-                       std::move(actual_buses_to_mr),
-                       std::move(actual_coordinates_to_mr),
-                       std::move(actual_stops_to_mr));
-}
-
-void JsonReader::AddPeekStopMap(const Stops::iterator pos, PeekStops& peek_stops) const {
-    peek_stops[pos->stop_name] = &(*pos);
-}
-void JsonReader::AddStopMap(const Stop& stop, Stops& stops, PeekStops& peek_stops) const {
-    AddPeekStopMap(stops.insert(stops.end(), stop), peek_stops);
-}
-void JsonReader::CreateStopsMap(Stops& stops, PeekStops& peek_stops) const {
-    for (const auto& stop : request_stops_) {
-        AddStopMap(stop.first, stops, peek_stops);
-    }
-}
-
-void JsonReader::AddPeekBusMap(const Buses::iterator pos, PeekBuses& peek_buses) const {
-    peek_buses[pos->bus_name] = &(*pos);
-}
-void JsonReader::AddBusMap(const std::string& name, std::vector<Stop*> stops, Buses& buses, PeekBuses& peek_buses) const {
-    Bus bus(name, std::move(stops));
-    AddPeekBusMap(buses.insert(buses.end(), std::move(bus)), peek_buses);
-}
-void JsonReader::CreateBusMap(const PeekStops& peek_stops, Buses& buses, PeekBuses& peek_buses,
-                  ActualBuses& actual_buses, ActualCoordinates& actual_coordinates, ActualStops& actual_stops) const {
-    for (const auto& bus_pair : request_buses_) {
-        const auto& bus = bus_pair.first;
-        const std::string& name = bus.at(0);
-
-        std::vector<Stop*> stops;
-        for (size_t i = 1; i < bus.size(); ++i) {
-            const std::string& stop = bus.at(i);
-            stops.push_back(peek_stops.at(stop));
-        }
-
-        AddBusMap(name, std::move(stops), buses, peek_buses);
-        if (bus.size() > 1) {
-            const auto bus_pos = peek_buses.at(name);
-            actual_buses.insert({bus_pos->bus_name, bus_pair.second});
-            for (const auto stop : bus_pos->bus_stops) {
-                actual_coordinates.push_back(stop->stop_coordinates);
-                actual_stops.insert(stop->stop_name);
-            }
-        }
-
-    }
+    return MapRenderer(render_settings_);
 }
 
 // ---------------Creating Transport Router---------------
@@ -1,8 +1,10 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
+#include <memory>
 
 #include "json.h"
 #include "domain.h"
@@ -24,59 +26,97 @@ using namespace router;
 
 class JsonReader {
 public:
+    // В потоковом режиме process_requests (cas == 4) вход читается окном json::Parser: разбор останавливается
+    // на stat_requests, запросы читаются из потока по одному в ForEachStatRequest, input должен жить до конца обхода.
+    // Если serialization_settings идут после stat_requests, запросы приходится разобрать заранее
     JsonReader(std::istream& input, int cas);
+    // Вход в памяти. В потоковом режиме stat_requests только просматриваются,
+    // а разбираются по одному в ForEachStatRequest: input должен жить до конца обхода
+    JsonReader(std::string_view input, int cas);
     const SourseStatRequests& GetRequestsStat() const;
+    // Типы запросов stat_requests без повторов, в порядке появления
+    const std::vector<std::string>& GetStatRequestTypes() const;
+    // false, пока stat_requests не прочитаны из потока: их типы станут известны только при ответах
+    bool HasStatRequestTypes() const;
+    // Передаёт запросы stat_requests потокового режима в on_request по одному
+    template <typename OnRequest>
+    void ForEachStatRequest(OnRequest on_request);
     Dict GetSerializationSettings() const;
+    // Хеши разделов base_requests, routing_settings и render_settings (только для make_base)
+    const serialization::InputHashes& GetInputHashes() const;
 
     TransportCatalogue CreateTransportCatalogue() const;
     MapRenderer CreateMapRenderer() const;
     TransportRouter CreateTransportRouter(const TransportCatalogue& transport_catalogue) const;
+    // Изменение справочника из base_requests make_delta
+    TransportCatalogue::Delta CreateDelta() const;
 
 private:
     // Data from JSON
-    json::Document document_;
     SourceStopRequests request_stops_;
     SourceBusRequests request_buses_;
+    std::vector<std::string> removed_stops_;
+    std::vector<std::string> removed_buses_;
     SourseStatRequests request_stat_;
+    std::vector<std::string> request_types_;
+    std::string_view input_;
+    // разбор потока, остановленный перед элементами stat_requests
+    std::unique_ptr<Parser> stream_parser_;
+    bool is_stat_requests_pending_ = false;
     Dict render_settings_;
     Dict routing_settings_;
     Dict serialization_settings_;
+    serialization::InputHashes input_hashes_;
 
-    void ParseDocument(int cas);
-    void ParseBaseRequests(const Array& base_requests);
-    void ParseStatRequests(const Array& stat_requests);
+    void ParseDocument(Parser& parser, int cas);
+    void ParseBaseRequests(Parser& parser, Event base_requests);
+    void ParseDeltaRequests(Parser& parser, Event delta_requests);
+    void ParseStatRequests(Parser& parser, Event stat_requests);
+    void ScanStatRequests(Parser& parser, Event stat_requests);
+    void SkipRestOfDocument(Parser& parser);
+    void AddStatRequestType(std::string_view type);
 
     void ParseBaseStopRequests(const Dict& stop_request);
     void ParseBaseBusRequests(const Dict& bus_request);
 
-    void ParseStatStopRequests(const Dict& stop_request);
-    void ParseStatBusRequests(const Dict& bus_request);
-    void ParseStatMapRequests(const Dict& map_request);
-    void ParseStatRouteRequests(const Dict& route_request);
-
-
-    // For creating sources to Transport Catalogue
-    void AddPeekStop(const Stops::iterator pos, PeekStops& peek_stops) const;
-    void AddStop(const Stop& stop, Stops& stops, PeekStops& peek_stops) const;
-    void CreateStops(Stops& stops, PeekStops& peek_stops, domain::DistanceBetweenStops& distance_between_stops) const;
-
-    void AddPeekBus(const Buses::iterator pos, PeekBuses& peek_buses) const;
-    void AddBus(const std::string& name, std::vector<Stop*> stops, Buses& buses, PeekBuses& peek_buses, bool is_roundtrip) const;
-    void CreateBus(const PeekStops& peek_stops, Buses& buses, PeekBuses& peek_buses) const;
-
-    void CreateStopBuses(Buses& buses, StopBuses& stop_buses, Stops& stops) const;
-
-
-    // For creating sources to MapRenderer
-    void AddPeekStopMap(const Stops::iterator pos, PeekStops& peek_stops) const;
-    void AddStopMap(const Stop& stop, Stops& stops, PeekStops& peek_stops) const;
-    void CreateStopsMap(Stops& stops, PeekStops& peek_stops) const;
-
-    void AddPeekBusMap(const Buses::iterator pos, PeekBuses& peek_buses) const;
-    void AddBusMap(const std::string& name, std::vector<Stop*> stops, Buses& buses, PeekBuses& peek_buses) const;
-    void CreateBusMap(const PeekStops& peek_stops, Buses& buses, PeekBuses& peek_buses,
-                      ActualBuses& actual_buses, ActualCoordinates& actual_coordinates, ActualStops& actual_stops) const;
-
+    static std::map<std::string, std::string> ParseStatRequest(const Dict& request);
+    static std::map<std::string, std::string> ParseStatStopRequests(const Dict& stop_request);
+    static std::map<std::string, std::string> ParseStatBusRequests(const Dict& bus_request);
+    static std::map<std::string, std::string> ParseStatMapRequests(const Dict& map_request);
+    static std::map<std::string, std::string> ParseStatRouteRequests(const Dict& route_request);
 };
 
+template <typename OnRequest>
+void JsonReader::ForEachStatRequest(OnRequest on_request) {
+    auto parse_request = [&on_request](const Node& request) {
+        on_request(ParseStatRequest(request.AsDict()));
+    };
+    if (is_stat_requests_pending_) {
+        // ошибка во входе после stat_requests обнаружится уже после ответов на предшествующие запросы
+        is_stat_requests_pending_ = false;
+        json::ForEachItem(*stream_parser_, Event::BEGIN_ARRAY, parse_request);
+        SkipRestOfDocument(*stream_parser_);
+        return;
+    }
+    if (input_.empty()) { // запросы потока уже разобраны
+        for (const auto& request : request_stat_) {
+            on_request(request);
+        }
+        return;
+    }
+    // вход уже проверен при создании: здесь пропускаются разделы до stat_requests
+    Parser parser(input_);
+    parser.Next();
+    for (Event event = parser.Next(); event != Event::END_DICT; event = parser.Next()) {
+        const bool is_stat_requests = parser.GetString() == "stat_requests"sv;
+        const Event value = parser.Next();
+        if (!is_stat_requests) {
+            parser.SkipValue(value);
+            continue;
+        }
+        json::ForEachItem(parser, value, parse_request);
+        return;
+    }
+}
+
 }  // namespace json_reader
@@ -0,0 +1,202 @@
+#include "json_writer.h"
+#include "string_scan.h"
+
+#include <charconv>
+#include <stdexcept>
+
+namespace json {
+
+using namespace std::literals;
+
+// __________ BaseContext __________
+
+Writer::BaseContext::BaseContext(Writer& writer)
+: writer_(writer) {
+}
+Writer::DictValueContext Writer::BaseContext::Key(std::string_view key) {
+    return writer_.Key(key);
+}
+Writer::DictItemContext Writer::BaseContext::StartDict() {
+    return writer_.StartDict();
+}
+Writer::ArrayItemContext Writer::BaseContext::StartArray() {
+    return writer_.StartArray();
+}
+Writer& Writer::BaseContext::EndDict() {
+    return writer_.EndDict();
+}
+Writer& Writer::BaseContext::EndArray() {
+    return writer_.EndArray();
+}
+Writer& Writer::BaseContext::GetWriter() {
+    return writer_;
+}
+
+// __________ DictValueContext __________
+
+Writer::DictValueContext::DictValueContext(Writer& writer)
+: BaseContext(writer) {
+}
+
+// __________ DictItemContext __________
+
+Writer::DictItemContext::DictItemContext(Writer& writer)
+: BaseContext(writer) {
+}
+
+// __________ ArrayItemContext __________
+
+Writer::ArrayItemContext::ArrayItemContext(Writer& writer)
+: BaseContext(writer) {
+}
+
+// __________ Writer __________
+
+Writer::Writer(std::string& output)
+: output_(output) {
+}
+
+Writer::DictValueContext Writer::Key(std::string_view key) {
+    if (stack_.empty() || stack_.back() != Container::DICT || is_after_key_) {
+        throw std::logic_error("Try create \"Key\" without Dict.");
+    }
+    if (!is_first_item_) {
+        output_ += ",\n"sv;
+    }
+    is_first_item_ = false;
+    WriteIndent();
+    WriteString(key);
+    output_ += ": "sv;
+    is_after_key_ = true;
+    return DictValueContext{*this};
+}
+Writer& Writer::Value(std::nullptr_t) {
+    BeginValue();
+    output_ += "null"sv;
+    EndValue();
+    return *this;
+}
+Writer& Writer::Value(bool value) {
+    BeginValue();
+    output_ += value ? "true"sv : "false"sv;
+    EndValue();
+    return *this;
+}
+Writer& Writer::Value(int value) {
+    BeginValue();
+    char buffer[16];
+    const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    output_.append(buffer, result.ptr);
+    EndValue();
+    return *this;
+}
+Writer& Writer::Value(double value) {
+    BeginValue();
+    // как std::ostream по умолчанию: %g с 6 значащими цифрами
+    char buffer[32];
+    const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::general, 6);
+    output_.append(buffer, result.ptr);
+    EndValue();
+    return *this;
+}
+Writer& Writer::Value(std::string_view value) {
+    BeginValue();
+    WriteString(value);
+    EndValue();
+    return *this;
+}
+Writer& Writer::Value(const char* value) {
+    return Value(std::string_view(value));
+}
+Writer::DictItemContext Writer::StartDict() {
+    BeginValue();
+    output_ += "{\n"sv;
+    stack_.push_back(Container::DICT);
+    is_first_item_ = true;
+    return DictItemContext{*this};
+}
+Writer::ArrayItemContext Writer::StartArray() {
+    BeginValue();
+    output_ += "[\n"sv;
+    stack_.push_back(Container::ARRAY);
+    is_first_item_ = true;
+    return ArrayItemContext{*this};
+}
+Writer& Writer::EndDict() {
+    if (stack_.empty() || stack_.back() != Container::DICT || is_after_key_) {
+        throw std::logic_error("Dict can be End if Dict there is.");
+    }
+    stack_.pop_back();
+    output_ += '\n';
+    WriteIndent();
+    output_ += '}';
+    EndValue();
+    return *this;
+}
+Writer& Writer::EndArray() {
+    if (stack_.empty() || stack_.back() != Container::ARRAY) {
+        throw std::logic_error("Array can be End if Array there is.");
+    }
+    stack_.pop_back();
+    output_ += '\n';
+    WriteIndent();
+    output_ += ']';
+    EndValue();
+    return *this;
+}
+
+void Writer::BeginValue() {
+    if (stack_.empty()) { // JSON представляет из себя Value-объект
+        if (is_complete_) { // объект готов
+            throw std::logic_error("Try create \"Value\" for completed object.");
+        }
+    } else if (stack_.back() == Container::DICT) {
+        if (!is_after_key_) {
+            throw std::logic_error("Expected \"Key\" before a value in Dict.");
+        }
+        is_after_key_ = false;
+    } else {
+        if (!is_first_item_) {
+            output_ += ",\n"sv;
+        }
+        is_first_item_ = false;
+        WriteIndent();
+    }
+}
+void Writer::EndValue() {
+    is_first_item_ = false;
+    if (stack_.empty()) {
+        is_complete_ = true;
+    }
+}
+void Writer::WriteIndent() {
+    output_.append(stack_.size() * 4, ' ');
+}
+void Writer::WriteString(std::string_view value) {
+    output_ += '"';
+    for (size_t pos = 0; pos != value.size();) {
+        // участок без экранируемых символов копируется целиком
+        const size_t special = string_scan::FindFirstOf<'\r', '\n', '"', '\\'>(value, pos);
+        output_ += value.substr(pos, special - pos);
+        if (special == value.size()) {
+            break;
+        }
+        switch (value[special]) {
+            case '\r':
+                output_ += "\\r"sv;
+                break;
+            case '\n':
+                output_ += "\\n"sv;
+                break;
+            default:
+                // Символы " и \ выводятся как \" или \\, соответственно
+                output_ += '\\';
+                output_ += value[special];
+                break;
+        }
+        pos = special + 1;
+    }
+    output_ += '"';
+}
+
+} //  namespace json
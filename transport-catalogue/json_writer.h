@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace json {
+
+/*
+ * Запись JSON прямо в строку output, без дерева узлов. Вывод тот же, что у Print для такого же документа,
+ * только ключи словаря идут в порядке вызовов Key (Print выводит их по алфавиту). Контексты, как у Builder,
+ * не дают собрать неверную последовательность вызовов уже при компиляции. output можно опустошать между
+ * значениями, например выводя его в поток; буфер и стек вложенности сохраняют ёмкость, так что после
+ * первых ответов запись память не выделяет
+ */
+class Writer {
+public:
+    class BaseContext;
+    class DictValueContext;
+    class DictItemContext;
+    class ArrayItemContext;
+
+    explicit Writer(std::string& output);
+
+    DictValueContext Key(std::string_view key);
+    Writer& Value(std::nullptr_t);
+    Writer& Value(bool value);
+    Writer& Value(int value);
+    Writer& Value(double value);
+    Writer& Value(std::string_view value);
+    Writer& Value(const char* value);
+    DictItemContext StartDict();
+    ArrayItemContext StartArray();
+    Writer& EndDict();
+    Writer& EndArray();
+
+private:
+    enum class Container : std::uint8_t { ARRAY, DICT };
+
+    std::string& output_;
+    std::vector<Container> stack_;
+    // в текущем массиве или словаре ещё нет элементов
+    bool is_first_item_ = true;
+    // записан ключ, следующим должно быть его значение
+    bool is_after_key_ = false;
+    bool is_complete_ = false;
+
+    void BeginValue();
+    void EndValue();
+    void WriteIndent();
+    void WriteString(std::string_view value);
+};
+
+class Writer::BaseContext {
+public:
+    BaseContext(Writer& writer);
+
+    DictValueContext Key(std::string_view key);
+    DictItemContext StartDict();
+    ArrayItemContext StartArray();
+    Writer& EndDict();
+    Writer& EndArray();
+
+    Writer& GetWriter();
+
+private:
+    Writer& writer_;
+};
+
+class Writer::DictValueContext : public BaseContext {
+public:
+    DictValueContext(Writer& writer);
+
+    template <typename T>
+    DictItemContext Value(T value);
+    DictValueContext Key(std::string_view key) =delete;
+    Writer& EndDict() =delete;
+    Writer& EndArray() =delete;
+};
+
+class Writer::DictItemContext : public BaseContext {
+public:
+    DictItemContext(Writer& writer);
+
+    DictItemContext StartDict() =delete;
+    ArrayItemContext StartArray() =delete;
+    Writer& EndArray() =delete;
+};
+
+class Writer::ArrayItemContext : public BaseContext {
+public:
+    ArrayItemContext(Writer& writer);
+
+    template <typename T>
+    ArrayItemContext Value(T value);
+    DictValueContext Key(std::string_view key) =delete;
+    Writer& EndDict() =delete;
+};
+
+template <typename T>
+Writer::DictItemContext Writer::DictValueContext::Value(T value) {
+    GetWriter().Value(value);
+    return DictItemContext{GetWriter()};
+}
+
+template <typename T>
+Writer::ArrayItemContext Writer::ArrayItemContext::Value(T value) {
+    GetWriter().Value(value);
+    return ArrayItemContext{GetWriter()};
+}
+
+} //  namespace json
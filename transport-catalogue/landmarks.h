@@ -0,0 +1,583 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+#include "routes_table_repair.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+/*
+ * Ориентиры (landmarks) для поиска ALT: A*, ориентиры, неравенство треугольника.
+ * Для каждого ориентира l хранятся расстояния d(l, v) от него и d(v, l) до него для всех вершин.
+ * По неравенству треугольника d(v, t) >= max(d(v, l) - d(t, l), d(l, t) - d(l, v)) - нижняя оценка
+ * расстояния до цели, которая направляет поиск. Память - O(L * V) вместо O(V^2) у таблицы маршрутов
+ */
+template <typename Weight>
+class Landmarks {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    static_assert(std::numeric_limits<Weight>::has_infinity, "Weight should have an infinity value");
+    static constexpr Weight UNREACHABLE = std::numeric_limits<Weight>::infinity();
+
+    // Выбирает до landmark_count ориентиров методом наиболее удалённой вершины
+    Landmarks(const Graph& graph, size_t landmark_count);
+    // Готовые ориентиры: distances_from[i * V + v] = d(l_i, v), distances_to[i * V + v] = d(v, l_i)
+    Landmarks(size_t vertex_count, std::vector<VertexId> landmarks,
+              std::vector<Weight> distances_from, std::vector<Weight> distances_to);
+    // Ориентиры графа, полученного изменением base_graph (make_delta): ориентиры base остаются прежними,
+    // а их расстояния доводятся до нового графа только там, где изменение их затронуло.
+    // vertex_map - номера вершин base_graph в graph. Если вершина-ориентир удалена, ориентиры выбираются заново
+    Landmarks(const Graph& graph, const Graph& base_graph, const Landmarks& base,
+              const std::vector<VertexId>& vertex_map, size_t landmark_count);
+
+    size_t GetVertexCount() const;
+    const std::vector<VertexId>& GetLandmarks() const;
+    const std::vector<Weight>& GetDistancesFrom() const;
+    const std::vector<Weight>& GetDistancesTo() const;
+
+    // Нижняя оценка d(from, to) по ориентиру с номером landmark_index
+    Weight GetLowerBound(size_t landmark_index, VertexId from, VertexId to) const;
+
+private:
+    static constexpr Weight ZERO_WEIGHT{};
+
+    size_t vertex_count_ = 0;
+    std::vector<VertexId> landmarks_;
+    std::vector<Weight> distances_from_;
+    std::vector<Weight> distances_to_;
+
+    void Select(const Graph& graph, size_t landmark_count);
+};
+
+/*
+ * Входящие рёбра графа в CSR-виде: обратный поиск идёт по ним от вершины назначения
+ */
+template <typename Weight>
+class IncomingEdges {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+    using EdgesRange = ranges::Range<std::vector<EdgeId>::const_iterator>;
+
+public:
+    explicit IncomingEdges(const Graph& graph);
+
+    EdgesRange operator()(VertexId vertex) const {
+        return {edges_.begin() + offsets_.at(vertex), edges_.begin() + offsets_.at(vertex + 1)};
+    }
+
+private:
+    std::vector<size_t> offsets_;
+    std::vector<EdgeId> edges_;
+};
+
+// Дейкстра по всему графу: от вершины по исходящим рёбрам или к вершине по входящим
+template <typename Weight>
+void ComputeDistances(const DirectedWeightedGraph<Weight>& graph, const IncomingEdges<Weight>& incoming_edges,
+                      VertexId source, bool is_forward, Weight* distances) {
+    using QueueItem = std::pair<Weight, VertexId>;
+    std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+
+    std::fill(distances, distances + graph.GetVertexCount(), Landmarks<Weight>::UNREACHABLE);
+    distances[source] = Weight{};
+    queue.push({Weight{}, source});
+    auto relax = [&](VertexId next, Weight candidate) {
+        if (candidate < distances[next]) {
+            distances[next] = candidate;
+            queue.push({candidate, next});
+        }
+    };
+    while (!queue.empty()) {
+        const auto [weight, vertex] = queue.top();
+        queue.pop();
+        if (weight > distances[vertex]) {
+            continue;
+        }
+        if (is_forward) {
+            for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+                const auto edge = graph.GetEdge(edge_id);
+                relax(edge.to, weight + edge.weight);
+            }
+        } else {
+            for (const EdgeId edge_id : incoming_edges(vertex)) {
+                const auto edge = graph.GetEdge(edge_id);
+                relax(edge.from, weight + edge.weight);
+            }
+        }
+    }
+}
+
+// Доводит расстояния от вершины (is_forward) или до неё до нового графа, как table_repair::RepairRow:
+// у вершин broken - +inf, их кратчайшие пути потеряли рёбра. Их расстояния берутся по рёбрам
+// из остальных вершин, затем уменьшения от них и от новых рёбер new_edges распространяются по Дейкстре
+template <typename Weight>
+void RepairDistances(const DirectedWeightedGraph<Weight>& graph, const IncomingEdges<Weight>& incoming_edges,
+                     bool is_forward, const std::vector<EdgeId>& new_edges, const std::vector<VertexId>& broken,
+                     Weight* distances) {
+    using QueueItem = std::pair<Weight, VertexId>;
+    std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+
+    auto relax = [&](EdgeId edge_id) {
+        const auto edge = graph.GetEdge(edge_id);
+        const VertexId vertex = is_forward ? edge.from : edge.to;
+        const VertexId next = is_forward ? edge.to : edge.from;
+        const Weight candidate = distances[vertex] + edge.weight;
+        if (candidate < distances[next]) {
+            distances[next] = candidate;
+            queue.push({candidate, next});
+        }
+    };
+    // рёбра в вершину по направлению поиска и из неё
+    auto relax_edges = [&](VertexId vertex, bool is_outgoing) {
+        if (is_outgoing == is_forward) {
+            for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+                relax(edge_id);
+            }
+        } else {
+            for (const EdgeId edge_id : incoming_edges(vertex)) {
+                relax(edge_id);
+            }
+        }
+    };
+    for (const VertexId vertex : broken) {
+        relax_edges(vertex, false);
+    }
+    for (const EdgeId edge_id : new_edges) {
+        relax(edge_id);
+    }
+    while (!queue.empty()) {
+        const auto [weight, vertex] = queue.top();
+        queue.pop();
+        if (weight > distances[vertex]) {
+            continue;
+        }
+        relax_edges(vertex, true);
+    }
+}
+
+template <typename Weight>
+IncomingEdges<Weight>::IncomingEdges(const Graph& graph)
+    : offsets_(graph.GetVertexCount() + 1, 0)
+    , edges_(graph.GetEdgeCount()) {
+    for (const auto target : graph.GetTargets()) {
+        ++offsets_[target + 1];
+    }
+    for (size_t vertex = 0; vertex < graph.GetVertexCount(); ++vertex) {
+        offsets_[vertex + 1] += offsets_[vertex];
+    }
+    std::vector<size_t> positions(offsets_.begin(), offsets_.end() - 1);
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        edges_[positions[graph.GetTargets()[edge_id]]++] = edge_id;
+    }
+}
+
+template <typename Weight>
+Landmarks<Weight>::Landmarks(const Graph& graph, size_t landmark_count)
+    : vertex_count_(graph.GetVertexCount()) {
+    for (const Weight weight : graph.GetWeights()) {
+        if (weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+    }
+    Select(graph, landmark_count);
+}
+
+template <typename Weight>
+Landmarks<Weight>::Landmarks(size_t vertex_count, std::vector<VertexId> landmarks,
+                             std::vector<Weight> distances_from, std::vector<Weight> distances_to)
+    : vertex_count_(vertex_count)
+    , landmarks_(std::move(landmarks))
+    , distances_from_(std::move(distances_from))
+    , distances_to_(std::move(distances_to)) {
+    const size_t cell_count = landmarks_.size() * vertex_count_;
+    if (distances_from_.size() != cell_count || distances_to_.size() != cell_count) {
+        throw std::invalid_argument("Inconsistent landmark distance arrays");
+    }
+    for (const VertexId landmark : landmarks_) {
+        if (landmark >= vertex_count_) {
+            throw std::invalid_argument("Landmark is out of the graph");
+        }
+    }
+}
+
+template <typename Weight>
+Landmarks<Weight>::Landmarks(const Graph& graph, const Graph& base_graph, const Landmarks& base,
+                             const std::vector<VertexId>& vertex_map, size_t landmark_count)
+    : vertex_count_(graph.GetVertexCount()) {
+    if (base.vertex_count_ != base_graph.GetVertexCount() || vertex_map.size() != base.vertex_count_) {
+        throw std::invalid_argument("Landmarks are built for another graph");
+    }
+    for (const Weight weight : graph.GetWeights()) {
+        if (weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+    }
+    const bool is_landmark_removed = std::any_of(base.landmarks_.begin(), base.landmarks_.end(), [&](VertexId landmark) {
+        return vertex_map[landmark] == table_repair::REMOVED_VERTEX;
+    });
+    if (is_landmark_removed || base.landmarks_.empty()) {
+        Select(graph, landmark_count);
+        return;
+    }
+
+    // новые рёбра - не доставшиеся ни одному ребру прежнего графа
+    const std::vector<TableEdgeId> edge_map = table_repair::MapEdges(graph, base_graph, vertex_map);
+    std::vector<bool> is_kept_edge(graph.GetEdgeCount(), false);
+    for (const TableEdgeId edge_id : edge_map) {
+        if (edge_id != NO_EDGE) {
+            is_kept_edge[edge_id] = true;
+        }
+    }
+    std::vector<EdgeId> new_edges;
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        if (!is_kept_edge[edge_id]) {
+            new_edges.push_back(edge_id);
+        }
+    }
+
+    const IncomingEdges<Weight> incoming_edges(graph);
+    const IncomingEdges<Weight> base_incoming_edges(base_graph);
+    const size_t base_vertex_count = base.vertex_count_;
+    distances_from_.assign(base.landmarks_.size() * vertex_count_, UNREACHABLE);
+    distances_to_.assign(base.landmarks_.size() * vertex_count_, UNREACHABLE);
+    std::vector<bool> is_kept(base_vertex_count);
+    std::vector<VertexId> kept_queue;
+    std::vector<VertexId> broken;
+    for (size_t i = 0; i < base.landmarks_.size(); ++i) {
+        const VertexId base_landmark = base.landmarks_[i];
+        landmarks_.push_back(vertex_map[base_landmark]);
+        for (const bool is_forward : {true, false}) {
+            const Weight* base_distances = (is_forward ? base.distances_from_ : base.distances_to_).data() + i * base_vertex_count;
+            Weight* distances = (is_forward ? distances_from_ : distances_to_).data() + i * vertex_count_;
+
+            // расстояние сохраняется, если его даёт путь из оставшихся рёбер: обход от ориентира
+            // по рёбрам, на которых неравенство треугольника прежних расстояний обращается в равенство
+            std::fill(is_kept.begin(), is_kept.end(), false);
+            is_kept[base_landmark] = true;
+            kept_queue.assign(1, base_landmark);
+            for (size_t head = 0; head < kept_queue.size(); ++head) {
+                const VertexId vertex = kept_queue[head];
+                auto visit = [&](EdgeId edge_id) {
+                    const auto edge = base_graph.GetEdge(edge_id);
+                    const VertexId next = is_forward ? edge.to : edge.from;
+                    if (!is_kept[next] && edge_map[edge_id] != NO_EDGE
+                        && base_distances[vertex] + edge.weight == base_distances[next]) {
+                        is_kept[next] = true;
+                        kept_queue.push_back(next);
+                    }
+                };
+                if (is_forward) {
+                    for (const EdgeId edge_id : base_graph.GetIncidentEdges(vertex)) {
+                        visit(edge_id);
+                    }
+                } else {
+                    for (const EdgeId edge_id : base_incoming_edges(vertex)) {
+                        visit(edge_id);
+                    }
+                }
+            }
+
+            broken.clear();
+            for (VertexId vertex = 0; vertex < base_vertex_count; ++vertex) {
+                if (vertex_map[vertex] == table_repair::REMOVED_VERTEX || base_distances[vertex] == UNREACHABLE) {
+                    continue;
+                }
+                if (is_kept[vertex]) {
+                    distances[vertex_map[vertex]] = base_distances[vertex];
+                } else {
+                    broken.push_back(vertex_map[vertex]);
+                }
+            }
+            RepairDistances(graph, incoming_edges, is_forward, new_edges, broken, distances);
+        }
+    }
+}
+
+template <typename Weight>
+size_t Landmarks<Weight>::GetVertexCount() const {
+    return vertex_count_;
+}
+
+template <typename Weight>
+const std::vector<VertexId>& Landmarks<Weight>::GetLandmarks() const {
+    return landmarks_;
+}
+
+template <typename Weight>
+const std::vector<Weight>& Landmarks<Weight>::GetDistancesFrom() const {
+    return distances_from_;
+}
+
+template <typename Weight>
+const std::vector<Weight>& Landmarks<Weight>::GetDistancesTo() const {
+    return distances_to_;
+}
+
+template <typename Weight>
+Weight Landmarks<Weight>::GetLowerBound(size_t landmark_index, VertexId from, VertexId to) const {
+    const Weight* distances_from = distances_from_.data() + landmark_index * vertex_count_;
+    const Weight* distances_to = distances_to_.data() + landmark_index * vertex_count_;
+    Weight bound = ZERO_WEIGHT;
+    // недостижимость вычитаемого не даёт оценки; недостижимость уменьшаемого даёт +inf,
+    // и это верно: если to достигает l, а from - нет, то from не достигает и to
+    if (distances_to[to] != UNREACHABLE) {
+        bound = std::max(bound, distances_to[from] - distances_to[to]);
+    }
+    if (distances_from[from] != UNREACHABLE) {
+        bound = std::max(bound, distances_from[to] - distances_from[from]);
+    }
+    return bound;
+}
+
+template <typename Weight>
+void Landmarks<Weight>::Select(const Graph& graph, size_t landmark_count) {
+    if (vertex_count_ == 0) {
+        return;
+    }
+    const IncomingEdges<Weight> incoming_edges(graph);
+
+    // первый ориентир - самая удалённая вершина от вершины с наибольшим числом рёбер
+    VertexId start = 0;
+    for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+        if (graph.GetOffsets()[vertex + 1] - graph.GetOffsets()[vertex]
+            > graph.GetOffsets()[start + 1] - graph.GetOffsets()[start]) {
+            start = vertex;
+        }
+    }
+    std::vector<Weight> start_distances(vertex_count_);
+    ComputeDistances(graph, incoming_edges, start, true, start_distances.data());
+
+    // score[v] - сумма расстояний от ближайшего ориентира и до него; кандидаты - только вершины,
+    // связанные в обе стороны со всеми ориентирами: в другой компоненте ориентир бесполезен
+    std::vector<Weight> score(vertex_count_, UNREACHABLE);
+    for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+        if (start_distances[vertex] == UNREACHABLE) {
+            score[vertex] = -UNREACHABLE;
+        } else {
+            score[vertex] = start_distances[vertex];
+        }
+    }
+
+    landmark_count = std::min(landmark_count, vertex_count_);
+    for (size_t i = 0; i < landmark_count; ++i) {
+        const VertexId landmark = std::max_element(score.begin(), score.end()) - score.begin();
+        if (score[landmark] <= ZERO_WEIGHT) {
+            break; // все достижимые вершины уже ориентиры
+        }
+        landmarks_.push_back(landmark);
+        distances_from_.resize((i + 1) * vertex_count_);
+        distances_to_.resize((i + 1) * vertex_count_);
+        Weight* distances_from = distances_from_.data() + i * vertex_count_;
+        Weight* distances_to = distances_to_.data() + i * vertex_count_;
+        ComputeDistances(graph, incoming_edges, landmark, true, distances_from);
+        ComputeDistances(graph, incoming_edges, landmark, false, distances_to);
+
+        for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+            if (distances_from[vertex] == UNREACHABLE || distances_to[vertex] == UNREACHABLE) {
+                score[vertex] = -UNREACHABLE;
+            } else if (i == 0) {
+                score[vertex] = distances_from[vertex] + distances_to[vertex];
+            } else {
+                score[vertex] = std::min(score[vertex], distances_from[vertex] + distances_to[vertex]);
+            }
+        }
+    }
+}
+
+/*
+ * Двунаправленный поиск A* с оценками по ориентирам (ALT).
+ * Оба поиска используют усреднённый потенциал p(v) = (pi_to(v) - pi_from(v)) / 2, где pi_to - оценка
+ * расстояния до цели, pi_from - от начала. Приведённые веса рёбер w(u, v) - p(u) + p(v) неотрицательны
+ * и одинаковы для обоих поисков, поэтому работает обычный критерий остановки двунаправленной Дейкстры.
+ * Для запроса берутся ACTIVE_LANDMARKS ориентиров, дающих лучшую оценку d(from, to)
+ */
+template <typename Weight>
+class LandmarkRouter final : public RouteBuilder<Weight> {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using typename RouteBuilder<Weight>::RouteInfo;
+
+    LandmarkRouter(const Graph& graph, const Landmarks<Weight>& landmarks);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+
+private:
+    struct SearchLabel {
+        Weight weight; // настоящее расстояние, без потенциала
+        std::optional<EdgeId> prev_edge;
+    };
+    using SearchLabels = std::unordered_map<VertexId, SearchLabel>;
+
+    static constexpr size_t ACTIVE_LANDMARKS = 4;
+    static constexpr Weight ZERO_WEIGHT{};
+
+    const Graph& graph_;
+    const Landmarks<Weight>& landmarks_;
+    IncomingEdges<Weight> incoming_edges_;
+
+    std::vector<size_t> SelectActiveLandmarks(VertexId from, VertexId to) const;
+};
+
+template <typename Weight>
+LandmarkRouter<Weight>::LandmarkRouter(const Graph& graph, const Landmarks<Weight>& landmarks)
+    : graph_(graph)
+    , landmarks_(landmarks)
+    , incoming_edges_(graph) {
+    if (landmarks_.GetVertexCount() != graph_.GetVertexCount()) {
+        throw std::invalid_argument("Landmarks are built for another graph");
+    }
+}
+
+template <typename Weight>
+std::vector<size_t> LandmarkRouter<Weight>::SelectActiveLandmarks(VertexId from, VertexId to) const {
+    std::vector<std::pair<Weight, size_t>> bounds;
+    for (size_t i = 0; i < landmarks_.GetLandmarks().size(); ++i) {
+        bounds.push_back({landmarks_.GetLowerBound(i, from, to), i});
+    }
+    const size_t active_count = std::min(ACTIVE_LANDMARKS, bounds.size());
+    std::partial_sort(bounds.begin(), bounds.begin() + active_count, bounds.end(), std::greater<>{});
+
+    std::vector<size_t> active;
+    for (size_t i = 0; i < active_count; ++i) {
+        active.push_back(bounds[i].second);
+    }
+    return active;
+}
+
+template <typename Weight>
+std::optional<typename LandmarkRouter<Weight>::RouteInfo>
+LandmarkRouter<Weight>::BuildRoute(VertexId from, VertexId to) const {
+    using QueueItem = std::pair<Weight, VertexId>;
+    using Queue = std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>>;
+
+    if (from >= graph_.GetVertexCount() || to >= graph_.GetVertexCount()) {
+        throw std::out_of_range("Vertex is out of the graph");
+    }
+
+    const std::vector<size_t> active = SelectActiveLandmarks(from, to);
+    for (const size_t i : active) {
+        if (landmarks_.GetLowerBound(i, from, to) == Landmarks<Weight>::UNREACHABLE) {
+            return std::nullopt; // ориентир доказывает, что маршрута нет
+        }
+    }
+
+    // потенциал прямого поиска; обратный поиск использует -potential(v)
+    std::unordered_map<VertexId, Weight> potentials;
+    auto potential = [&](VertexId vertex) {
+        auto [it, inserted] = potentials.try_emplace(vertex, ZERO_WEIGHT);
+        if (inserted) {
+            Weight to_target = ZERO_WEIGHT;
+            Weight from_source = ZERO_WEIGHT;
+            for (const size_t i : active) {
+                to_target = std::max(to_target, landmarks_.GetLowerBound(i, vertex, to));
+                from_source = std::max(from_source, landmarks_.GetLowerBound(i, from, vertex));
+            }
+            // вершина, недостижимая из начала или не ведущая к цели, на маршрут не попадёт
+            it->second = to_target == Landmarks<Weight>::UNREACHABLE || from_source == Landmarks<Weight>::UNREACHABLE
+                         ? Landmarks<Weight>::UNREACHABLE
+                         : (to_target - from_source) / 2;
+        }
+        return it->second;
+    };
+
+    SearchLabels forward{{from, {ZERO_WEIGHT, std::nullopt}}};
+    SearchLabels backward{{to, {ZERO_WEIGHT, std::nullopt}}};
+    Queue forward_queue;
+    Queue backward_queue;
+    forward_queue.push({potential(from), from});
+    backward_queue.push({-potential(to), to});
+
+    std::optional<Weight> best_weight;
+    VertexId meeting_vertex = from;
+
+    auto update_best = [&](VertexId vertex, const SearchLabels& other) {
+        const auto other_it = other.find(vertex);
+        if (other_it == other.end()) {
+            return;
+        }
+        const Weight candidate = forward.at(vertex).weight + backward.at(vertex).weight;
+        if (!best_weight || candidate < *best_weight) {
+            best_weight = candidate;
+            meeting_vertex = vertex;
+        }
+    };
+
+    auto step = [&](Queue& queue, SearchLabels& labels, const SearchLabels& other, bool is_forward) {
+        const auto [key, vertex] = queue.top();
+        queue.pop();
+        const Weight weight = labels.at(vertex).weight;
+        const Weight vertex_potential = is_forward ? potential(vertex) : -potential(vertex);
+        if (key > weight + vertex_potential) { // устаревшая запись в очереди
+            return;
+        }
+        auto relax = [&](VertexId next, EdgeId edge_id, Weight edge_weight) {
+            const Weight next_potential = is_forward ? potential(next) : -potential(next);
+            if (next_potential == Landmarks<Weight>::UNREACHABLE || next_potential == -Landmarks<Weight>::UNREACHABLE) {
+                return;
+            }
+            const Weight candidate = weight + edge_weight;
+            auto [it, inserted] = labels.try_emplace(next, SearchLabel{candidate, edge_id});
+            if (inserted || candidate < it->second.weight) {
+                it->second = {candidate, edge_id};
+                queue.push({candidate + next_potential, next});
+                update_best(next, other);
+            }
+        };
+        if (is_forward) {
+            for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+                const auto edge = graph_.GetEdge(edge_id);
+                relax(edge.to, edge_id, edge.weight);
+            }
+        } else {
+            for (const EdgeId edge_id : incoming_edges_(vertex)) {
+                const auto edge = graph_.GetEdge(edge_id);
+                relax(edge.from, edge_id, edge.weight);
+            }
+        }
+    };
+
+    update_best(from, backward);
+    while (!forward_queue.empty() && !backward_queue.empty()) {
+        // сумма минимальных ключей - нижняя оценка любого ещё не найденного маршрута
+        if (best_weight && forward_queue.top().first + backward_queue.top().first >= *best_weight) {
+            break;
+        }
+        if (forward_queue.top().first <= backward_queue.top().first) {
+            step(forward_queue, forward, backward, true);
+        } else {
+            step(backward_queue, backward, forward, false);
+        }
+    }
+
+    if (!best_weight) {
+        return std::nullopt;
+    }
+
+    std::vector<EdgeId> edges;
+    for (auto edge_id = forward.at(meeting_vertex).prev_edge; edge_id;
+         edge_id = forward.at(graph_.GetEdge(*edge_id).from).prev_edge) {
+        edges.push_back(*edge_id);
+    }
+    std::reverse(edges.begin(), edges.end());
+    for (auto edge_id = backward.at(meeting_vertex).prev_edge; edge_id;
+         edge_id = backward.at(graph_.GetEdge(*edge_id).to).prev_edge) {
+        edges.push_back(*edge_id);
+    }
+
+    return RouteInfo{*best_weight, std::move(edges)};
+}
+
+}  // namespace graph
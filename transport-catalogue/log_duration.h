@@ -0,0 +1,50 @@
+#pragma once
+
+#include <chrono>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <utility>
+
+namespace timing {
+
+/*
+ * Замер длительности этапа: при разрушении выводит "<название>: <N> ms" в поток.
+ * Если поток не задан, ничего не выводит, так что замеры можно оставлять в коде
+ */
+class LogDuration {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    LogDuration(std::string name, std::ostream* stream)
+        : name_(std::move(name))
+        , stream_(stream) {
+    }
+
+    LogDuration(const LogDuration&) = delete;
+    LogDuration& operator=(const LogDuration&) = delete;
+
+    ~LogDuration() {
+        if (stream_ != nullptr) {
+            const auto duration = std::chrono::duration<double, std::milli>(Clock::now() - start_time_);
+            // строка выводится одной записью: замеры из разных потоков не перемешиваются
+            std::ostringstream line;
+            line << name_ << ": " << duration.count() << " ms\n";
+            *stream_ << line.str() << std::flush;
+        }
+    }
+
+private:
+    std::string name_;
+    std::ostream* stream_;
+    const Clock::time_point start_time_ = Clock::now();
+};
+
+// Выполняет func() с замером и возвращает её результат
+template <typename Func>
+auto Measure(std::string name, std::ostream* stream, Func func) {
+    LogDuration duration(std::move(name), stream);
+    return func();
+}
+
+}  // namespace timing
@@ -2,6 +2,8 @@
 #include <iostream>
 #include <string_view>
 #include <filesystem>
+#include <optional>
+#include <string>
 
 #include "json_reader.h"
 #include "transport_catalogue.h"
@@ -10,6 +12,8 @@
 #include "domain.h"
 #include "transport_router.h"
 #include "serialization.h"
+#include "log_duration.h"
+#include "thread_pool.h"
 
 using namespace json_reader;
 using namespace transport;
@@ -22,44 +26,239 @@ using namespace serialization;
 using namespace std::literals;
 
 void PrintUsage(std::ostream& stream = std::cerr) {
-    stream << "Usage: transport_catalogue [make_base|process_requests]\n"sv;
+    stream << "Usage: transport_catalogue [make_base|make_delta|compact|process_requests] [--timings]\n"sv
+           << "       transport_catalogue process_requests --stream [--timings]\n"sv;
 }
 
 int main(int argc, char* argv[]) {
-    if (argc != 2) {
+    if (argc < 2) {
         PrintUsage();
         return 1;
     }
-
     const std::string_view mode(argv[1]);
+    // с --timings длительность этапов выводится в stderr
+    std::ostream* timings = nullptr;
+    // с --stream process_requests отвечает на запросы по одному, не разбирая вход целиком
+    bool is_streaming = false;
+    for (int i = 2; i < argc; ++i) {
+        if (argv[i] == "--timings"sv && timings == nullptr) {
+            timings = &std::cerr;
+        } else if (argv[i] == "--stream"sv && mode == "process_requests"sv && !is_streaming) {
+            is_streaming = true;
+        } else {
+            PrintUsage();
+            return 1;
+        }
+    }
 
     if (mode == "make_base"sv) {
 
         // make base here
         int cas = 0;
+        timing::LogDuration total_duration("Total", timings);
+        JsonReader json_reader = timing::Measure("Reading base requests", timings, [&cas] {
+            return JsonReader(std::cin, cas);
+        });
+        const auto serialization_settings = json_reader.GetSerializationSettings();
+        const auto path = static_cast<std::filesystem::path>(serialization_settings.at("file"s).AsString());
+        DatabaseFormat format = DatabaseFormat::PROTOBUF;
+        if (const auto it = serialization_settings.find("format"s); it != serialization_settings.end()) {
+            format = ParseDatabaseFormat(it->second.AsString());
+        }
+        // по умолчанию части прежней базы, входные разделы которых не изменились, берутся из неё как есть
+        bool is_incremental = true;
+        if (const auto it = serialization_settings.find("incremental"s); it != serialization_settings.end()) {
+            is_incremental = it->second.AsBool();
+        }
+        TransportCatalogueExport transport_catalogue_export;
+        const InputHashes& input_hashes = json_reader.GetInputHashes();
+
+        DatabaseSections reused{false, false, false};
+        std::optional<TransportCatalogueExport::DesTransportCatalogue> previous;
+        if (const auto previous_hashes = is_incremental ? transport_catalogue_export.ReadInputHashes(path) : std::nullopt) {
+            reused = FindUnchangedSections(*previous_hashes, input_hashes);
+            try {
+                previous.emplace(timing::Measure("Reading previous database", timings, [&] {
+                    return transport_catalogue_export.Deserialize(path, reused, timings);
+                }));
+            } catch (const std::exception& e) {
+                std::cerr << "Previous database is not readable, rebuilding: "sv << e.what() << '\n';
+                reused = {false, false, false};
+            }
+        }
+
+        // независимые этапы выполняются параллельно: карта не зависит от справочника,
+        // а маршрутизатор строится дольше всех
+        concurrency::ThreadPool pool;
+        auto map_renderer_future = pool.Submit([&] {
+            if (reused.map_renderer) {
+                return std::move(previous->map_renderer);
+            }
+            return timing::Measure("Map renderer", timings, [&] {
+                return json_reader.CreateMapRenderer();
+            });
+        });
+        const TransportCatalogue transport_catalogue = reused.transport_catalogue
+            ? std::move(previous->transport_catalogue)
+            : timing::Measure("Transport catalogue", timings, [&] {
+                  return json_reader.CreateTransportCatalogue();
+              });
+        auto transport_router_future = pool.Submit([&] {
+            if (reused.transport_router) {
+                return std::move(previous->transport_router);
+            }
+            return timing::Measure("Transport router", timings, [&] {
+                return json_reader.CreateTransportRouter(transport_catalogue);
+            });
+        });
+        const MapRenderer map_renderer = map_renderer_future.get();
+
+        const TransportRouter transport_router = transport_router_future.get();
+        timing::Measure("Writing database", timings, [&] {
+            transport_catalogue_export.Serialize(path, transport_catalogue, map_renderer, transport_router, format, input_hashes);
+        });
+
+        // отчёт: какие части базы построены заново, а какие взяты из прежней
+        auto report = [](bool is_reused) {
+            return is_reused ? "reused"sv : "rebuilt"sv;
+        };
+        std::cerr << "Database sections: transport catalogue "sv << report(reused.transport_catalogue)
+                  << ", map renderer "sv << report(reused.map_renderer)
+                  << ", transport router "sv << report(reused.transport_router) << '\n';
+
+    } else if (mode == "make_delta"sv) {
+
+        // изменение базы "file" в файле "delta": остановки и автобусы из base_requests добавляются или заменяют
+        // прежние, запрос с "removed": true удаляет их. Изменение той же базы, уже лежащее в файле, дополняется
+        int cas = 2;
+        timing::LogDuration total_duration("Total", timings);
+        JsonReader json_reader = timing::Measure("Reading delta requests", timings, [&cas] {
+            return JsonReader(std::cin, cas);
+        });
+        const auto serialization_settings = json_reader.GetSerializationSettings();
+        const auto path = static_cast<std::filesystem::path>(serialization_settings.at("file"s).AsString());
+        const auto delta_path = static_cast<std::filesystem::path>(serialization_settings.at("delta"s).AsString());
+        TransportCatalogueExport transport_catalogue_export;
+        const auto base_hashes = transport_catalogue_export.ReadInputHashes(path);
+        if (!base_hashes) {
+            std::cerr << "Database has no input hashes, rebuild it with make_base: "sv << path.string() << '\n';
+            return 1;
+        }
+
+        DatabaseDelta delta{*base_hashes, json_reader.CreateDelta()};
+        std::error_code error;
+        if (std::filesystem::is_regular_file(delta_path, error)) {
+            DatabaseDelta previous = transport_catalogue_export.DeserializeDelta(delta_path);
+            if (previous.base_hashes == *base_hashes) {
+                previous.delta.Merge(std::move(delta.delta));
+                delta.delta = std::move(previous.delta);
+            } else {
+                std::cerr << "Previous delta was made for another database, replacing it\n"sv;
+            }
+        }
+        // изменение проверяется наложением на справочник базы
+        const auto base = timing::Measure("Reading database", timings, [&] {
+            return transport_catalogue_export.Deserialize(path, DatabaseSections{true, false, false}, timings);
+        });
+        try {
+            timing::Measure("Applying delta", timings, [&] {
+                return base.transport_catalogue.ApplyDelta(delta.delta);
+            });
+        } catch (const std::invalid_argument& e) {
+            std::cerr << "Delta does not apply to the database: "sv << e.what() << '\n';
+            return 1;
+        }
+        timing::Measure("Writing delta", timings, [&] {
+            transport_catalogue_export.SerializeDelta(delta_path, delta);
+        });
+        std::cerr << "Delta: "sv << delta.delta.stops.size() << " stops and "sv << delta.delta.buses.size()
+                  << " buses changed, "sv << delta.delta.removed_stops.size() << " stops and "sv
+                  << delta.delta.removed_buses.size() << " buses removed\n"sv;
+
+    } else if (mode == "compact"sv) {
+
+        // изменение "delta" сворачивается в базу "file": база пишется заново, файл изменения удаляется
+        int cas = 3;
+        timing::LogDuration total_duration("Total", timings);
         JsonReader json_reader(std::cin, cas);
-        TransportCatalogue transport_catalogue = json_reader.CreateTransportCatalogue();
-        MapRenderer map_renderer = json_reader.CreateMapRenderer();
-        TransportRouter transport_router = json_reader.CreateTransportRouter(transport_catalogue);
+        const auto serialization_settings = json_reader.GetSerializationSettings();
+        const auto path = static_cast<std::filesystem::path>(serialization_settings.at("file"s).AsString());
+        const auto delta_path = static_cast<std::filesystem::path>(serialization_settings.at("delta"s).AsString());
+        DatabaseFormat format = DatabaseFormat::PROTOBUF;
+        if (const auto it = serialization_settings.find("format"s); it != serialization_settings.end()) {
+            format = ParseDatabaseFormat(it->second.AsString());
+        }
         TransportCatalogueExport transport_catalogue_export;
-        const auto path = static_cast<std::filesystem::path>(json_reader.GetSerializationSettings().at("file"s).AsString());
-        transport_catalogue_export.Serialize(path, transport_catalogue, map_renderer, transport_router);
+        const DatabaseDelta delta = transport_catalogue_export.DeserializeDelta(delta_path);
+        const auto database = timing::Measure("Reading database", timings, [&] {
+            return transport_catalogue_export.Deserialize(path, delta_path, DatabaseSections{}, timings);
+        });
+        timing::Measure("Writing database", timings, [&] {
+            transport_catalogue_export.Serialize(path, database.transport_catalogue, database.map_renderer,
+                                                 database.transport_router, format,
+                                                 transport_catalogue_export.MakeCompactedInputHashes(delta));
+        });
+        std::filesystem::remove(delta_path);
 
     } else if (mode == "process_requests"sv) {
 
         // process requests here
-        int cas = 1;
-        JsonReader json_reader(std::cin, cas);
-        const auto path = static_cast<std::filesystem::path>(json_reader.GetSerializationSettings().at("file"s).AsString());
+        int cas = is_streaming ? 4 : 1;
+        timing::LogDuration total_duration("Total", timings);
+        // в потоковом режиме файл, перенаправленный в stdin, отображается в память, а не копируется;
+        // канал читается окном json::Parser, и stat_requests разбираются по ходу ответов
+        std::optional<MappedFile> mapped_input;
+        if (std::error_code error; is_streaming && std::filesystem::is_regular_file("/dev/stdin"s, error)) {
+            mapped_input.emplace("/dev/stdin"s);
+        } else if (is_streaming) {
+            // буфер std::cin без синхронизации со stdio отдаёт окну всё, что уже пришло по каналу
+            std::ios::sync_with_stdio(false);
+        }
+        JsonReader json_reader = timing::Measure("Reading requests", timings, [&] {
+            return mapped_input ? JsonReader(std::string_view(mapped_input->GetData(), mapped_input->GetSize()), cas)
+                                : JsonReader(std::cin, cas);
+        });
+        const auto serialization_settings = json_reader.GetSerializationSettings();
+        const auto path = static_cast<std::filesystem::path>(serialization_settings.at("file"s).AsString());
+        // изменение базы (make_delta) накладывается при загрузке, если его файл есть
+        std::optional<std::filesystem::path> delta_path;
+        if (const auto it = serialization_settings.find("delta"s); it != serialization_settings.end()) {
+            std::error_code error;
+            if (std::filesystem::is_regular_file(it->second.AsString(), error)) {
+                delta_path = it->second.AsString();
+            }
+        }
         TransportCatalogueExport transport_catalogue_import;
-        serialization::TransportCatalogueExport::DesTransportCatalogue TransportCatalogueImport = transport_catalogue_import.Deserialize(path);
+        // читаются только части базы, нужные запросам из stat_requests; запросы из канала заранее неизвестны
+        const DatabaseSections sections = json_reader.HasStatRequestTypes()
+            ? RequestHandler::GetRequiredSections(json_reader.GetStatRequestTypes())
+            : DatabaseSections{};
+        TransportCatalogueExport::DesTransportCatalogue TransportCatalogueImport = timing::Measure("Deserialization", timings, [&] {
+            return delta_path ? transport_catalogue_import.Deserialize(path, *delta_path, sections, timings)
+                              : transport_catalogue_import.Deserialize(path, sections, timings);
+        });
 
         RequestHandler request_handler(TransportCatalogueImport.transport_catalogue,
                                        TransportCatalogueImport.map_renderer,
-                                       TransportCatalogueImport.transport_router);
+                                       TransportCatalogueImport.transport_router,
+                                       timings);
 
-        json::Document document = request_handler.ProcessStatRequests(json_reader.GetRequestsStat());
-        Print(document, std::cout);
+        timing::LogDuration processing_duration("Processing requests", timings);
+        if (is_streaming) {
+            // ответ на запрос выводится сразу: память не растёт с числом запросов
+            std::string buffer;
+            json::Writer answers(buffer);
+            answers.StartArray();
+            json_reader.ForEachStatRequest([&](const std::map<std::string, std::string>& request) {
+                request_handler.ProcessStatRequest(request, answers);
+                std::cout << buffer;
+                buffer.clear();
+            });
+            answers.EndArray();
+            std::cout << buffer;
+        } else {
+            request_handler.ProcessStatRequests(json_reader.GetRequestsStat(), std::cout);
+        }
 
     } else {
         PrintUsage();
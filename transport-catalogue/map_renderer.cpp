@@ -2,6 +2,23 @@
 
 namespace map_renderer {
 
+namespace {
+
+// Цвет настроек: строка, [r, g, b] или [r, g, b, opacity]. Вариант сразу строится нужного типа: через
+// временный Rgb GCC с -O3 считал строку варианта неинициализированной (-Wmaybe-uninitialized)
+Color ParseColor(const Node& node) {
+    if (node.IsString()) {
+        return Color(std::in_place_type<std::string>, node.AsString());
+    }
+    const auto& color = node.AsArray();
+    if (color.size() == 3) {
+        return Color(std::in_place_type<Rgb>, color.at(0).AsInt(), color.at(1).AsInt(), color.at(2).AsInt());
+    }
+    return Color(std::in_place_type<Rgba>, color.at(0).AsInt(), color.at(1).AsInt(), color.at(2).AsInt(), color.at(3).AsDouble());
+}
+
+}  // namespace
+
 RenderSettings::RenderSettings() {}
 
 RenderSettings::RenderSettings(const Dict& source) {
@@ -21,29 +38,13 @@ RenderSettings::RenderSettings(const Dict& source) {
     const auto stop_lab_off = source.at("stop_label_offset"s).AsArray();
     stop_label_offset = {stop_lab_off[0].AsDouble(), stop_lab_off[1].AsDouble()};
 
-    if (source.at("underlayer_color"s).IsString()) {
-        underlayer_color = source.at("underlayer_color"s).AsString();
-    } else {
-        const auto color = source.at("underlayer_color"s).AsArray();
-        if (color.size() == 3) {
-            underlayer_color = Rgb(color.at(0).AsInt(), color.at(1).AsInt(), color.at(2).AsInt());
-        } else {
-            underlayer_color = Rgba(color.at(0).AsInt(), color.at(1).AsInt(), color.at(2).AsInt(), color.at(3).AsDouble());
-        }
-    }
+    underlayer_color = ParseColor(source.at("underlayer_color"s));
     underlayer_width = source.at("underlayer_width"s).AsDouble();
 
-    const auto colors = source.at("color_palette"s).AsArray();
+    const auto& colors = source.at("color_palette"s).AsArray();
+    color_palette.reserve(colors.size());
     for (const auto& color : colors) {
-        if (color.IsString()) {
-            color_palette.push_back(color.AsString());
-        } else {
-            if (color.AsArray().size() == 3) {
-                color_palette.push_back(Rgb(color.AsArray().at(0).AsInt(), color.AsArray().at(1).AsInt(), color.AsArray().at(2).AsInt()));
-            } else {
-                color_palette.push_back(Rgba(color.AsArray().at(0).AsInt(), color.AsArray().at(1).AsInt(), color.AsArray().at(2).AsInt(), color.AsArray().at(3).AsDouble()));
-            }
-        }
+        color_palette.push_back(ParseColor(color));
     }
 }
 
@@ -61,22 +62,13 @@ svg::Point SphereProjector::operator()(geo::Coordinates coords) const {
 
 // ---------------MapRoute---------------
 
-MapRoute::MapRoute(const ActualCoordinates& actual_coordinates,
-                   const RenderSettings& render_settings,
-                   const ActualBuses& actual_buses,
-                   const PeekBuses& peek_buses,
-                   const ActualStops& actual_stops,
-                   const PeekStops& peek_stops)
-                   : proj_(actual_coordinates.begin(),
-                           actual_coordinates.end(),
-                           render_settings.width,
-                           render_settings.height,
-                           render_settings.padding)
-                   , actual_buses_(actual_buses)
-                   , peek_buses_(peek_buses)
+MapRoute::MapRoute(const transport::TransportCatalogue& transport_catalogue,
+                   const RenderSettings& render_settings)
+                   : transport_catalogue_(transport_catalogue)
                    , render_settings_(render_settings)
-                   , actual_stops_(actual_stops)
-                   , peek_stops_(peek_stops) {
+                   , actual_buses_(CollectActualBuses())
+                   , actual_stops_(CollectActualStops())
+                   , proj_(MakeProjector()) {
     CreateLinesBuses();
     CreateNamesBuses();
     CreateCircleStops();
@@ -90,14 +82,55 @@ void MapRoute::Draw(svg::ObjectContainer& container) const {
     for (const auto& obj: names_stops_) container.Add(obj);
 }
 
+std::vector<transport::BusId> MapRoute::CollectActualBuses() const {
+    std::vector<transport::BusId> actual_buses;
+    for (transport::BusId bus = 0; bus < transport_catalogue_.GetCountBuses(); ++bus) {
+        const auto stops = transport_catalogue_.GetBusStops(bus);
+        if (stops.begin() != stops.end()) {
+            actual_buses.push_back(bus);
+        }
+    }
+    std::sort(actual_buses.begin(), actual_buses.end(), [this](transport::BusId lhs, transport::BusId rhs) {
+        return transport_catalogue_.GetBusName(lhs) < transport_catalogue_.GetBusName(rhs);
+    });
+    return actual_buses;
+}
+
+std::vector<transport::StopId> MapRoute::CollectActualStops() const {
+    std::vector<transport::StopId> actual_stops;
+    for (const transport::BusId bus : actual_buses_) {
+        for (const transport::StopId stop : transport_catalogue_.GetBusStops(bus)) {
+            actual_stops.push_back(stop);
+        }
+    }
+    std::sort(actual_stops.begin(), actual_stops.end());
+    actual_stops.erase(std::unique(actual_stops.begin(), actual_stops.end()), actual_stops.end());
+    std::sort(actual_stops.begin(), actual_stops.end(), [this](transport::StopId lhs, transport::StopId rhs) {
+        return transport_catalogue_.GetStopName(lhs) < transport_catalogue_.GetStopName(rhs);
+    });
+    return actual_stops;
+}
+
+SphereProjector MapRoute::MakeProjector() const {
+    // проекция зависит только от крайних точек, поэтому достаточно координат различных остановок
+    std::vector<geo::Coordinates> actual_coordinates;
+    actual_coordinates.reserve(actual_stops_.size());
+    for (const transport::StopId stop : actual_stops_) {
+        actual_coordinates.push_back(transport_catalogue_.GetStopCoordinates(stop));
+    }
+    return SphereProjector(actual_coordinates.begin(),
+                           actual_coordinates.end(),
+                           render_settings_.width,
+                           render_settings_.height,
+                           render_settings_.padding);
+}
+
 void MapRoute::CreateLinesBuses() {
     int num_color = 0;
-    for (const auto actual_bus : actual_buses_) {
-        const auto bus_ptr = peek_buses_.at(actual_bus.first);
-
+    for (const auto bus : actual_buses_) {
         Polyline lines_bus;
-        for (const auto stop : bus_ptr->bus_stops) {
-            const svg::Point screen_coord = proj_(stop->stop_coordinates);
+        for (const auto stop : transport_catalogue_.GetBusStops(bus)) {
+            const svg::Point screen_coord = proj_(transport_catalogue_.GetStopCoordinates(stop));
             lines_bus.AddPoint(std::move(screen_coord));
         }
 
@@ -115,11 +148,13 @@ void MapRoute::CreateLinesBuses() {
 
 void MapRoute::CreateNamesBuses() {
     int num_color = 0;
-    for (const auto actual_bus : actual_buses_) {
-        const auto bus_ptr = peek_buses_.at(actual_bus.first);
+    for (const auto bus : actual_buses_) {
+        const std::string bus_name(transport_catalogue_.GetBusName(bus));
+        const auto bus_stops = transport_catalogue_.GetBusStops(bus);
+        const auto first_stop = *bus_stops.begin();
         Text bg_name_bus_start;
-        bg_name_bus_start.SetData(bus_ptr->bus_name)
-                .SetPosition(proj_(bus_ptr->bus_stops.at(0)->stop_coordinates))
+        bg_name_bus_start.SetData(bus_name)
+                .SetPosition(proj_(transport_catalogue_.GetStopCoordinates(first_stop)))
                 .SetOffset({render_settings_.bus_label_offset.at(0), render_settings_.bus_label_offset.at(1)})
                 .SetFontSize(render_settings_.bus_label_font_size)
                 .SetFontFamily("Verdana"s)
@@ -132,8 +167,8 @@ void MapRoute::CreateNamesBuses() {
         names_buses_.push_back(std::move(bg_name_bus_start));
 
         Text name_bus_start;
-        name_bus_start.SetData(bus_ptr->bus_name)
-                .SetPosition(proj_(bus_ptr->bus_stops.at(0)->stop_coordinates))
+        name_bus_start.SetData(bus_name)
+                .SetPosition(proj_(transport_catalogue_.GetStopCoordinates(first_stop)))
                 .SetOffset({render_settings_.bus_label_offset.at(0), render_settings_.bus_label_offset.at(1)})
                 .SetFontSize(render_settings_.bus_label_font_size)
                 .SetFontFamily("Verdana"s)
@@ -141,12 +176,11 @@ void MapRoute::CreateNamesBuses() {
                 .SetFillColor(render_settings_.color_palette.at(num_color % render_settings_.color_palette.size()));
         names_buses_.push_back(std::move(name_bus_start));
 
-        const auto mid_bus = bus_ptr->bus_stops.size() / 2;
-        if (!actual_bus.second &&
-            bus_ptr->bus_stops.at(mid_bus) != bus_ptr->bus_stops.at(0)) {
+        const auto mid_stop = *(bus_stops.begin() + (bus_stops.end() - bus_stops.begin()) / 2);
+        if (!transport_catalogue_.IsRoundtrip(bus) && mid_stop != first_stop) {
             Text bg_name_bus_finish;
-            bg_name_bus_finish.SetData(bus_ptr->bus_name)
-                    .SetPosition(proj_(bus_ptr->bus_stops.at(mid_bus)->stop_coordinates))
+            bg_name_bus_finish.SetData(bus_name)
+                    .SetPosition(proj_(transport_catalogue_.GetStopCoordinates(mid_stop)))
                     .SetOffset({render_settings_.bus_label_offset.at(0), render_settings_.bus_label_offset.at(1)})
                     .SetFontSize(render_settings_.bus_label_font_size)
                     .SetFontFamily("Verdana"s)
@@ -159,8 +193,8 @@ void MapRoute::CreateNamesBuses() {
             names_buses_.push_back(std::move(bg_name_bus_finish));
 
             Text name_bus_finish;
-            name_bus_finish.SetData(bus_ptr->bus_name)
-                    .SetPosition(proj_(bus_ptr->bus_stops.at(mid_bus)->stop_coordinates))
+            name_bus_finish.SetData(bus_name)
+                    .SetPosition(proj_(transport_catalogue_.GetStopCoordinates(mid_stop)))
                     .SetOffset({render_settings_.bus_label_offset.at(0), render_settings_.bus_label_offset.at(1)})
                     .SetFontSize(render_settings_.bus_label_font_size)
                     .SetFontFamily("Verdana"s)
@@ -175,10 +209,8 @@ void MapRoute::CreateNamesBuses() {
 
 void MapRoute::CreateCircleStops() {
     for (const auto stop : actual_stops_) {
-        const auto stop_ptr = peek_stops_.at(stop);
-
         Circle circle_stop;
-        circle_stop.SetCenter(proj_(stop_ptr->stop_coordinates));
+        circle_stop.SetCenter(proj_(transport_catalogue_.GetStopCoordinates(stop)));
         circle_stop.SetRadius(render_settings_.stop_radius);
         circle_stop.SetFillColor("white"s);
         circle_stops_.push_back(std::move(circle_stop));
@@ -187,11 +219,12 @@ void MapRoute::CreateCircleStops() {
 
 void MapRoute::CreateNamesStops() {
     for (const auto stop : actual_stops_) {
-        const auto stop_ptr = peek_stops_.at(stop);
+        const std::string stop_name(transport_catalogue_.GetStopName(stop));
+        const geo::Coordinates stop_coordinates = transport_catalogue_.GetStopCoordinates(stop);
 
         Text bg_name_stop;
-        bg_name_stop.SetData(stop_ptr->stop_name)
-                .SetPosition(proj_(stop_ptr->stop_coordinates))
+        bg_name_stop.SetData(stop_name)
+                .SetPosition(proj_(stop_coordinates))
                 .SetOffset({render_settings_.stop_label_offset.at(0), render_settings_.stop_label_offset.at(1)})
                 .SetFontSize(render_settings_.stop_label_font_size)
                 .SetFontFamily("Verdana"s)
@@ -203,8 +236,8 @@ void MapRoute::CreateNamesStops() {
         names_stops_.push_back(std::move(bg_name_stop));
 
         Text name_stop;
-        name_stop.SetData(stop_ptr->stop_name)
-                .SetPosition(proj_(stop_ptr->stop_coordinates))
+        name_stop.SetData(stop_name)
+                .SetPosition(proj_(stop_coordinates))
                 .SetOffset({render_settings_.stop_label_offset.at(0), render_settings_.stop_label_offset.at(1)})
                 .SetFontSize(render_settings_.stop_label_font_size)
                 .SetFontFamily("Verdana"s)
@@ -218,55 +251,19 @@ void MapRoute::CreateNamesStops() {
 MapRenderer::MapRenderer() {
 }
 
-MapRenderer::MapRenderer(const Dict& render_settings,
-                         Stops stops,
-                         PeekStops peek_stops,
-                         Buses buses,
-                         PeekBuses peek_buses,
-                         ActualBuses actual_buses,
-                         ActualCoordinates actual_coordinates,
-                         ActualStops actual_stops)
-                         : render_settings_(RenderSettings(render_settings))
-                         , stops_(std::move(stops))
-                         , peek_stops_(std::move(peek_stops))
-                         , buses_(std::move(buses))
-                         , peek_buses_(std::move(peek_buses))
-                         , actual_buses_(std::move(actual_buses))
-                         , actual_coordinates_(std::move(actual_coordinates))
-                         , actual_stops_(std::move(actual_stops)) {
+MapRenderer::MapRenderer(const Dict& render_settings)
+: render_settings_(RenderSettings(render_settings)) {
 }
-MapRenderer::MapRenderer(const RenderSettings& render_settings,
-                         Stops stops,
-                         PeekStops peek_stops,
-                         Buses buses,
-                         PeekBuses peek_buses,
-                         ActualBuses actual_buses,
-                         ActualCoordinates actual_coordinates,
-                         ActualStops actual_stops)
-                         : render_settings_(render_settings)
-                         , stops_(std::move(stops))
-                         , peek_stops_(std::move(peek_stops))
-                         , buses_(std::move(buses))
-                         , peek_buses_(std::move(peek_buses))
-                         , actual_buses_(std::move(actual_buses))
-                         , actual_coordinates_(std::move(actual_coordinates))
-                         , actual_stops_(std::move(actual_stops)) {}
-
-
-MapRoute MapRenderer::Render() const {
-    return MapRoute(actual_coordinates_,
-                    render_settings_,
-                    actual_buses_,
-                    peek_buses_,
-                    actual_stops_,
-                    peek_stops_);
+MapRenderer::MapRenderer(const RenderSettings& render_settings)
+: render_settings_(render_settings) {
+}
+
+MapRoute MapRenderer::Render(const transport::TransportCatalogue& transport_catalogue) const {
+    return MapRoute(transport_catalogue, render_settings_);
 }
 
 const RenderSettings& MapRenderer::GetRenderSettings() const {
     return render_settings_;
 }
-const ActualCoordinates& MapRenderer::GetActualCoordinates() const {
-    return actual_coordinates_;
-}
 
 }  // namespace map_renderer
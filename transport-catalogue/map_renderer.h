@@ -18,6 +18,7 @@
 
 #include "geo.h"
 #include "domain.h"
+#include "transport_catalogue.h"
 #include "svg.h"
 #include "json.h"
 
@@ -73,29 +74,28 @@ private:
 
 class MapRoute : public svg::Drawable {
 public:
-
-    MapRoute(const ActualCoordinates& actual_coordinates,
-             const RenderSettings& render_settings,
-             const ActualBuses& actual_buses,
-             const PeekBuses& peek_buses,
-             const ActualStops& actual_stops,
-             const PeekStops& peek_stops);
+    // На карту попадают автобусы с непустым маршрутом и их остановки, упорядоченные по названию
+    MapRoute(const transport::TransportCatalogue& transport_catalogue,
+             const RenderSettings& render_settings);
 
     void Draw(svg::ObjectContainer& container) const override;
 
 private:
-    SphereProjector proj_;
-    ActualBuses actual_buses_;
-    PeekBuses peek_buses_;
+    const transport::TransportCatalogue& transport_catalogue_;
     RenderSettings render_settings_;
-    ActualStops actual_stops_;
-    PeekStops peek_stops_;
+    std::vector<transport::BusId> actual_buses_;
+    std::vector<transport::StopId> actual_stops_;
+    SphereProjector proj_;
 
     std::vector<Polyline> lines_buses_;
     std::vector<Text> names_buses_;
     std::vector<Circle> circle_stops_;
     std::vector<Text> names_stops_;
 
+    std::vector<transport::BusId> CollectActualBuses() const;
+    std::vector<transport::StopId> CollectActualStops() const;
+    SphereProjector MakeProjector() const;
+
     void CreateLinesBuses();
     void CreateNamesBuses();
     void CreateCircleStops();
@@ -106,39 +106,15 @@ private:
 class MapRenderer {
 public:
     MapRenderer();
+    MapRenderer(const Dict& render_settings);
+    MapRenderer(const RenderSettings& render_settings);
 
-    MapRenderer(const Dict& render_settings,
-                Stops stops,
-                PeekStops peek_stops,
-                Buses buses,
-                PeekBuses peek_buses,
-                ActualBuses actual_buses,
-                ActualCoordinates actual_coordinates,
-                ActualStops actual_stops);
-
-    MapRenderer(const RenderSettings& render_settings,
-                Stops stops,
-                PeekStops peek_stops,
-                Buses buses,
-                PeekBuses peek_buses,
-                ActualBuses actual_buses,
-                ActualCoordinates actual_coordinates,
-                ActualStops actual_stops);
-
-    MapRoute Render() const;
+    MapRoute Render(const transport::TransportCatalogue& transport_catalogue) const;
 
     const RenderSettings& GetRenderSettings() const;
-    const ActualCoordinates& GetActualCoordinates() const;
 
 private:
     RenderSettings render_settings_;
-    Stops stops_;
-    PeekStops peek_stops_;
-    Buses buses_;
-    PeekBuses peek_buses_;
-    ActualBuses actual_buses_;
-    ActualCoordinates actual_coordinates_;
-    ActualStops actual_stops_;
 
 };
 
@@ -0,0 +1,120 @@
+#include "mapped_file.h"
+
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define TRANSPORT_CATALOGUE_HAS_MMAP
+#endif
+
+namespace serialization {
+
+#ifdef TRANSPORT_CATALOGUE_HAS_MMAP
+
+MappedFile::MappedFile(const std::filesystem::path& path) {
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open database file: " + path.string());
+    }
+    struct stat file_stat {};
+    if (::fstat(fd, &file_stat) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Cannot stat database file: " + path.string());
+    }
+    size_ = static_cast<size_t>(file_stat.st_size);
+    if (size_ != 0) {
+        void* data = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+        if (data == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("Cannot map database file: " + path.string());
+        }
+        data_ = static_cast<char*>(data);
+        is_mapped_ = true;
+    }
+    ::close(fd); // отображение остаётся действительным и после закрытия дескриптора
+}
+
+MappedFile::~MappedFile() {
+    if (is_mapped_) {
+        ::munmap(data_, size_);
+    }
+}
+
+size_t MappedFile::GetPageSize() {
+    static const size_t page_size = [] {
+        const long size = ::sysconf(_SC_PAGESIZE);
+        return size > 0 ? static_cast<size_t>(size) : size_t{4096};
+    }();
+    return page_size;
+}
+
+namespace {
+
+// madvise принимает только адрес начала страницы: начало отображения выровнено на страницу,
+// так что смещение округляется вниз до неё
+void Advise(char* data, size_t offset, size_t size, int advice) {
+    const size_t page_offset = offset / MappedFile::GetPageSize() * MappedFile::GetPageSize();
+    ::madvise(data + page_offset, size + (offset - page_offset), advice);
+}
+
+}  // namespace
+
+void MappedFile::AdviseRandomAccess(size_t offset, size_t size) const {
+    if (is_mapped_ && offset + size <= size_) {
+        Advise(data_, offset, size, MADV_RANDOM);
+    }
+}
+
+void MappedFile::AdviseHugePages(size_t offset, size_t size) const {
+#ifdef MADV_HUGEPAGE
+    if (is_mapped_ && offset + size <= size_) {
+        Advise(data_, offset, size, MADV_HUGEPAGE);
+    }
+#else
+    (void)offset;
+    (void)size;
+#endif
+}
+
+#else
+
+MappedFile::MappedFile(const std::filesystem::path& path) {
+    std::ifstream in_file(path, std::ios::binary);
+    if (!in_file) {
+        throw std::runtime_error("Cannot open database file: " + path.string());
+    }
+    size_ = static_cast<size_t>(std::filesystem::file_size(path));
+    data_ = new char[size_ == 0 ? 1 : size_];
+    in_file.read(data_, static_cast<std::streamsize>(size_));
+}
+
+MappedFile::~MappedFile() {
+    delete[] data_;
+}
+
+size_t MappedFile::GetPageSize() {
+    return 4096;
+}
+
+void MappedFile::AdviseRandomAccess(size_t, size_t) const {
+}
+
+void MappedFile::AdviseHugePages(size_t, size_t) const {
+}
+
+#endif
+
+const char* MappedFile::GetData() const {
+    return data_;
+}
+
+size_t MappedFile::GetSize() const {
+    return size_;
+}
+
+}  // namespace serialization
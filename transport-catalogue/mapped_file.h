@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+
+namespace serialization {
+
+/*
+ * Файл, отображённый в память только для чтения. Страницы берутся из page cache и общие
+ * для всех процессов, открывших тот же файл. Там, где mmap недоступен, файл читается в память целиком
+ */
+class MappedFile {
+public:
+    explicit MappedFile(const std::filesystem::path& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* GetData() const;
+    size_t GetSize() const;
+
+    // Размер страницы памяти; там, где mmap недоступен, - 4 KiB
+    static size_t GetPageSize();
+
+    // Подсказки ядру для диапазона [offset, offset + size): чтение вразброс (без упреждающего чтения)
+    // и большие страницы. Начало диапазона округляется вниз до страницы. Это только подсказки: ошибки игнорируются
+    void AdviseRandomAccess(size_t offset, size_t size) const;
+    void AdviseHugePages(size_t offset, size_t size) const;
+
+private:
+    char* data_ = nullptr;
+    size_t size_ = 0;
+    bool is_mapped_ = false;
+};
+
+}  // namespace serialization
@@ -0,0 +1,256 @@
+#pragma once
+
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/message_lite.h>
+#include <google/protobuf/wire_format_lite.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "ranges.h"
+
+namespace serialization {
+
+/*
+ * Потоковые запись и чтение полей protobuf прямо из массивов и в массивы, без дерева сообщений.
+ * Упакованные поля справочника и графа пишутся из их памяти и читаются в std::vector, строки
+ * читаются ссылками на входной буфер (отображённый файл). На диске - обычные сообщения: их читает
+ * и сгенерированный код. Числовые массивы - std::uint32_t, std::int32_t, double или bool
+ */
+namespace proto_stream {
+
+using google::protobuf::io::CodedInputStream;
+using google::protobuf::io::CodedOutputStream;
+using google::protobuf::internal::WireFormatLite;
+
+/*
+ * Запись сообщения по полям. Длина вложенного сообщения пишется перед ним, поэтому поля
+ * вложенного сообщения обходятся дважды: Sink без выходного потока только считает их размер.
+ * Нулевые числа и пустые массивы не пишутся, как и в proto3
+ */
+class Sink {
+public:
+    explicit Sink(CodedOutputStream* out = nullptr)
+        : out_(out) {
+    }
+
+    size_t GetSize() const {
+        return size_;
+    }
+
+    void WriteVarint(int field, std::uint64_t value) {
+        if (value == 0) {
+            return;
+        }
+        size_ += CodedOutputStream::VarintSize32(WireFormatLite::MakeTag(field, WireFormatLite::WIRETYPE_VARINT))
+                 + CodedOutputStream::VarintSize64(value);
+        if (out_ != nullptr) {
+            out_->WriteTag(WireFormatLite::MakeTag(field, WireFormatLite::WIRETYPE_VARINT));
+            out_->WriteVarint64(value);
+        }
+    }
+
+    void WriteString(int field, std::string_view value) {
+        WriteHeader(field, value.size());
+        size_ += value.size();
+        if (out_ != nullptr) {
+            out_->WriteRaw(value.data(), static_cast<int>(value.size()));
+        }
+    }
+
+    void WriteMessage(int field, const google::protobuf::MessageLite& message) {
+        const size_t message_size = message.ByteSizeLong();
+        WriteHeader(field, message_size);
+        size_ += message_size;
+        if (out_ != nullptr) {
+            message.SerializeWithCachedSizes(out_);
+        }
+    }
+
+    // Вложенное сообщение, поля которого пишет write(Sink&)
+    template <typename Write>
+    void WriteNested(int field, Write write) {
+        Sink counter;
+        write(counter);
+        WriteHeader(field, counter.GetSize());
+        size_ += counter.GetSize();
+        if (out_ != nullptr) {
+            Sink writer(out_);
+            write(writer);
+        }
+    }
+
+    // Упакованное поле из count значений get(i)
+    template <typename T, typename Get>
+    void WritePacked(int field, size_t count, Get get) {
+        if (count == 0) {
+            return;
+        }
+        size_t data_size = 0;
+        if constexpr (std::is_same_v<T, double>) {
+            data_size = count * sizeof(double);
+        } else if constexpr (std::is_same_v<T, bool>) {
+            data_size = count;
+        } else {
+            for (size_t i = 0; i < count; ++i) {
+                data_size += ValueSize<T>(static_cast<T>(get(i)));
+            }
+        }
+        WriteHeader(field, data_size);
+        size_ += data_size;
+        if (out_ == nullptr) {
+            return;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            const T value = static_cast<T>(get(i));
+            if constexpr (std::is_same_v<T, double>) {
+                std::uint64_t bits;
+                std::memcpy(&bits, &value, sizeof(bits));
+                out_->WriteLittleEndian64(bits);
+            } else if constexpr (std::is_same_v<T, std::int32_t>) {
+                out_->WriteVarint32SignExtended(value);
+            } else {
+                out_->WriteVarint32(static_cast<std::uint32_t>(value));
+            }
+        }
+    }
+
+    template <typename T>
+    void WritePacked(int field, ranges::Span<T> values) {
+        WritePacked<T>(field, values.size(), [values](size_t i) {
+            return values[i];
+        });
+    }
+
+private:
+    CodedOutputStream* out_;
+    size_t size_ = 0;
+
+    template <typename T>
+    static size_t ValueSize(T value) {
+        if constexpr (std::is_same_v<T, std::int32_t>) {
+            return CodedOutputStream::VarintSize32SignExtended(value);
+        } else {
+            return CodedOutputStream::VarintSize32(static_cast<std::uint32_t>(value));
+        }
+    }
+
+    void WriteHeader(int field, size_t length) {
+        const std::uint32_t tag = WireFormatLite::MakeTag(field, WireFormatLite::WIRETYPE_LENGTH_DELIMITED);
+        size_ += CodedOutputStream::VarintSize32(tag) + CodedOutputStream::VarintSize64(length);
+        if (out_ != nullptr) {
+            out_->WriteTag(tag);
+            out_->WriteVarint64(length);
+        }
+    }
+};
+
+// Дописывает в values значения числового поля с тегом tag, упакованного или нет. false - повреждённые данные
+template <typename T, typename Value>
+bool ReadRepeated(CodedInputStream& input, std::uint32_t tag, std::vector<Value>& values) {
+    auto read_value = [&input, &values]() {
+        if constexpr (std::is_same_v<T, double>) {
+            std::uint64_t bits;
+            if (!input.ReadLittleEndian64(&bits)) {
+                return false;
+            }
+            double value;
+            std::memcpy(&value, &bits, sizeof(value));
+            values.push_back(static_cast<Value>(value));
+        } else {
+            std::uint64_t value;
+            if (!input.ReadVarint64(&value)) {
+                return false;
+            }
+            if constexpr (std::is_same_v<T, bool>) {
+                values.push_back(static_cast<Value>(value != 0));
+            } else {
+                values.push_back(static_cast<Value>(static_cast<T>(value)));
+            }
+        }
+        return true;
+    };
+
+    if (WireFormatLite::GetTagWireType(tag) != WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
+        const auto wire_type = std::is_same_v<T, double> ? WireFormatLite::WIRETYPE_FIXED64 : WireFormatLite::WIRETYPE_VARINT;
+        return WireFormatLite::GetTagWireType(tag) == wire_type && read_value();
+    }
+    std::uint32_t length;
+    if (!input.ReadVarint32(&length)) {
+        return false;
+    }
+    // число значений известно заранее: у double по длине, у varint - по числу последних байтов значений
+    const void* data;
+    int size;
+    if constexpr (std::is_same_v<T, double>) {
+        values.reserve(values.size() + length / sizeof(double));
+    } else if (input.GetDirectBufferPointer(&data, &size) && static_cast<std::uint32_t>(size) >= length) {
+        const auto* bytes = static_cast<const std::uint8_t*>(data);
+        values.reserve(values.size() + std::count_if(bytes, bytes + length, [](std::uint8_t byte) {
+            return byte < 0x80;
+        }));
+    }
+    const auto limit = input.PushLimit(static_cast<int>(length));
+    while (input.BytesUntilLimit() > 0) {
+        if (!read_value()) {
+            return false;
+        }
+    }
+    input.PopLimit(limit);
+    return true;
+}
+
+// Строка поля с длиной - ссылкой на входной буфер; вход должен быть массивом в памяти
+inline bool ReadStringView(CodedInputStream& input, std::string_view& value) {
+    std::uint32_t length;
+    const void* data;
+    int size;
+    if (!input.ReadVarint32(&length)) {
+        return false;
+    }
+    if (length == 0) {
+        value = {};
+        return true;
+    }
+    if (!input.GetDirectBufferPointer(&data, &size) || static_cast<std::uint32_t>(size) < length) {
+        return false;
+    }
+    value = {static_cast<const char*>(data), length};
+    return input.Skip(static_cast<int>(length));
+}
+
+// Обходит поля сообщения в пределах входа или текущего ограничения: on_field(field_number, tag)
+// читает поле и возвращает false при ошибке. Сам обход возвращает false, если данные повреждены
+template <typename OnField>
+bool ReadFields(CodedInputStream& input, OnField on_field) {
+    while (true) {
+        const std::uint32_t tag = input.ReadTag();
+        if (tag == 0) {
+            return input.ConsumedEntireMessage() || input.BytesUntilLimit() == 0;
+        }
+        if (!on_field(WireFormatLite::GetTagFieldNumber(tag), tag)) {
+            return false;
+        }
+    }
+}
+
+// Вложенное сообщение: поля в пределах его длины обходит ReadFields
+template <typename OnField>
+bool ReadNested(CodedInputStream& input, OnField on_field) {
+    std::uint32_t length;
+    if (!input.ReadVarint32(&length)) {
+        return false;
+    }
+    const auto limit = input.PushLimit(static_cast<int>(length));
+    const bool is_read = ReadFields(input, on_field);
+    input.PopLimit(limit);
+    return is_read;
+}
+
+}  // namespace proto_stream
+
+}  // namespace serialization
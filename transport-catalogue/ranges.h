@@ -1,9 +1,12 @@
 #pragma once
 
+#include <cstddef>
 #include <iterator>
+#include <stdexcept>
 #include <string_view>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 namespace ranges {
 
@@ -33,4 +36,96 @@ auto AsRange(const C& container) {
     return Range{container.begin(), container.end()};
 }
 
+// Итератор по последовательным целым числам: диапазон номеров без хранения самих номеров
+template <typename Index>
+class IndexIterator {
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Index;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const Index*;
+    using reference = Index;
+
+    explicit IndexIterator(Index index)
+        : index_(index) {
+    }
+
+    Index operator*() const {
+        return index_;
+    }
+    IndexIterator& operator++() {
+        ++index_;
+        return *this;
+    }
+    IndexIterator operator++(int) {
+        IndexIterator prev = *this;
+        ++index_;
+        return prev;
+    }
+    bool operator==(const IndexIterator& other) const {
+        return index_ == other.index_;
+    }
+    bool operator!=(const IndexIterator& other) const {
+        return index_ != other.index_;
+    }
+
+private:
+    Index index_;
+};
+
+template <typename Index>
+auto AsIndexRange(Index begin, Index end) {
+    return Range{IndexIterator<Index>(begin), IndexIterator<Index>(end)};
+}
+
+// Непрерывный массив без владения: данные своего вектора или внешняя память (например, отображённый файл)
+template <typename T>
+class Span {
+public:
+    Span() = default;
+    Span(const T* data, size_t size)
+        : data_(data)
+        , size_(size) {
+    }
+    Span(const std::vector<T>& vector)
+        : data_(vector.data())
+        , size_(vector.size()) {
+    }
+
+    const T* begin() const {
+        return data_;
+    }
+    const T* end() const {
+        return data_ + size_;
+    }
+    const T* data() const {
+        return data_;
+    }
+    size_t size() const {
+        return size_;
+    }
+    bool empty() const {
+        return size_ == 0;
+    }
+    const T& front() const {
+        return data_[0];
+    }
+    const T& back() const {
+        return data_[size_ - 1];
+    }
+    const T& operator[](size_t index) const {
+        return data_[index];
+    }
+    const T& at(size_t index) const {
+        if (index >= size_) {
+            throw std::out_of_range("Span index is out of range");
+        }
+        return data_[index];
+    }
+
+private:
+    const T* data_ = nullptr;
+    size_t size_ = 0;
+};
+
 }  // namespace ranges
\ No newline at end of file
@@ -0,0 +1,186 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "raptor.h"
+
+namespace router {
+
+RaptorRouter::RaptorRouter(const TransportCatalogue& transport_catalogue, double bus_wait_time, double bus_velocity)
+: bus_wait_time_(bus_wait_time)
+, bus_velocity_(bus_velocity)
+, stop_count_(transport_catalogue.GetCountStops()) {
+    // рейсы совпадают с рейсами графа: некольцевой маршрут разворачивается на средней остановке
+    route_offsets_.push_back(0);
+    for (BusId bus = 0; bus < transport_catalogue.GetCountBuses(); ++bus) {
+        const auto bus_stops = transport_catalogue.GetBusStops(bus);
+        const std::vector<StopId> stops(bus_stops.begin(), bus_stops.end());
+        if (stops.size() < 2) {
+            continue;
+        }
+        if (transport_catalogue.IsRoundtrip(bus)) {
+            AddRoute(transport_catalogue, bus, stops, 0, stops.size() - 1);
+        } else {
+            const size_t mid = stops.size() / 2;
+            AddRoute(transport_catalogue, bus, stops, 0, mid);
+            AddRoute(transport_catalogue, bus, stops, mid, stops.size() - 1);
+        }
+    }
+
+    // индекс остановка -> (рейс, позиция) сортировкой подсчётом
+    stop_route_offsets_.assign(stop_count_ + 1, 0);
+    for (const StopId stop : route_stops_) {
+        ++stop_route_offsets_[stop + 1];
+    }
+    for (size_t stop = 0; stop < stop_count_; ++stop) {
+        stop_route_offsets_[stop + 1] += stop_route_offsets_[stop];
+    }
+    stop_routes_.resize(route_stops_.size());
+    std::vector<std::uint32_t> positions(stop_route_offsets_.begin(), stop_route_offsets_.end() - 1);
+    for (RouteId route = 0; route + 1 < route_offsets_.size(); ++route) {
+        for (std::uint32_t i = route_offsets_[route]; i < route_offsets_[route + 1]; ++i) {
+            stop_routes_[positions[route_stops_[i]]++] = {route, i - route_offsets_[route]};
+        }
+    }
+}
+
+void RaptorRouter::AddRoute(const TransportCatalogue& transport_catalogue, BusId bus,
+                            const std::vector<StopId>& stops, size_t first, size_t last) {
+    std::int64_t distance = 0;
+    for (size_t position = first; position <= last; ++position) {
+        if (position != first) {
+            distance += transport_catalogue.GetDistance(stops[position - 1], stops[position]);
+        }
+        route_stops_.push_back(stops[position]);
+        route_distances_.push_back(distance);
+    }
+    route_offsets_.push_back(static_cast<std::uint32_t>(route_stops_.size()));
+    route_buses_.push_back(bus);
+}
+
+std::vector<RaptorRouter::Journey> RaptorRouter::FindJourneys(StopId from, StopId to,
+                                                               std::optional<size_t> max_transfers) const {
+    if (from >= stop_count_ || to >= stop_count_) {
+        throw std::out_of_range("Stop is out of the RAPTOR router");
+    }
+    if (from == to) {
+        return {Journey{0.0, 0, {}}};
+    }
+
+    // arrivals - лучшие прибытия не более чем за k - 1 поездок, в next_arrivals строится раунд k; best - по всем раундам.
+    // Хранятся только два раунда прибытий: метки улучшенных остановок каждого раунда дописываются в labels,
+    // так что память - O(остановок + улучшений), а не O(раундов * остановок)
+    std::vector<double> arrivals(stop_count_, UNREACHABLE);
+    arrivals[from] = 0.0;
+    std::vector<double> next_arrivals;
+    std::vector<double> best(stop_count_, UNREACHABLE);
+    best[from] = 0.0;
+    // метки остановок, улучшенных в текущем раунде; верны только для marked_stops
+    std::vector<Label> round_labels(stop_count_);
+    std::vector<Label> labels;
+    std::vector<size_t> label_offsets{0};
+
+    std::vector<StopId> marked_stops{from};
+    std::vector<bool> is_marked(stop_count_, false);
+    // для каждого рейса - первая позиция, с которой его нужно просмотреть в текущем раунде
+    std::vector<std::uint32_t> scan_from(route_buses_.size(), NO_ROUTE);
+    std::vector<RouteId> routes_to_scan;
+
+    std::vector<Journey> journeys;
+    // пересадок больше, чем остановок, не бывает: так и *max_transfers + 1 не переполняется
+    const size_t max_rounds = max_transfers && *max_transfers < stop_count_ ? *max_transfers + 1 : stop_count_;
+    for (size_t round = 1; round <= max_rounds && !marked_stops.empty(); ++round) {
+        for (const StopId stop : marked_stops) {
+            for (std::uint32_t i = stop_route_offsets_[stop]; i < stop_route_offsets_[stop + 1]; ++i) {
+                const auto [route, position] = stop_routes_[i];
+                if (scan_from[route] == NO_ROUTE) {
+                    routes_to_scan.push_back(route);
+                    scan_from[route] = position;
+                } else {
+                    scan_from[route] = std::min(scan_from[route], position);
+                }
+            }
+        }
+        marked_stops.clear();
+        next_arrivals = arrivals;
+
+        for (const RouteId route : routes_to_scan) {
+            const StopId* stops = route_stops_.data() + route_offsets_[route];
+            const std::int64_t* distances = route_distances_.data() + route_offsets_[route];
+            const std::uint32_t length = route_offsets_[route + 1] - route_offsets_[route];
+
+            // время отправления с позиции board_position, если уже сели в автобус
+            double departure = UNREACHABLE;
+            std::uint32_t board_position = 0;
+            for (std::uint32_t position = scan_from[route]; position < length; ++position) {
+                const StopId stop = stops[position];
+                double arrival = UNREACHABLE;
+                if (departure != UNREACHABLE) {
+                    arrival = departure + (distances[position] - distances[board_position]) / bus_velocity_;
+                    // улучшение засчитывается, только если оно лучше всех раундов и известного времени до цели
+                    if (arrival < best[stop] && arrival < best[to]) {
+                        next_arrivals[stop] = arrival;
+                        round_labels[stop] = {stop, route, board_position, position};
+                        best[stop] = arrival;
+                        if (!is_marked[stop]) {
+                            is_marked[stop] = true;
+                            marked_stops.push_back(stop);
+                        }
+                    }
+                }
+                // пересесть сюда выгоднее, чем ехать дальше на текущем автобусе
+                if (arrivals[stop] != UNREACHABLE && arrivals[stop] + bus_wait_time_ < arrival) {
+                    departure = arrivals[stop] + bus_wait_time_;
+                    board_position = position;
+                }
+            }
+            scan_from[route] = NO_ROUTE;
+        }
+        routes_to_scan.clear();
+
+        const bool is_target_improved = is_marked[to];
+        // marked_stops сохраняют порядок улучшений: от него зависит порядок рейсов следующего раунда
+        const size_t round_begin = labels.size();
+        for (const StopId stop : marked_stops) {
+            labels.push_back(round_labels[stop]);
+            is_marked[stop] = false;
+        }
+        std::sort(labels.begin() + round_begin, labels.end(), [](const Label& lhs, const Label& rhs) {
+            return lhs.stop < rhs.stop;
+        });
+        label_offsets.push_back(labels.size());
+        arrivals.swap(next_arrivals);
+        if (is_target_improved) {
+            journeys.push_back(MakeJourney(labels, label_offsets, arrivals[to], round, to));
+        }
+    }
+
+    return journeys;
+}
+
+RaptorRouter::Journey RaptorRouter::MakeJourney(const std::vector<Label>& labels, const std::vector<size_t>& label_offsets,
+                                                double arrival, size_t round, StopId to) const {
+    Journey journey{arrival, round - 1, {}};
+    StopId stop = to;
+    for (; round > 0; --round) {
+        const auto first = labels.begin() + label_offsets[round - 1];
+        const auto last = labels.begin() + label_offsets[round];
+        const auto it = std::lower_bound(first, last, stop, [](const Label& label, StopId stop) {
+            return label.stop < stop;
+        });
+        if (it == last || it->stop != stop) { // остановка не улучшена в этом раунде: метка из предыдущего
+            continue;
+        }
+        const Label& label = *it;
+        const std::uint32_t offset = route_offsets_[label.route];
+        const StopId board_stop = route_stops_[offset + label.board_position];
+        const double ride_time = (route_distances_[offset + label.alight_position]
+                                  - route_distances_[offset + label.board_position]) / bus_velocity_;
+        journey.legs.push_back({board_stop, route_buses_[label.route],
+                                label.alight_position - label.board_position, ride_time});
+        stop = board_stop;
+    }
+    std::reverse(journey.legs.begin(), journey.legs.end());
+    return journey;
+}
+
+}  // namespace router
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <vector>
+
+#include "transport_catalogue.h"
+
+namespace router {
+
+using namespace transport;
+
+/*
+ * RAPTOR (Round-bAsed Public Transit Optimized Router): поиск по раундам прямо по маршрутам справочника,
+ * без графа. Раунд k находит лучшие времена прибытия, использующие не более k поездок: просматриваются
+ * рейсы, проходящие через остановки, улучшенные в раунде k - 1. Расписания нет, поэтому посадка
+ * стоит фиксированное время ожидания, а поездка - расстояние по дорогам, делённое на скорость.
+ * Рейсы хранятся плоскими массивами остановок и накопленных расстояний
+ */
+class RaptorRouter {
+public:
+    struct Leg {
+        StopId board_stop;
+        BusId bus;
+        size_t span_count;
+        double ride_time;
+    };
+
+    struct Journey {
+        double total_time;
+        size_t transfers;
+        std::vector<Leg> legs;
+    };
+
+    // bus_velocity - в метрах в минуту
+    RaptorRouter(const TransportCatalogue& transport_catalogue, double bus_wait_time, double bus_velocity);
+
+    // Парето-оптимальные по (времени, числу пересадок) маршруты, по возрастанию числа пересадок:
+    // каждый следующий быстрее предыдущего. Пусто, если маршрута нет
+    std::vector<Journey> FindJourneys(StopId from, StopId to, std::optional<size_t> max_transfers = std::nullopt) const;
+
+private:
+    using RouteId = std::uint32_t;
+    static constexpr RouteId NO_ROUTE = std::numeric_limits<RouteId>::max();
+    static constexpr double UNREACHABLE = std::numeric_limits<double>::infinity();
+
+    struct RouteStop {
+        RouteId route;
+        std::uint32_t position;
+    };
+
+    // метка остановки, улучшенной в раунде: поездка, которой она достигнута
+    struct Label {
+        StopId stop;
+        RouteId route;
+        std::uint32_t board_position;
+        std::uint32_t alight_position;
+    };
+
+    double bus_wait_time_;
+    double bus_velocity_;
+    size_t stop_count_;
+
+    // рейс r: остановки route_stops_[route_offsets_[r] .. route_offsets_[r + 1]),
+    // route_distances_ - расстояние от начала рейса до остановки
+    std::vector<std::uint32_t> route_offsets_;
+    std::vector<StopId> route_stops_;
+    std::vector<std::int64_t> route_distances_;
+    std::vector<BusId> route_buses_;
+    // рейсы через остановку s: stop_routes_[stop_route_offsets_[s] .. stop_route_offsets_[s + 1])
+    std::vector<std::uint32_t> stop_route_offsets_;
+    std::vector<RouteStop> stop_routes_;
+
+    void AddRoute(const TransportCatalogue& transport_catalogue, BusId bus,
+                  const std::vector<StopId>& stops, size_t first, size_t last);
+    // labels раунда k - labels[label_offsets[k - 1] .. label_offsets[k]), по возрастанию остановки
+    Journey MakeJourney(const std::vector<Label>& labels, const std::vector<size_t>& label_offsets,
+                        double arrival, size_t round, StopId to) const;
+};
+
+}  // namespace router
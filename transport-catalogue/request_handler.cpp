@@ -1,111 +1,138 @@
+#include <charconv>
 #include <iostream>
 #include <string>
 #include <map>
 #include <iomanip>
+#include <sstream>
+#include <algorithm>
+#include <vector>
 
-#include "json_builder.h"
+#include "json_writer.h"
+#include "log_duration.h"
 #include "request_handler.h"
 
 namespace request_handler {
 
 RequestHandler::RequestHandler(const TransportCatalogue& transport_catalogue,
                                const MapRenderer& map_renderer,
-                               const TransportRouter& transport_router)
+                               const TransportRouter& transport_router,
+                               std::ostream* timings)
 : transport_catalogue_(transport_catalogue)
 , map_renderer_(map_renderer)
 , transport_router_(transport_router)
-, router_(transport_router_.GetGraph()) {
+, timings_(timings) {
 }
 
-std::optional<Bus> RequestHandler::GetBusStat(const std::string_view bus_name) const {
-    if (transport_catalogue_.FindBusByName(bus_name) != nullptr) {
-        return *transport_catalogue_.FindBusByName(bus_name);
-    }
+std::optional<BusId> RequestHandler::FindBus(const std::string_view bus_name) const {
+    return transport_catalogue_.FindBusId(bus_name);
+}
 
-    return {};
+std::optional<StopId> RequestHandler::FindStop(const std::string_view stop_name) const {
+    return transport_catalogue_.FindStopId(stop_name);
 }
 
-std::optional<std::set<std::string_view> > RequestHandler::GetBusesByStop(const std::string_view stop_name) const {
-    if (transport_catalogue_.FindBusesForStop(stop_name) != nullptr) {
-        return *transport_catalogue_.FindBusesForStop(stop_name);
+int RequestHandler::GetDistanceBetweenStops(StopId from, StopId to) const {
+    return transport_catalogue_.GetDistance(from, to);
+}
+
+void RequestHandler::ProcessStatRequests(const SourseStatRequests& stat_requests, std::ostream& output) const {
+    std::string buffer;
+    json::Writer answers(buffer);
+    answers.StartArray();
+    for (const auto& request : stat_requests) {
+        WriteAnswer(request, answers, &std::cout);
     }
-    return {};
+    answers.EndArray();
+    output << buffer;
 }
 
-int RequestHandler::GetDistanceBetweenStops(const std::pair<Stop*, Stop*>& stops) const {
-    return transport_catalogue_.DistanceBetweenStops(stops);
+void RequestHandler::ProcessStatRequest(const std::map<std::string, std::string>& request, json::Writer& answers) const {
+    WriteAnswer(request, answers, nullptr);
 }
 
-json::Document RequestHandler::ProcessStatRequests(const SourseStatRequests& stat_requests) const {
-    auto stat = json::Builder{};
-    auto array = stat.StartArray();
+void RequestHandler::WriteAnswer(const std::map<std::string, std::string>& request, json::Writer& answers,
+                                 std::ostream* svg_output) const {
+    const auto& type = request.at("type"s);
+    if (type == "Stop"s) {
+        ProcessStatStop(request, answers);
+    } else if (type == "Bus"s) {
+        ProcessStatBus(request, answers);
+    } else if (type == "Map"s) {
+        ProcessMap(request, answers, svg_output);
+    } else if (type == "Route"s) {
+        ProcessRoute(request, answers);
+    } else {
+        throw std::invalid_argument("Unknown request type "s + type);
+    }
+}
 
-    for (const auto& request : stat_requests) {
-        if (request.at("type"s) == "Stop"s) {
-            array.Value(ProcessStatStop(request).AsDict());
-        } else if (request.at("type"s) == "Bus"s) {
-            array.Value(ProcessStatBus(request).AsDict());
-        } else if (request.at("type"s) == "Map"s) {
-            array.Value(ProcessMap(request).AsDict());
-        } else if (request.at("type"s) == "Route"s) {
-            array.Value(ProcessRoute(request).AsDict());
+serialization::DatabaseSections RequestHandler::GetRequiredSections(const std::vector<std::string>& request_types) {
+    serialization::DatabaseSections sections{false, false, false};
+    for (const auto& type : request_types) {
+        if (type == "Stop"s || type == "Bus"s) {
+            sections.transport_catalogue = true;
+        } else if (type == "Map"s) {
+            sections.transport_catalogue = true;
+            sections.map_renderer = true;
+        } else if (type == "Route"s) {
+            sections.transport_catalogue = true;
+            sections.transport_router = true;
         }
     }
-    json::Document document(std::move(stat.EndArray().Build()));
-    return document;
+    return sections;
 }
 
-json::Node RequestHandler::ProcessStatStop(const std::map<std::string, std::string>& request) const {
-    auto answer = json::Builder{};
-    auto stop = answer.StartDict();
-    stop.Key("request_id").Value(std::stoi(request.at("id")));
-
-    const auto buses = GetBusesByStop(request.at("name"));
-    if (!buses.has_value()) {
-        stop.Key("error_message").Value("not found");
-        return answer.EndDict().Build();
+void RequestHandler::ProcessStatStop(const std::map<std::string, std::string>& request, json::Writer& answers) const {
+    const int request_id = std::stoi(request.at("id"));
+    const auto stop_id = FindStop(request.at("name"));
+    if (!stop_id.has_value()) {
+        WriteNotFound(request_id, answers);
+        return;
     }
 
     auto buses_list =
-    stop.Key("buses").StartArray();
-    for (const auto& bus : *buses) {
-        buses_list.Value(static_cast<std::string>(bus));
+    answers.StartDict().Key("buses").StartArray();
+    for (const auto bus : transport_catalogue_.GetStopBuses(*stop_id)) {
+        buses_list.Value(transport_catalogue_.GetBusName(bus));
     }
-    buses_list.EndArray();
-    return answer.EndDict().Build();
+    buses_list.EndArray()
+        .Key("request_id").Value(request_id)
+    .EndDict();
 }
 
-json::Node RequestHandler::ProcessStatBus(const std::map<std::string, std::string>& request) const {
-    auto answer = json::Builder{};
-    auto bus = answer.StartDict();
-
-    bus.Key("request_id").Value(std::stoi(request.at("id")));
-
-    const auto buses = GetBusStat(request.at("name"));
-    if (!buses.has_value()) {
-        bus.Key("error_message").Value("not found");
-        return answer.EndDict().Build();
+void RequestHandler::ProcessStatBus(const std::map<std::string, std::string>& request, json::Writer& answers) const {
+    const int request_id = std::stoi(request.at("id"));
+    const auto bus_id = FindBus(request.at("name"));
+    if (!bus_id.has_value()) {
+        WriteNotFound(request_id, answers);
+        return;
     }
 
+    const auto stops = transport_catalogue_.GetBusStops(*bus_id);
+    const size_t stop_count = stops.end() - stops.begin();
     double shortest_distance = 0.0;
     int real_distance = 0;
-    for (size_t l = 0, r = 1; l + 1 < buses->bus_stops.size(); ++l, ++r) {
-        Stop* left_bus_ptr = buses->bus_stops.at(l);
-        Stop* right_bus_ptr = buses->bus_stops.at(r);
-        shortest_distance += ComputeDistance(left_bus_ptr->stop_coordinates,
-                                             right_bus_ptr->stop_coordinates);
-        real_distance += GetDistanceBetweenStops({left_bus_ptr, right_bus_ptr});
+    for (size_t l = 0, r = 1; l + 1 < stop_count; ++l, ++r) {
+        shortest_distance += ComputeDistance(transport_catalogue_.GetStopCoordinates(stops.begin()[l]),
+                                             transport_catalogue_.GetStopCoordinates(stops.begin()[r]));
+        real_distance += GetDistanceBetweenStops(stops.begin()[l], stops.begin()[r]);
     }
 
-    bus
+    unique_stops_.assign(stops.begin(), stops.end());
+    std::sort(unique_stops_.begin(), unique_stops_.end());
+    unique_stops_.erase(std::unique(unique_stops_.begin(), unique_stops_.end()), unique_stops_.end());
+
+    answers.StartDict()
         .Key("curvature").Value(real_distance / shortest_distance)
+        .Key("request_id").Value(request_id)
         .Key("route_length").Value(real_distance)
-        .Key("stop_count").Value(static_cast<int>(buses->bus_stops.size()))
-        .Key("unique_stop_count").Value(static_cast<int>(std::set<Stop *>(buses->bus_stops.begin(), buses->bus_stops.end()).size()));
-    return answer.EndDict().Build();
+        .Key("stop_count").Value(static_cast<int>(stop_count))
+        .Key("unique_stop_count").Value(static_cast<int>(unique_stops_.size()))
+    .EndDict();
 }
 
-json::Node RequestHandler::ProcessMap(const std::map<std::string, std::string>& request) const {
+void RequestHandler::ProcessMap(const std::map<std::string, std::string>& request, json::Writer& answers,
+                                std::ostream* svg_output) const {
     svg::Document doc = RenderMap();
     std::ostringstream buf;
     doc.Render(buf);
@@ -113,44 +140,145 @@ json::Node RequestHandler::ProcessMap(const std::map<std::string, std::string>&
     /* ВАЖНО: эта строка выводит рисунок в виде svg-формата в файл, в который затем будут выведены ответы на запросы.
      * При необходимости от этого можно отказаться
      */
-    std::cout << buf.str() << std::endl;
+    if (svg_output != nullptr) {
+        *svg_output << buf.str() << std::endl;
+    }
 
-    return
-    json::Builder{}
-        .StartDict()
-            .Key("request_id").Value(std::stoi(request.at("id")))
-            .Key("map").Value(buf.str())
-        .EndDict()
-    .Build();
+    answers.StartDict()
+        .Key("map").Value(buf.str())
+        .Key("request_id").Value(std::stoi(request.at("id")))
+    .EndDict();
 }
 
 svg::Document RequestHandler::RenderMap() const {
     svg::Document doc;
-    const auto map_route = map_renderer_.Render();
+    const auto map_route = map_renderer_.Render(transport_catalogue_);
     map_route.Draw(doc);
     return doc;
 }
 
-json::Node RequestHandler::ProcessRoute(const std::map<std::string, std::string>& request) const {
-    auto answer = json::Builder{};
-    auto route = answer.StartDict();
-    route.Key("request_id").Value(std::stoi(request.at("id")));
+void RequestHandler::ProcessRoute(const std::map<std::string, std::string>& request, json::Writer& answers) const {
+    const int request_id = std::stoi(request.at("id"));
+    const auto stop_from = FindStop(request.at("from"));
+    const auto stop_to = FindStop(request.at("to"));
+    if (!stop_from.has_value() || !stop_to.has_value()) {
+        WriteNotFound(request_id, answers);
+        return;
+    }
+
+    // ограничение пересадок и Парето-ответ умеет только RAPTOR
+    const bool needs_raptor = request.count("max_transfers") || request.count("pareto");
+    const RouteBuilder<double>* router = needs_raptor ? nullptr : GetRouter();
+    if (router == nullptr) {
+        ProcessRaptorRoute(request_id, request, *stop_from, *stop_to, answers);
+        return;
+    }
+
+    const auto route_info = transport_router_.BuildRoute(*router, *stop_from, *stop_to);
+    if (!route_info.has_value()) {
+        WriteNotFound(request_id, answers);
+        return;
+    }
+
+    auto items = answers.StartDict().Key("items").StartArray();
+    const double total_time = transport_router_.WriteRouteItems(*route_info, answers);
+    items.EndArray()
+        .Key("request_id").Value(request_id)
+        .Key("total_time").Value(total_time)
+    .EndDict();
+}
+
+void RequestHandler::ProcessRaptorRoute(int request_id, const std::map<std::string, std::string>& request,
+                                        StopId from, StopId to, json::Writer& answers) const {
+    std::optional<size_t> max_transfers;
+    if (const auto it = request.find("max_transfers"); it != request.end()) {
+        // std::stoul молча обернул бы "-1" в SIZE_MAX: здесь принимаются только цифры
+        size_t value = 0;
+        const char* const last = it->second.data() + it->second.size();
+        if (const auto [end, error] = std::from_chars(it->second.data(), last, value); error != std::errc{} || end != last) {
+            throw std::invalid_argument("max_transfers should be a non-negative integer, not "s + it->second);
+        }
+        max_transfers = value;
+    }
+    const auto journeys = GetRaptorRouter().FindJourneys(from, to, max_transfers);
+    if (journeys.empty()) {
+        WriteNotFound(request_id, answers);
+        return;
+    }
+
+    // основной ответ - самый быстрый вариант в пределах ограничения, он последний
+    auto items = answers.StartDict().Key("items").StartArray();
+    const double total_time = WriteJourneyItems(journeys.back(), answers);
+    json::Writer& route = items.EndArray();
+
+    if (request.count("pareto")) {
+        auto journeys_list = route.Key("journeys").StartArray();
+        for (const auto& journey : journeys) {
+            auto journey_items = journeys_list.StartDict().Key("items").StartArray();
+            WriteJourneyItems(journey, answers);
+            journey_items.EndArray()
+                    .Key("total_time").Value(journey.total_time)
+                    .Key("transfers").Value(static_cast<int>(journey.transfers))
+                    .EndDict();
+        }
+        journeys_list.EndArray();
+    }
+
+    route
+        .Key("request_id").Value(request_id)
+        .Key("total_time").Value(total_time)
+    .EndDict();
+}
+
+void RequestHandler::WriteNotFound(int request_id, json::Writer& answers) {
+    answers.StartDict()
+        .Key("error_message").Value("not found")
+        .Key("request_id").Value(request_id)
+    .EndDict();
+}
 
-    /* Node::Array */
-    auto route_items = transport_router_.GetRouteAsNode(router_, request.at("from"), request.at("to"));
-    if (!route_items.has_value()) {
-        route.Key("error_message").Value(static_cast<std::string>("not found"));
-        return answer.EndDict().Build();
+const RouteBuilder<double>* RequestHandler::GetRouter() const {
+    if (router_ == nullptr && transport_router_.GetRoutingSettings().router_type != RouterType::RAPTOR) {
+        timing::LogDuration duration("Router materialization", timings_);
+        if (transport_router_.GetRouter()) {
+            router_ = &*transport_router_.GetRouter(); // таблица из базы, без копирования и пересчёта
+        } else {
+            own_router_ = transport_router_.MakeRouter();
+            router_ = own_router_.get();
+        }
     }
+    return router_;
+}
 
-    route.Key("items").Value(route_items->AsArray());
-    double weight = 0.0;
-    for (const auto& item: route_items->AsArray()) {
-        weight += item.AsDict().at("time").AsDouble();
+const RaptorRouter& RequestHandler::GetRaptorRouter() const {
+    if (!raptor_router_) {
+        timing::LogDuration duration("RAPTOR materialization", timings_);
+        const auto& routing_settings = transport_router_.GetRoutingSettings();
+        raptor_router_ = std::make_unique<RaptorRouter>(transport_catalogue_, routing_settings.bus_wait_time,
+                                                        routing_settings.bus_velocity);
     }
-    route.Key("total_time").Value(weight);
+    return *raptor_router_;
+}
 
-    return answer.EndDict().Build();
+double RequestHandler::WriteJourneyItems(const RaptorRouter::Journey& journey, json::Writer& items) const {
+    const double wait_time = transport_router_.GetRoutingSettings().bus_wait_time;
+    double total_time = 0.0;
+    for (const auto& leg : journey.legs) {
+        items.StartDict()
+                .Key("stop_name").Value(transport_catalogue_.GetStopName(leg.board_stop))
+                .Key("time").Value(wait_time)
+                .Key("type").Value("Wait")
+                .EndDict();
+        items.StartDict()
+                .Key("bus").Value(transport_catalogue_.GetBusName(leg.bus))
+                .Key("span_count").Value(static_cast<int>(leg.span_count))
+                .Key("time").Value(leg.ride_time)
+                .Key("type").Value("Bus")
+                .EndDict();
+        total_time += wait_time;
+        total_time += leg.ride_time;
+    }
+    return total_time;
 }
 
 }  // namespace request_handler
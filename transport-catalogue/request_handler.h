@@ -3,14 +3,18 @@
 #include <iostream>
 #include <string>
 #include <map>
+#include <memory>
 #include <optional>
+#include <vector>
 
 #include "json_reader.h"
 #include "transport_catalogue.h"
 #include "map_renderer.h"
 #include "domain.h"
 #include "json.h"
+#include "json_writer.h"
 #include "router.h"
+#include "raptor.h"
 
 namespace request_handler {
 
@@ -25,13 +29,20 @@ class RequestHandler {
 public:
     RequestHandler(const TransportCatalogue& transport_catalogue,
                    const MapRenderer& map_renderer,
-                   const TransportRouter& transport_router);
+                   const TransportRouter& transport_router,
+                   std::ostream* timings = nullptr);
 
-    std::optional<Bus> GetBusStat(const std::string_view bus_name) const;
-    std::optional<std::set<std::string_view> > GetBusesByStop(const std::string_view stop_name) const;
-    int GetDistanceBetweenStops(const std::pair<Stop*, Stop*>& stops) const;
+    // Поиск по названию; дальше справочник используется только по номерам
+    std::optional<BusId> FindBus(const std::string_view bus_name) const;
+    std::optional<StopId> FindStop(const std::string_view stop_name) const;
+    int GetDistanceBetweenStops(StopId from, StopId to) const;
 
-    json::Document ProcessStatRequests(const SourseStatRequests& stat_requests) const;
+    // Выводит в output массив ответов; svg запросов Map перед этим выводится в std::cout
+    void ProcessStatRequests(const SourseStatRequests& stat_requests, std::ostream& output) const;
+    // Дописывает ответ на один запрос следующим значением answers. svg запроса Map есть только в ответе
+    void ProcessStatRequest(const std::map<std::string, std::string>& request, json::Writer& answers) const;
+    // Части базы, нужные для ответа на запросы этих типов: справочник - всем, карта - Map, маршрутизатор - Route
+    static serialization::DatabaseSections GetRequiredSections(const std::vector<std::string>& request_types);
 
     svg::Document RenderMap() const;
 
@@ -40,13 +51,32 @@ private:
     const MapRenderer& map_renderer_;
 
     const TransportRouter& transport_router_;
-    const Router<double> router_;
+    // движок маршрутизации создаётся при первом запросе Route: пакет без маршрутов за него не платит
+    mutable const RouteBuilder<double>* router_ = nullptr;
+    mutable std::unique_ptr<RouteBuilder<double>> own_router_;
+    // строится при первом запросе с max_transfers или pareto, если в базе выбран другой алгоритм
+    mutable std::unique_ptr<RaptorRouter> raptor_router_;
+    // куда выводить время построения движков; nullptr - не выводить
+    std::ostream* timings_;
+    // остановки запроса Bus для подсчёта уникальных: память выделяется один раз, а не на каждый запрос
+    mutable std::vector<StopId> unique_stops_;
 
 
-    json::Node ProcessStatStop(const std::map<std::string, std::string>& request) const;
-    json::Node ProcessStatBus(const std::map<std::string, std::string>& request) const;
-    json::Node ProcessMap(const std::map<std::string, std::string>& request) const;
-    json::Node ProcessRoute(const std::map<std::string, std::string>& request) const;
+    // Ответы пишутся прямо в answers, без узлов JSON; ключи словарей - по алфавиту, как их выводит Print
+    void WriteAnswer(const std::map<std::string, std::string>& request, json::Writer& answers, std::ostream* svg_output) const;
+    void ProcessStatStop(const std::map<std::string, std::string>& request, json::Writer& answers) const;
+    void ProcessStatBus(const std::map<std::string, std::string>& request, json::Writer& answers) const;
+    void ProcessMap(const std::map<std::string, std::string>& request, json::Writer& answers, std::ostream* svg_output) const;
+    void ProcessRoute(const std::map<std::string, std::string>& request, json::Writer& answers) const;
+    void ProcessRaptorRoute(int request_id, const std::map<std::string, std::string>& request, StopId from, StopId to,
+                            json::Writer& answers) const;
+    static void WriteNotFound(int request_id, json::Writer& answers);
+
+    // nullptr, если графа нет (RouterType::RAPTOR)
+    const RouteBuilder<double>* GetRouter() const;
+    const RaptorRouter& GetRaptorRouter() const;
+    // Дописывает элементы варианта в открытый массив items и возвращает их суммарное время
+    double WriteJourneyItems(const RaptorRouter::Journey& journey, json::Writer& items) const;
 };
 
 }  // namespace request_handler
@@ -1,11 +1,17 @@
 #pragma once
 
 #include "graph.h"
+#include "floyd_warshall.h"
+#include "routes_table.h"
+#include "routes_table_rows.h"
+#include "routes_table_repair.h"
+#include "thread_pool.h"
 
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
 #include <iterator>
+#include <limits>
 #include <optional>
 #include <stdexcept>
 #include <unordered_map>
@@ -14,115 +20,155 @@
 
 namespace graph {
 
+/*
+ * Общий интерфейс движков построения маршрута по графу.
+ * Позволяет выбирать алгоритм (предпосчитанная таблица, Дейкстра и т.д.) без изменения клиентского кода
+ */
 template <typename Weight>
-class Router {
-private:
-    using Graph = DirectedWeightedGraph<Weight>;
-
+class RouteBuilder {
 public:
-    explicit Router(const Graph& graph);
-
     struct RouteInfo {
         Weight weight;
         std::vector<EdgeId> edges;
     };
 
-    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+    virtual std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const = 0;
 
-    struct RouteInternalData {
-        Weight weight;
-        std::optional<EdgeId> prev_edge;
-    };
-    using RoutesInternalData = std::vector<std::vector<std::optional<RouteInternalData>>>;
+    virtual ~RouteBuilder() = default;
+};
 
+/*
+ * Движок с предпосчитанной таблицей кратчайших путей между всеми парами вершин.
+ * TableWeight - разрядность весов в таблице (float вдвое компактнее double)
+ */
+template <typename Weight, typename TableWeight = Weight>
+class Router final : public RouteBuilder<Weight> {
 private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using typename RouteBuilder<Weight>::RouteInfo;
+    using Table = RoutesTable<TableWeight>;
 
-    void InitializeRoutesInternalData(const Graph& graph) {
+    explicit Router(const Graph& graph);
+    Router(const Graph& graph, Table table);
+    // Таблица графа graph, изменённого из base_graph, восстановленная по таблице base_table прежнего графа:
+    // заново считаются только строки, маршруты которых могли измениться (см. routes_table_repair.h)
+    Router(const Graph& graph, const Graph& base_graph, const Table& base_table, const std::vector<VertexId>& vertex_map);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+
+    const Table& GetRoutesTable() const {
+        return routes_table_;
+    }
+
+private:
+    void InitializeRoutesTable(const Graph& graph) {
         const size_t vertex_count = graph.GetVertexCount();
         for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
-            routes_internal_data_[vertex][vertex] = RouteInternalData{ZERO_WEIGHT, std::nullopt};
+            routes_table_.weights[routes_table_.GetCell(vertex, vertex)] = ZERO_WEIGHT;
             for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
                 const auto& edge = graph.GetEdge(edge_id);
-                if (edge.weight < ZERO_WEIGHT) {
+                if (edge.weight < Weight{}) {
                     throw std::domain_error("Edges' weights should be non-negative");
                 }
-                auto& route_internal_data = routes_internal_data_[vertex][edge.to];
-                if (!route_internal_data || route_internal_data->weight > edge.weight) {
-                    route_internal_data = RouteInternalData{edge.weight, edge_id};
-                }
-            }
-        }
-    }
-
-    void RelaxRoute(VertexId vertex_from, VertexId vertex_to, const RouteInternalData& route_from,
-                    const RouteInternalData& route_to) {
-        auto& route_relaxing = routes_internal_data_[vertex_from][vertex_to];
-        const Weight candidate_weight = route_from.weight + route_to.weight;
-        if (!route_relaxing || candidate_weight < route_relaxing->weight) {
-            route_relaxing = {candidate_weight,
-                              route_to.prev_edge ? route_to.prev_edge : route_from.prev_edge};
-        }
-    }
-
-    void RelaxRoutesInternalDataThroughVertex(size_t vertex_count, VertexId vertex_through) {
-        for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
-            if (const auto& route_from = routes_internal_data_[vertex_from][vertex_through]) {
-                for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
-                    if (const auto& route_to = routes_internal_data_[vertex_through][vertex_to]) {
-                        RelaxRoute(vertex_from, vertex_to, *route_from, *route_to);
-                    }
+                const size_t cell = routes_table_.GetCell(vertex, edge.to);
+                const auto edge_weight = static_cast<TableWeight>(edge.weight);
+                if (edge_weight < routes_table_.weights[cell]) {
+                    routes_table_.weights[cell] = edge_weight;
+                    routes_table_.prev_edges[cell] = static_cast<TableEdgeId>(edge_id);
                 }
             }
         }
     }
 
-    static constexpr Weight ZERO_WEIGHT{};
+    static constexpr TableWeight ZERO_WEIGHT{};
     const Graph& graph_;
-    RoutesInternalData routes_internal_data_;
-
-public:
-    Router(const Graph& graph, RoutesInternalData internal_data);
-
-    const RoutesInternalData& GetRoutesInternalData() const {
-        return routes_internal_data_;
-    }
+    Table routes_table_;
 };
 
-template <typename Weight>
-Router<Weight>::Router(const Graph& graph)
+template <typename Weight, typename TableWeight>
+Router<Weight, TableWeight>::Router(const Graph& graph)
     : graph_(graph)
-    , routes_internal_data_(graph.GetVertexCount(),
-                            std::move(std::vector<std::optional<RouteInternalData>>(graph.GetVertexCount())))
+    , routes_table_(graph.GetVertexCount())
 {
-    InitializeRoutesInternalData(graph);
+    if (graph.GetEdgeCount() >= NO_EDGE) {
+        throw std::length_error("Too many edges for the routes table");
+    }
+    InitializeRoutesTable(graph);
 
-    const size_t vertex_count = graph.GetVertexCount();
-    for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
-        RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through);
+    if (graph.GetVertexCount() >= floyd_warshall::PARALLEL_THRESHOLD) {
+        concurrency::ThreadPool pool;
+        floyd_warshall::RelaxAllPairs(routes_table_, &pool);
+    } else {
+        floyd_warshall::RelaxAllPairs(routes_table_, nullptr);
     }
 }
 
-template <typename Weight>
-Router<Weight>::Router(const Graph& graph, RoutesInternalData internal_data)
+template <typename Weight, typename TableWeight>
+Router<Weight, TableWeight>::Router(const Graph& graph, Table table)
 : graph_(graph)
-, routes_internal_data_(std::move(internal_data)) {
+, routes_table_(std::move(table)) {
 }
 
-template <typename Weight>
-std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from,
-                                                                             VertexId to) const {
+template <typename Weight, typename TableWeight>
+Router<Weight, TableWeight>::Router(const Graph& graph, const Graph& base_graph, const Table& base_table,
+                                    const std::vector<VertexId>& vertex_map)
+    : graph_(graph)
+    , routes_table_(graph.GetVertexCount())
+{
+    if (graph.GetEdgeCount() >= NO_EDGE) {
+        throw std::length_error("Too many edges for the routes table");
+    }
+    if (graph.GetVertexCount() >= floyd_warshall::PARALLEL_THRESHOLD) {
+        concurrency::ThreadPool pool;
+        table_repair::RepairAllPairs(routes_table_, graph, base_graph, base_table, vertex_map, &pool);
+    } else {
+        table_repair::RepairAllPairs(routes_table_, graph, base_graph, base_table, vertex_map, nullptr);
+    }
+}
 
-    const auto& route_internal_data = routes_internal_data_.at(from).at(to);
-    if (!route_internal_data) {
-        return std::nullopt;
+template <typename Weight, typename TableWeight>
+std::optional<typename Router<Weight, TableWeight>::RouteInfo> Router<Weight, TableWeight>::BuildRoute(VertexId from,
+                                                                                                      VertexId to) const {
+    if (from >= routes_table_.vertex_count || to >= routes_table_.vertex_count) {
+        throw std::out_of_range("Vertex is out of the routes table");
     }
-    const Weight weight = route_internal_data->weight;
+    // маршрут восстанавливается по одной строке from; у сжатой строки разбираются рёбра,
+    // а вес восстанавливается только у ячейки to
+    const TableEdgeId* prev_edges = nullptr;
+    std::vector<TableWeight> row_residuals;
+    std::vector<TableEdgeId> row_prev_edges;
+    Weight weight{};
+    if (!routes_table_.HasRows()) {
+        const size_t row = routes_table_.GetCell(from, 0);
+        const TableWeight table_weight = routes_table_.GetWeights()[row + to];
+        if (table_weight == Table::UNREACHABLE) {
+            return std::nullopt;
+        }
+        weight = static_cast<Weight>(table_weight);
+        prev_edges = routes_table_.GetPrevEdges() + row;
+    } else {
+        const char* row = routes_table_.external_rows + routes_table_.external_row_offsets[from];
+        const size_t row_size = routes_table_.external_row_offsets[from + 1] - routes_table_.external_row_offsets[from];
+        row_residuals.resize(routes_table_.vertex_count);
+        row_prev_edges.resize(routes_table_.vertex_count);
+        table_rows::ParseRow(row, row_size, routes_table_.vertex_count, graph_.GetEdgeCount(),
+                             row_residuals.data(), row_prev_edges.data());
+        if (!table_rows::IsReachable(row, to)) {
+            return std::nullopt;
+        }
+        weight = static_cast<Weight>(table_rows::ResolveWeight(row_residuals.data(), row_prev_edges.data(),
+                                                               routes_table_.vertex_count, graph_, to));
+        prev_edges = row_prev_edges.data();
+    }
+
     std::vector<EdgeId> edges;
-    for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge;
-         edge_id;
-         edge_id = routes_internal_data_[from][graph_.GetEdge(*edge_id).from]->prev_edge)
+    for (TableEdgeId edge_id = prev_edges[to];
+         edge_id != NO_EDGE;
+         edge_id = prev_edges[graph_.GetEdge(edge_id).from])
     {
-        edges.push_back(*edge_id);
+        edges.push_back(edge_id);
     }
     std::reverse(edges.begin(), edges.end());
 
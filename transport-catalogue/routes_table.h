@@ -0,0 +1,82 @@
+#pragma once
+
+#include "graph.h"
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace graph {
+
+// В таблице маршрутов номера рёбер хранятся в 32 битах
+using TableEdgeId = std::uint32_t;
+inline constexpr TableEdgeId NO_EDGE = std::numeric_limits<TableEdgeId>::max();
+
+/*
+ * Таблица кратчайших путей между всеми парами вершин: две непрерывные построчные плоскости
+ * vertex_count x vertex_count - веса маршрутов и последние рёбра маршрутов.
+ * Отсутствие маршрута - вес UNREACHABLE (+inf), отсутствие ребра - NO_EDGE.
+ * Разрядность весов задаётся параметром шаблона (float или double).
+ * Плоскости либо свои (weights, prev_edges), либо лежат во внешней памяти только для чтения,
+ * например в отображённом файле базы (storage держит её, пока жива таблица). Во внешней памяти
+ * таблица может лежать и сжатыми строками (см. routes_table_rows.h): тогда плоскостей нет,
+ * а строка from - байты [row_offsets[from], row_offsets[from + 1]) массива rows
+ */
+template <typename Weight>
+struct RoutesTable {
+    static_assert(std::numeric_limits<Weight>::has_infinity, "Weight should have an infinity value");
+    static constexpr Weight UNREACHABLE = std::numeric_limits<Weight>::infinity();
+
+    RoutesTable() = default;
+    explicit RoutesTable(size_t vertex_count)
+        : vertex_count(vertex_count)
+        , weights(vertex_count * vertex_count, UNREACHABLE)
+        , prev_edges(vertex_count * vertex_count, NO_EDGE) {
+    }
+
+    // Таблица над чужой памятью: плоскости не копируются
+    RoutesTable(size_t vertex_count, std::shared_ptr<const void> storage,
+                const Weight* external_weights, const TableEdgeId* external_prev_edges)
+        : vertex_count(vertex_count)
+        , storage(std::move(storage))
+        , external_weights(external_weights)
+        , external_prev_edges(external_prev_edges) {
+    }
+
+    // Таблица над сжатыми строками в чужой памяти
+    RoutesTable(size_t vertex_count, std::shared_ptr<const void> storage,
+                const std::uint64_t* external_row_offsets, const char* external_rows)
+        : vertex_count(vertex_count)
+        , storage(std::move(storage))
+        , external_row_offsets(external_row_offsets)
+        , external_rows(external_rows) {
+    }
+
+    bool HasRows() const {
+        return external_rows != nullptr;
+    }
+
+    size_t GetCell(VertexId from, VertexId to) const {
+        return from * vertex_count + to;
+    }
+
+    const Weight* GetWeights() const {
+        return external_weights != nullptr ? external_weights : weights.data();
+    }
+    const TableEdgeId* GetPrevEdges() const {
+        return external_prev_edges != nullptr ? external_prev_edges : prev_edges.data();
+    }
+
+    size_t vertex_count = 0;
+    std::vector<Weight> weights;
+    std::vector<TableEdgeId> prev_edges;
+
+    std::shared_ptr<const void> storage;
+    const Weight* external_weights = nullptr;
+    const TableEdgeId* external_prev_edges = nullptr;
+    const std::uint64_t* external_row_offsets = nullptr;
+    const char* external_rows = nullptr;
+};
+
+}  // namespace graph
@@ -0,0 +1,309 @@
+#pragma once
+
+#include "graph.h"
+#include "routes_table.h"
+#include "routes_table_rows.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <stdexcept>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+/*
+ * Восстановление таблицы маршрутов после изменения графа (база с наложенным изменением make_delta)
+ * без пересчёта всех пар. Ребро прежнего графа остаётся в новом, если в нём есть ребро с теми же
+ * концами, весом, названием и числом остановок; остальные рёбра нового графа - новые.
+ * Строка прежней вершины s переносится в новые номера вершин и рёбер. Маршрут до вершины, на котором
+ * осталось каждое ребро, есть и в новом графе; остальные вершины (поддеревья под удалёнными рёбрами
+ * дерева маршрутов) получают веса по входящим рёбрам из сохранившихся вершин. Затем от них и от концов
+ * новых рёбер (u, v, w) с d(s, u) + w < d(s, v) уменьшения весов распространяются, как в алгоритме
+ * Дейкстры: работа пропорциональна части строки, которую изменение действительно затронуло.
+ * Веса сохранившихся маршрутов удалением рёбер не уменьшаются, поэтому в конце все рёбра удовлетворяют
+ * неравенству треугольника и веса строки - кратчайшие. Строки новых вершин считаются алгоритмом Дейкстры
+ */
+namespace table_repair {
+
+// vertex_map: вершины, которых нет в новом графе
+inline constexpr VertexId REMOVED_VERTEX = std::numeric_limits<VertexId>::max();
+
+// Номера рёбер base_graph в graph, NO_EDGE - ребро не осталось. vertex_map[v] - номер вершины v
+// прежнего графа в новом или REMOVED_VERTEX
+template <typename Weight>
+std::vector<TableEdgeId> MapEdges(const DirectedWeightedGraph<Weight>& graph,
+                                  const DirectedWeightedGraph<Weight>& base_graph,
+                                  const std::vector<VertexId>& vertex_map) {
+    using Key = std::tuple<VertexId, VertexId, size_t, Weight, std::string_view>;
+    auto get_key = [](const DirectedWeightedGraph<Weight>& g, const Edge<Weight>& edge, VertexId from, VertexId to) {
+        return Key{from, to, edge.span_count, edge.weight, g.GetName(edge.name_id)};
+    };
+
+    // рёбра нового графа, упорядоченные по ключу: прежнее ребро ищется двоичным поиском
+    std::vector<std::pair<Key, TableEdgeId>> edges;
+    edges.reserve(graph.GetEdgeCount());
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        const auto& edge = graph.GetEdge(edge_id);
+        edges.emplace_back(get_key(graph, edge, edge.from, edge.to), static_cast<TableEdgeId>(edge_id));
+    }
+    std::sort(edges.begin(), edges.end());
+
+    std::vector<TableEdgeId> edge_map(base_graph.GetEdgeCount(), NO_EDGE);
+    for (EdgeId edge_id = 0; edge_id < base_graph.GetEdgeCount(); ++edge_id) {
+        const auto& edge = base_graph.GetEdge(edge_id);
+        const VertexId from = vertex_map.at(edge.from);
+        const VertexId to = vertex_map.at(edge.to);
+        if (from == REMOVED_VERTEX || to == REMOVED_VERTEX) {
+            continue;
+        }
+        const Key key = get_key(base_graph, edge, from, to);
+        const auto it = std::lower_bound(edges.begin(), edges.end(), key, [](const auto& item, const Key& value) {
+            return item.first < value;
+        });
+        if (it != edges.end() && it->first == key) {
+            edge_map[edge_id] = it->second;
+        }
+    }
+    return edge_map;
+}
+
+// Строка from таблицы алгоритмом Дейкстры: weights и prev_edges - её vertex_count ячеек
+template <typename Weight, typename TableWeight>
+void ComputeRow(const DirectedWeightedGraph<Weight>& graph, VertexId from,
+                TableWeight* weights, TableEdgeId* prev_edges, std::vector<Weight>& distances) {
+    using QueueItem = std::pair<Weight, VertexId>;
+    const size_t vertex_count = graph.GetVertexCount();
+    distances.assign(vertex_count, std::numeric_limits<Weight>::infinity());
+    std::fill(prev_edges, prev_edges + vertex_count, NO_EDGE);
+    std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+    distances[from] = Weight{};
+    queue.push({Weight{}, from});
+    while (!queue.empty()) {
+        const auto [weight, vertex] = queue.top();
+        queue.pop();
+        if (weight > distances[vertex]) { // устаревшая запись в очереди
+            continue;
+        }
+        for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+            const auto& edge = graph.GetEdge(edge_id);
+            if (edge.weight < Weight{}) {
+                throw std::domain_error("Edges' weights should be non-negative");
+            }
+            const Weight candidate_weight = weight + edge.weight;
+            if (candidate_weight < distances[edge.to]) {
+                distances[edge.to] = candidate_weight;
+                prev_edges[edge.to] = static_cast<TableEdgeId>(edge_id);
+                queue.push({candidate_weight, edge.to});
+            }
+        }
+    }
+    for (size_t to = 0; to < vertex_count; ++to) {
+        weights[to] = distances[to] == std::numeric_limits<Weight>::infinity()
+                      ? RoutesTable<TableWeight>::UNREACHABLE
+                      : static_cast<TableWeight>(distances[to]);
+    }
+}
+
+// Ребра графа, входящие в каждую вершину: in_edges[in_offsets[v] .. in_offsets[v + 1])
+struct IncomingEdges {
+    std::vector<size_t> in_offsets;
+    std::vector<EdgeId> in_edges;
+};
+
+template <typename Weight>
+IncomingEdges MakeIncomingEdges(const DirectedWeightedGraph<Weight>& graph) {
+    IncomingEdges incoming;
+    incoming.in_offsets.assign(graph.GetVertexCount() + 1, 0);
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        ++incoming.in_offsets[graph.GetEdge(edge_id).to + 1];
+    }
+    for (size_t vertex = 0; vertex < graph.GetVertexCount(); ++vertex) {
+        incoming.in_offsets[vertex + 1] += incoming.in_offsets[vertex];
+    }
+    incoming.in_edges.resize(graph.GetEdgeCount());
+    std::vector<size_t> positions(incoming.in_offsets.begin(), incoming.in_offsets.end() - 1);
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        incoming.in_edges[positions[graph.GetEdge(edge_id).to]++] = edge_id;
+    }
+    return incoming;
+}
+
+// Доводит строку до кратчайших путей нового графа. distances - веса строки, у вершин broken - +inf:
+// их маршруты потеряли рёбра. Веса вершин broken берутся по входящим рёбрам из остальных вершин,
+// затем уменьшения весов от них и от новых рёбер распространяются, как в алгоритме Дейкстры.
+// weights и prev_edges меняются только у вершин с новым весом
+template <typename Weight, typename TableWeight>
+void RepairRow(const DirectedWeightedGraph<Weight>& graph, const IncomingEdges& incoming,
+               const std::vector<EdgeId>& new_edges, const std::vector<VertexId>& broken,
+               std::vector<Weight>& distances, TableWeight* weights, TableEdgeId* prev_edges) {
+    using QueueItem = std::pair<Weight, VertexId>;
+    std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+    auto relax = [&](EdgeId edge_id) {
+        const auto& edge = graph.GetEdge(edge_id);
+        if (edge.weight < Weight{}) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+        const Weight candidate_weight = distances[edge.from] + edge.weight;
+        if (candidate_weight < distances[edge.to]) {
+            distances[edge.to] = candidate_weight;
+            weights[edge.to] = static_cast<TableWeight>(candidate_weight);
+            prev_edges[edge.to] = static_cast<TableEdgeId>(edge_id);
+            queue.push({candidate_weight, edge.to});
+        }
+    };
+    for (const VertexId vertex : broken) {
+        for (size_t i = incoming.in_offsets[vertex]; i < incoming.in_offsets[vertex + 1]; ++i) {
+            relax(incoming.in_edges[i]);
+        }
+    }
+    for (const EdgeId edge_id : new_edges) {
+        relax(edge_id);
+    }
+    while (!queue.empty()) {
+        const auto [weight, vertex] = queue.top();
+        queue.pop();
+        if (weight > distances[vertex]) { // устаревшая запись в очереди
+            continue;
+        }
+        for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+            relax(edge_id);
+        }
+    }
+}
+
+// Заполняет таблицу table графа graph по таблице base_table прежнего графа base_graph.
+// Возвращает число строк, посчитанных заново (строки новых вершин)
+template <typename Weight, typename TableWeight>
+size_t RepairAllPairs(RoutesTable<TableWeight>& table,
+                      const DirectedWeightedGraph<Weight>& graph,
+                      const DirectedWeightedGraph<Weight>& base_graph,
+                      const RoutesTable<TableWeight>& base_table,
+                      const std::vector<VertexId>& vertex_map,
+                      concurrency::ThreadPool* pool) {
+    const size_t vertex_count = graph.GetVertexCount();
+    const size_t base_vertex_count = base_table.vertex_count;
+    if (base_graph.GetVertexCount() != base_vertex_count || vertex_map.size() != base_vertex_count) {
+        throw std::invalid_argument("Routes table does not match the graph");
+    }
+    const std::vector<TableEdgeId> edge_map = MapEdges(graph, base_graph, vertex_map);
+    const IncomingEdges incoming = MakeIncomingEdges(graph);
+
+    // новые рёбра - не доставшиеся ни одному прежнему
+    std::vector<bool> is_kept_edge(graph.GetEdgeCount(), false);
+    for (const TableEdgeId edge_id : edge_map) {
+        if (edge_id != NO_EDGE) {
+            is_kept_edge[edge_id] = true;
+        }
+    }
+    std::vector<EdgeId> new_edges;
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        if (!is_kept_edge[edge_id]) {
+            new_edges.push_back(edge_id);
+        }
+    }
+
+    std::vector<std::uint8_t> is_repaired_row(vertex_count, 0);
+    auto repair_rows = [&](size_t rows_begin, size_t rows_end) {
+        enum : std::uint8_t { UNKNOWN, KEPT, BROKEN, IN_CHAIN };
+        std::vector<TableWeight> weights(base_vertex_count);
+        std::vector<TableEdgeId> prev_edges(base_vertex_count);
+        std::vector<std::uint8_t> states(base_vertex_count);
+        std::vector<VertexId> chain;
+        std::vector<VertexId> broken;
+        std::vector<Weight> distances;
+        for (VertexId from = rows_begin; from < rows_end; ++from) {
+            if (vertex_map[from] == REMOVED_VERTEX) {
+                continue;
+            }
+            if (base_table.HasRows()) {
+                const std::uint64_t row_begin = base_table.external_row_offsets[from];
+                table_rows::DecodeRow(base_table.external_rows + row_begin, base_table.external_row_offsets[from + 1] - row_begin,
+                                      base_vertex_count, base_graph, weights.data(), prev_edges.data());
+            } else {
+                const size_t row = base_table.GetCell(from, 0);
+                std::copy_n(base_table.GetWeights() + row, base_vertex_count, weights.begin());
+                std::copy_n(base_table.GetPrevEdges() + row, base_vertex_count, prev_edges.begin());
+            }
+
+            // маршрут сохранился, если все рёбра на нём от корня остались в графе
+            std::fill(states.begin(), states.end(), UNKNOWN);
+            for (VertexId to = 0; to < base_vertex_count; ++to) {
+                VertexId vertex = to;
+                while (states[vertex] == UNKNOWN) {
+                    if (prev_edges[vertex] == NO_EDGE) {
+                        states[vertex] = KEPT;
+                    } else if (edge_map[prev_edges[vertex]] == NO_EDGE) {
+                        states[vertex] = BROKEN;
+                    } else {
+                        states[vertex] = IN_CHAIN;
+                        chain.push_back(vertex);
+                        vertex = base_graph.GetEdge(prev_edges[vertex]).from;
+                    }
+                }
+                if (states[vertex] == IN_CHAIN) {
+                    throw std::runtime_error("Routes table row has an inconsistent route tree");
+                }
+                for (const VertexId chain_vertex : chain) {
+                    states[chain_vertex] = states[vertex];
+                }
+                chain.clear();
+            }
+
+            const size_t row = table.GetCell(vertex_map[from], 0);
+            distances.assign(vertex_count, std::numeric_limits<Weight>::infinity());
+            broken.clear();
+            for (VertexId to = 0; to < base_vertex_count; ++to) {
+                const VertexId vertex = vertex_map[to];
+                if (vertex == REMOVED_VERTEX || weights[to] == RoutesTable<TableWeight>::UNREACHABLE) {
+                    continue;
+                }
+                if (states[to] == BROKEN) {
+                    broken.push_back(vertex);
+                    continue;
+                }
+                distances[vertex] = static_cast<Weight>(weights[to]);
+                table.weights[row + vertex] = weights[to];
+                table.prev_edges[row + vertex] = prev_edges[to] == NO_EDGE ? NO_EDGE : edge_map[prev_edges[to]];
+            }
+            RepairRow(graph, incoming, new_edges, broken, distances, table.weights.data() + row, table.prev_edges.data() + row);
+            is_repaired_row[vertex_map[from]] = 1;
+        }
+    };
+
+    std::vector<VertexId> computed_rows;
+    auto compute_rows = [&](size_t begin, size_t end) {
+        std::vector<Weight> distances;
+        for (size_t i = begin; i < end; ++i) {
+            const size_t row = table.GetCell(computed_rows[i], 0);
+            ComputeRow(graph, computed_rows[i], table.weights.data() + row, table.prev_edges.data() + row, distances);
+        }
+    };
+
+    if (pool != nullptr) {
+        pool->ParallelFor(0, base_vertex_count, repair_rows);
+    } else {
+        repair_rows(0, base_vertex_count);
+    }
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        if (!is_repaired_row[vertex]) {
+            computed_rows.push_back(vertex);
+        }
+    }
+    if (pool != nullptr) {
+        pool->ParallelFor(0, computed_rows.size(), compute_rows);
+    } else {
+        compute_rows(0, computed_rows.size());
+    }
+    return computed_rows.size();
+}
+
+}  // namespace table_repair
+
+}  // namespace graph
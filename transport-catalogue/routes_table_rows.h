@@ -0,0 +1,221 @@
+#pragma once
+
+#include "graph.h"
+#include "routes_table.h"
+
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace graph {
+
+/*
+ * Построчное сжатие таблицы маршрутов без потерь. Каждая строка from кодируется независимо от остальных,
+ * так что запросу маршрута достаточно декодировать одну строку:
+ *  - битовая карта достижимых вершин (бит to - вес не UNREACHABLE; у недостижимых ребро NO_EDGE);
+ *  - для каждой достижимой вершины по возрастанию номера - последнее ребро маршрута (номер + 1, 0 - NO_EDGE)
+ *    zigzag-varint разностью с ребром предыдущей достижимой вершины и вес.
+ * Вес предсказывается по дереву маршрутов строки: вес до начала последнего ребра плюс вес ребра.
+ * Пишется zigzag-varint разность двоичных представлений веса и предсказания - число единиц последнего
+ * разряда между ними. Обычно она 0 или мала, а любой вес восстанавливается точно.
+ * Строка разбирается за O(vertex_count) по тому же графу, по которому строилась таблица;
+ * вес одной ячейки восстанавливается за O(длины её маршрута)
+ */
+namespace table_rows {
+
+namespace detail {
+
+template <typename Weight>
+using WeightBits = std::conditional_t<sizeof(Weight) == sizeof(std::uint64_t), std::uint64_t, std::uint32_t>;
+
+template <typename Weight>
+WeightBits<Weight> ToBits(Weight weight) {
+    static_assert(sizeof(Weight) == sizeof(WeightBits<Weight>), "Table weights should be float or double");
+    WeightBits<Weight> bits;
+    std::memcpy(&bits, &weight, sizeof(bits));
+    return bits;
+}
+
+template <typename Weight>
+Weight FromBits(WeightBits<Weight> bits) {
+    Weight weight;
+    std::memcpy(&weight, &bits, sizeof(weight));
+    return weight;
+}
+
+inline std::uint64_t ZigZag(std::int64_t value) {
+    return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+}
+
+inline std::int64_t UnZigZag(std::uint64_t value) {
+    return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+}
+
+inline void WriteVarint(std::string& out, std::uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+inline std::uint64_t ReadVarint(const char*& data, const char* end) {
+    std::uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (data == end) {
+            break;
+        }
+        const auto byte = static_cast<std::uint8_t>(*data++);
+        value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return value;
+        }
+    }
+    throw std::runtime_error("Routes table row is truncated");
+}
+
+inline std::uint64_t EncodeEdge(TableEdgeId edge) {
+    return edge == NO_EDGE ? 0 : static_cast<std::uint64_t>(edge) + 1;
+}
+
+}  // namespace detail
+
+// Дописывает в out строку таблицы: weights и prev_edges - её vertex_count ячеек
+template <typename Weight, typename GraphWeight>
+void EncodeRow(const Weight* weights, const TableEdgeId* prev_edges, size_t vertex_count,
+               const DirectedWeightedGraph<GraphWeight>& graph, std::string& out) {
+    using namespace detail;
+    const size_t bitmap_begin = out.size();
+    out.resize(bitmap_begin + (vertex_count + 7) / 8, '\0');
+    std::uint64_t previous_edge = 0;
+    for (size_t to = 0; to < vertex_count; ++to) {
+        if (weights[to] == RoutesTable<Weight>::UNREACHABLE) {
+            continue;
+        }
+        out[bitmap_begin + to / 8] = static_cast<char>(out[bitmap_begin + to / 8] | (1 << (to % 8)));
+
+        const std::uint64_t edge = EncodeEdge(prev_edges[to]);
+        WriteVarint(out, ZigZag(static_cast<std::int64_t>(edge - previous_edge)));
+        previous_edge = edge;
+
+        Weight predicted{};
+        if (prev_edges[to] != NO_EDGE) {
+            const auto& graph_edge = graph.GetEdge(prev_edges[to]);
+            if (graph_edge.from >= vertex_count || weights[graph_edge.from] == RoutesTable<Weight>::UNREACHABLE) {
+                throw std::invalid_argument("Routes table row is inconsistent with the graph");
+            }
+            predicted = weights[graph_edge.from] + static_cast<Weight>(graph_edge.weight);
+        }
+        const auto residual = static_cast<std::make_signed_t<WeightBits<Weight>>>(ToBits(weights[to]) - ToBits(predicted));
+        WriteVarint(out, ZigZag(residual));
+    }
+}
+
+inline bool IsReachable(const char* data, VertexId to) {
+    return (static_cast<std::uint8_t>(data[to / 8]) & (1 << (to % 8))) != 0;
+}
+
+// Разбирает строку из [data, data + size): prev_edges восстанавливаются полностью, у недостижимых вершин
+// вес UNREACHABLE, а в весах достижимых остаются разности с предсказанием (см. ResolveWeight).
+// Повреждённая строка - std::runtime_error
+template <typename Weight>
+void ParseRow(const char* data, size_t size, size_t vertex_count, size_t edge_count,
+              Weight* weights, TableEdgeId* prev_edges) {
+    using namespace detail;
+    const char* const end = data + size;
+    const size_t bitmap_size = (vertex_count + 7) / 8;
+    if (size < bitmap_size) {
+        throw std::runtime_error("Routes table row is truncated");
+    }
+    const char* const bitmap = data;
+    data += bitmap_size;
+
+    std::uint64_t previous_edge = 0;
+    for (size_t to = 0; to < vertex_count; ++to) {
+        if (!IsReachable(bitmap, static_cast<VertexId>(to))) {
+            weights[to] = RoutesTable<Weight>::UNREACHABLE;
+            prev_edges[to] = NO_EDGE;
+            continue;
+        }
+        const std::uint64_t edge = previous_edge + static_cast<std::uint64_t>(UnZigZag(ReadVarint(data, end)));
+        if (edge > edge_count) {
+            throw std::runtime_error("Routes table row refers to a missing edge");
+        }
+        previous_edge = edge;
+        prev_edges[to] = edge == 0 ? NO_EDGE : static_cast<TableEdgeId>(edge - 1);
+        weights[to] = FromBits<Weight>(static_cast<WeightBits<Weight>>(UnZigZag(ReadVarint(data, end))));
+    }
+}
+
+// Вес достижимой вершины to разобранной ParseRow строки: разности складываются с предсказаниями
+// от корня дерева маршрутов вдоль маршрута до to, за O(длины маршрута)
+template <typename Weight, typename GraphWeight>
+Weight ResolveWeight(const Weight* residuals, const TableEdgeId* prev_edges, size_t vertex_count,
+                     const DirectedWeightedGraph<GraphWeight>& graph, VertexId to) {
+    using namespace detail;
+    // вершины маршрута от to к корню
+    std::vector<VertexId> chain{to};
+    while (prev_edges[chain.back()] != NO_EDGE) {
+        const VertexId parent = graph.GetEdge(prev_edges[chain.back()]).from;
+        if (parent >= vertex_count || chain.size() == vertex_count) {
+            throw std::runtime_error("Routes table row has an inconsistent route tree");
+        }
+        chain.push_back(parent);
+    }
+    Weight weight = FromBits<Weight>(ToBits(Weight{}) + ToBits(residuals[chain.back()]));
+    for (auto it = std::next(chain.rbegin()); it != chain.rend(); ++it) {
+        const Weight predicted = weight + static_cast<Weight>(graph.GetEdge(prev_edges[*it]).weight);
+        weight = FromBits<Weight>(ToBits(predicted) + ToBits(residuals[*it]));
+    }
+    return weight;
+}
+
+// Восстанавливает строку таблицы из [data, data + size) в weights и prev_edges по vertex_count ячеек.
+// Повреждённая строка - std::runtime_error
+template <typename Weight, typename GraphWeight>
+void DecodeRow(const char* data, size_t size, size_t vertex_count,
+               const DirectedWeightedGraph<GraphWeight>& graph, Weight* weights, TableEdgeId* prev_edges) {
+    using namespace detail;
+    ParseRow(data, size, vertex_count, graph.GetEdgeCount(), weights, prev_edges);
+
+    // веса восстанавливаются от корня дерева маршрутов: сначала вершина, из которой выходит последнее ребро
+    enum : std::uint8_t { UNREACHABLE, PENDING, IN_CHAIN, RESOLVED };
+    std::vector<std::uint8_t> states(vertex_count, UNREACHABLE);
+    for (size_t to = 0; to < vertex_count; ++to) {
+        if (IsReachable(data, static_cast<VertexId>(to))) {
+            states[to] = PENDING;
+        }
+    }
+    std::vector<VertexId> chain;
+    for (size_t to = 0; to < vertex_count; ++to) {
+        for (VertexId vertex = static_cast<VertexId>(to); states[vertex] == PENDING;) {
+            states[vertex] = IN_CHAIN;
+            chain.push_back(vertex);
+            if (prev_edges[vertex] == NO_EDGE) {
+                break;
+            }
+            vertex = graph.GetEdge(prev_edges[vertex]).from;
+            if (vertex >= vertex_count || states[vertex] == UNREACHABLE || states[vertex] == IN_CHAIN) {
+                throw std::runtime_error("Routes table row has an inconsistent route tree");
+            }
+        }
+        for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+            Weight predicted{};
+            if (prev_edges[*it] != NO_EDGE) {
+                const auto& graph_edge = graph.GetEdge(prev_edges[*it]);
+                predicted = weights[graph_edge.from] + static_cast<Weight>(graph_edge.weight);
+            }
+            weights[*it] = FromBits<Weight>(ToBits(predicted) + ToBits(weights[*it]));
+            states[*it] = RESOLVED;
+        }
+        chain.clear();
+    }
+}
+
+}  // namespace table_rows
+
+}  // namespace graph
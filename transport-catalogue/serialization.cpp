@@ -1,87 +1,790 @@
 #include "serialization.h"
 #include "json_builder.h"
+#include "log_duration.h"
+#include "thread_pool.h"
+
+#include <google/protobuf/arena.h>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl.h>
+#include <google/protobuf/wire_format_lite.h>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
 
 namespace serialization {
 
+using namespace std::literals;
+
+namespace {
+
+// Читает часть базы с замером; ненужная часть не читается и остаётся пустой
+template <typename Result, typename Func>
+Result DeserializeSection(bool is_needed, const std::string& name, std::ostream* timings, Func func) {
+    if (!is_needed) {
+        if (timings != nullptr) {
+            *timings << name + ": skipped\n" << std::flush;
+        }
+        return Result();
+    }
+    return timing::Measure(name, timings, func);
+}
+
+}  // namespace
+
+DatabaseFormat ParseDatabaseFormat(std::string_view name) {
+    if (name == "protobuf"sv) {
+        return DatabaseFormat::PROTOBUF;
+    } else if (name == "flat"sv) {
+        return DatabaseFormat::FLAT;
+    }
+    throw std::invalid_argument("Unknown database format: "s + std::string(name));
+}
+
+bool operator==(const InputHashes& lhs, const InputHashes& rhs) {
+    return lhs.stops == rhs.stops && lhs.buses == rhs.buses
+           && lhs.routing_settings == rhs.routing_settings && lhs.render_settings == rhs.render_settings;
+}
+
+DatabaseSections FindUnchangedSections(const InputHashes& previous, const InputHashes& current) {
+    DatabaseSections sections;
+    sections.transport_catalogue = previous.stops == current.stops && previous.buses == current.buses;
+    sections.map_renderer = previous.render_settings == current.render_settings;
+    sections.transport_router = sections.transport_catalogue && previous.routing_settings == current.routing_settings;
+    return sections;
+}
+
 void TransportCatalogueExport::Serialize(const std::filesystem::path& path,
                                          const transport::TransportCatalogue& transport_catalogue,
                                          const map_renderer::MapRenderer& map_renderer,
-                                         const router::TransportRouter& transport_router) const {
-    std::ofstream out_file(path, std::ios::binary);
-    transport_catalogue::TransportCatalogue transport_catalogue_export;
+                                         const router::TransportRouter& transport_router,
+                                         DatabaseFormat format,
+                                         const std::optional<InputHashes>& input_hashes) const {
+    std::filesystem::path temp_path = path;
+    temp_path += ".tmp";
+    {
+        std::ofstream out_file(temp_path, std::ios::binary);
+        if (format == DatabaseFormat::FLAT) {
+            SerializeFlat(out_file, transport_catalogue, map_renderer, transport_router, input_hashes);
+        } else {
+            const size_t message_size = SerializeProto(out_file, transport_catalogue, map_renderer, transport_router, input_hashes);
+            if (transport_router.GetRouter()) {
+                WriteRoutesTableSection(out_file, message_size, transport_router);
+            }
+        }
+        out_file.close();
+        if (!out_file) {
+            std::filesystem::remove(temp_path);
+            throw std::runtime_error("Failed to write database " + temp_path.string());
+        }
+    }
+    std::filesystem::rename(temp_path, path);
+}
+
+size_t TransportCatalogueExport::SerializeProto(std::ostream& out,
+                                                const transport::TransportCatalogue& transport_catalogue,
+                                                const map_renderer::MapRenderer& map_renderer,
+                                                const router::TransportRouter& transport_router,
+                                                const std::optional<InputHashes>& input_hashes) const {
+    using Proto = transport_catalogue::TransportCatalogue;
+    // таблица строк: названия остановок по номерам, так что номер строки остановки - её номер, за ними
+    // названия автобусов. Названия рёбер графа - обычно названия автобусов, в таблицу дописываются только новые
+    const size_t stop_count = transport_catalogue.GetCountStops();
+    std::vector<std::string_view> names;
+    names.reserve(stop_count + transport_catalogue.GetCountBuses());
+    for (transport::StopId stop = 0; stop < stop_count; ++stop) {
+        names.push_back(transport_catalogue.GetStopName(stop));
+    }
+    for (transport::BusId bus = 0; bus < transport_catalogue.GetCountBuses(); ++bus) {
+        names.push_back(transport_catalogue.GetBusName(bus));
+    }
+    std::unordered_map<std::string_view, std::uint32_t> name_numbers;
+    name_numbers.reserve(names.size());
+    for (size_t i = 0; i < names.size(); ++i) {
+        name_numbers.emplace(names[i], static_cast<std::uint32_t>(i));
+    }
+    const auto& graph = transport_router.GetGraph();
+    std::vector<std::uint32_t> name_refs;
+    name_refs.reserve(graph.GetNameCount());
+    for (graph::NameId name_id = 0; name_id < graph.GetNameCount(); ++name_id) {
+        const auto [it, is_new] = name_numbers.emplace(graph.GetName(name_id), static_cast<std::uint32_t>(names.size()));
+        if (is_new) {
+            names.push_back(it->first);
+        }
+        name_refs.push_back(it->second);
+    }
+    const ExplicitDistances distances = MakeExplicitDistances(transport_catalogue);
+
+    google::protobuf::io::OstreamOutputStream output(&out);
+    google::protobuf::io::CodedOutputStream coded_output(&output);
+    // поля пишутся по возрастанию номеров, как их писал бы сгенерированный код
+    proto_stream::Sink sink(&coded_output);
+    sink.WriteMessage(Proto::kMapRendererFieldNumber, SerializeMapRenderer(map_renderer));
+    sink.WriteNested(Proto::kTransportRouterFieldNumber, [&](proto_stream::Sink& transport_router_sink) {
+        WriteTransportRouterProto(transport_router_sink, transport_router, name_refs);
+    });
+    sink.WriteVarint(Proto::kVersionFieldNumber, PROTO_VERSION);
+    for (const std::string_view name : names) {
+        sink.WriteString(Proto::kNamesFieldNumber, name);
+    }
+    sink.WriteNested(Proto::kCatalogueFieldNumber, [&](proto_stream::Sink& catalogue_sink) {
+        WriteTransportCatalogueProtoCatalogue(catalogue_sink, transport_catalogue, distances);
+    });
+    sink.WriteVarint(Proto::kStopCountFieldNumber, stop_count);
+    if (input_hashes) {
+        sink.WriteMessage(Proto::kInputHashesFieldNumber, MakeInputHashesProto(*input_hashes));
+    }
+    return sink.GetSize();
+}
+
+TransportCatalogueExport::DesTransportCatalogue TransportCatalogueExport::Deserialize(const std::filesystem::path& path,
+                                                                                     const DatabaseSections& sections,
+                                                                                     std::ostream* timings) const {
+    // отображаем файл в память: сообщение разбирается из него, таблица маршрутов остаётся в нём
+    const auto file = std::make_shared<const MappedFile>(path);
+    if (flat::Reader::IsFlat(*file)) {
+        return DeserializeFlat(file, sections, timings);
+    }
+    const auto table_section = ReadTableSection(*file);
+    const size_t message_size = table_section ? table_section->message_size : file->GetSize();
+    const MessageParts parts = timing::Measure("Deserialization: message scan", timings, [&] {
+        return ScanTransportCatalogueProto(file->GetData(), message_size);
+    });
+    if (parts.version > PROTO_VERSION) {
+        throw std::runtime_error("Unsupported database version " + std::to_string(parts.version));
+    }
+
+    // части разбираются и восстанавливаются параллельно: маршрутизатору от справочника нужно только число остановок
+    concurrency::ThreadPool pool;
+    // большие массивы справочника и графа читаются из файла прямо в свои векторы, а оставшиеся сообщения
+    // разбираются на арене: её память освобождается разом, как только часть восстановлена
+    auto map_renderer_future = pool.Submit([&] {
+        return DeserializeSection<map_renderer::MapRenderer>(
+            sections.map_renderer, "Deserialization: map renderer", timings, [&] {
+                google::protobuf::Arena arena;
+                auto* transport_catalogue_import = google::protobuf::Arena::CreateMessage<transport_catalogue::TransportCatalogue>(&arena);
+                ParseTransportCatalogueProtoFields(file->GetData(), parts.map_renderer, *transport_catalogue_import);
+                return DeserializeMapRenderer(*transport_catalogue_import);
+            });
+    });
+    auto transport_router_future = pool.Submit([&] {
+        return DeserializeSection<router::TransportRouter>(
+            sections.transport_router && sections.transport_catalogue, "Deserialization: transport router", timings, [&] {
+                return DeserializeTransportRouter(file->GetData(), parts.transport_router, parts.stop_count, file, table_section);
+            });
+    });
+    transport::TransportCatalogue transport_catalogue = DeserializeSection<transport::TransportCatalogue>(
+        sections.transport_catalogue, "Deserialization: transport catalogue", timings, [&] {
+            if (parts.version >= 2) {
+                return DeserializeTransportCatalogueV2(file->GetData(), parts.transport_catalogue);
+            }
+            google::protobuf::Arena arena;
+            auto* transport_catalogue_import = google::protobuf::Arena::CreateMessage<transport_catalogue::TransportCatalogue>(&arena);
+            ParseTransportCatalogueProtoFields(file->GetData(), parts.transport_catalogue, *transport_catalogue_import);
+            return DeserializeTransportCatalogue(*transport_catalogue_import);
+        });
 
-    *transport_catalogue_export.mutable_stops() = MakeTransportCatalogueProtoStops(transport_catalogue).stops();
-    *transport_catalogue_export.mutable_buses() = MakeTransportCatalogueProtoBuses(transport_catalogue).buses();
-    *transport_catalogue_export.mutable_map_renderer() = SerializeMapRenderer(map_renderer);
-    *transport_catalogue_export.mutable_transport_router() = SerializeTransportRouter(transport_router);
+    return DesTransportCatalogue{std::move(transport_catalogue),
+                                 map_renderer_future.get(),
+                                 transport_router_future.get()
+    };
+}
+
+std::optional<InputHashes> TransportCatalogueExport::ReadInputHashes(const std::filesystem::path& path) const {
+    std::error_code error;
+    if (!std::filesystem::is_regular_file(path, error)) {
+        return std::nullopt;
+    }
+    try {
+        const auto file = std::make_shared<const MappedFile>(path);
+        if (flat::Reader::IsFlat(*file)) {
+            const flat::Reader reader(file);
+            transport_catalogue::InputHashes input_hashes_import;
+            if (!reader.HasSection(INPUT_HASHES)) {
+                return std::nullopt;
+            }
+            const std::string_view input_hashes_message = reader.GetBytes(INPUT_HASHES);
+            if (!input_hashes_import.ParseFromArray(input_hashes_message.data(), static_cast<int>(input_hashes_message.size()))) {
+                return std::nullopt;
+            }
+            return DeserializeInputHashes(input_hashes_import);
+        }
+
+        const auto table_section = ReadTableSection(*file);
+        const MessageParts parts = ScanTransportCatalogueProto(file->GetData(), table_section ? table_section->message_size : file->GetSize());
+        if (parts.input_hashes.empty() || parts.version > PROTO_VERSION) {
+            return std::nullopt;
+        }
+        transport_catalogue::TransportCatalogue transport_catalogue_import;
+        ParseTransportCatalogueProtoFields(file->GetData(), parts.input_hashes, transport_catalogue_import);
+        return DeserializeInputHashes(transport_catalogue_import.input_hashes());
+    } catch (const std::exception&) {
+        return std::nullopt; // прежняя база не читается - она будет построена заново
+    }
+}
 
-    transport_catalogue_export.SerializeToOstream(&out_file);
+void TransportCatalogueExport::SerializeDelta(const std::filesystem::path& path, const DatabaseDelta& delta) const {
+    std::ofstream out_file(path, std::ios::binary);
+    if (!MakeDeltaProto(delta).SerializeToOstream(&out_file)) {
+        throw std::runtime_error("Failed to write delta " + path.string());
+    }
 }
 
-TransportCatalogueExport::DesTransportCatalogue TransportCatalogueExport::Deserialize(const std::filesystem::path& path) const {
-    // импортируем каталог в переменную из файла
+DatabaseDelta TransportCatalogueExport::DeserializeDelta(const std::filesystem::path& path) const {
     std::ifstream in_file(path, std::ios::binary);
-    transport_catalogue::TransportCatalogue transport_catalogue_import;
-    transport_catalogue_import.ParseFromIstream(&in_file);
+    transport_catalogue::Delta delta_import;
+    if (!in_file || !delta_import.ParseFromIstream(&in_file) || !delta_import.has_base_hashes()) {
+        throw std::runtime_error("Delta " + path.string() + " is not readable");
+    }
+    DatabaseDelta delta{DeserializeInputHashes(delta_import.base_hashes()), {}};
+    DeserializeTransportCatalogueStops(delta_import.stops(), delta.delta.stops);
+    DeserializeTransportCatalogueBuses(delta_import.buses(), delta.delta.buses);
+    delta.delta.removed_stops.assign(delta_import.removed_stops().begin(), delta_import.removed_stops().end());
+    delta.delta.removed_buses.assign(delta_import.removed_buses().begin(), delta_import.removed_buses().end());
+    return delta;
+}
 
-    SourceStopRequests request_stops;
-    SourceBusRequests request_buses;
-    transport::TransportCatalogue transport_catalogue = DeserializeTransportCatalogue(transport_catalogue_import,
-                                                                                     request_stops,
-                                                                                     request_buses);
-    map_renderer::MapRenderer map_renderer = DeserializeMapRenderer(transport_catalogue_import,
-                                                                   request_stops,
-                                                                   request_buses);
-    router::TransportRouter transport_router = DeserializeTransportRouter(transport_catalogue_import);
+TransportCatalogueExport::DesTransportCatalogue TransportCatalogueExport::Deserialize(const std::filesystem::path& path,
+                                                                                     const std::filesystem::path& delta_path,
+                                                                                     const DatabaseSections& sections,
+                                                                                     std::ostream* timings) const {
+    const DatabaseDelta delta = timing::Measure("Deserialization: delta", timings, [&] {
+        return DeserializeDelta(delta_path);
+    });
+    if (const auto base_hashes = ReadInputHashes(path); !base_hashes || !(*base_hashes == delta.base_hashes)) {
+        throw std::runtime_error("Delta " + delta_path.string() + " was made for another database");
+    }
+    DesTransportCatalogue base = Deserialize(path, sections, timings);
+    if (!sections.transport_catalogue) {
+        return base;
+    }
+    // справочник строится заново, маршрутизатор восстанавливается по маршрутизатору базы
+    transport::TransportCatalogue transport_catalogue = timing::Measure("Delta: transport catalogue", timings, [&] {
+        return base.transport_catalogue.ApplyDelta(delta.delta);
+    });
+    router::TransportRouter transport_router = DeserializeSection<router::TransportRouter>(
+        sections.transport_router, "Delta: transport router", timings, [&] {
+            return router::TransportRouter(base.transport_router, base.transport_catalogue, transport_catalogue);
+        });
+    return DesTransportCatalogue{std::move(transport_catalogue), std::move(base.map_renderer), std::move(transport_router)};
+}
 
-    return DesTransportCatalogue{std::move(transport_catalogue),
-                                 std::move(map_renderer),
-                                 std::move(transport_router)
+InputHashes TransportCatalogueExport::MakeCompactedInputHashes(const DatabaseDelta& delta) const {
+    // FNV-1a по сообщению изменения, продолжающий хеш базы
+    const std::string delta_message = MakeDeltaProto(delta).SerializeAsString();
+    auto mix = [&delta_message](std::uint64_t hash) {
+        for (const char byte : delta_message) {
+            hash = (hash ^ static_cast<unsigned char>(byte)) * 1099511628211ULL;
+        }
+        return hash;
     };
+    InputHashes input_hashes = delta.base_hashes;
+    input_hashes.stops = mix(input_hashes.stops);
+    input_hashes.buses = mix(input_hashes.buses);
+    return input_hashes;
 }
 
-// _______________ Serialize Transport Catalogue _______________
+TransportCatalogueExport::MessageParts TransportCatalogueExport::ScanTransportCatalogueProto(const char* data, size_t size) const {
+    using google::protobuf::internal::WireFormatLite;
+    using Proto = transport_catalogue::TransportCatalogue;
+    MessageParts parts;
+    // подряд идущие поля одной части объединяются в один диапазон
+    auto add_field = [](std::vector<FieldRange>& ranges, int begin, int end) {
+        if (!ranges.empty() && ranges.back().second == begin) {
+            ranges.back().second = end;
+        } else {
+            ranges.push_back({begin, end});
+        }
+    };
 
-transport_catalogue::TransportCatalogue TransportCatalogueExport::MakeTransportCatalogueProtoStops(const transport::TransportCatalogue& transport_catalogue) const {
-    transport_catalogue::TransportCatalogue transport_catalogue_temp;
-    for (const auto& stop_as_tc_from: transport_catalogue.GetStops()) {
-        transport_catalogue::Stop stop;
-        stop.set_name(stop_as_tc_from.stop_name);
-        stop.mutable_coordinates()->set_lat(stop_as_tc_from.stop_coordinates.lat);
-        stop.mutable_coordinates()->set_lng(stop_as_tc_from.stop_coordinates.lng);
-
-        for (const auto& stop_as_tc_to: transport_catalogue.GetStops()) {
-            auto stop_from = transport_catalogue.FindStopByName(stop_as_tc_from.stop_name);
-            auto stop_to = transport_catalogue.FindStopByName(stop_as_tc_to.stop_name);
-            auto dist = transport_catalogue.DistanceBetweenStops( {const_cast<Stop*>(stop_from), const_cast<Stop*>(stop_to)} );
-            if (dist != 0) {
-                transport_catalogue::RoadDistances rd;
-                rd.set_stop_to(stop_as_tc_to.stop_name);
-                rd.set_distance(dist);
-                *stop.add_distances() = rd;
+    // поля верхнего уровня перебираются по тегам без разбора: поле с длиной пропускается одним сдвигом.
+    // Версия и число остановок читаются сразу: от них зависит разбор частей
+    google::protobuf::io::CodedInputStream input(reinterpret_cast<const std::uint8_t*>(data), static_cast<int>(size));
+    std::optional<std::uint32_t> stop_count;
+    while (true) {
+        const int field_begin = input.CurrentPosition();
+        const std::uint32_t tag = input.ReadTag();
+        if (tag == 0) {
+            break;
+        }
+        const int field_number = WireFormatLite::GetTagFieldNumber(tag);
+        const bool is_varint = WireFormatLite::GetTagWireType(tag) == WireFormatLite::WIRETYPE_VARINT;
+        if (is_varint && (field_number == Proto::kVersionFieldNumber || field_number == Proto::kStopCountFieldNumber)) {
+            std::uint32_t value = 0;
+            if (!input.ReadVarint32(&value)) {
+                break;
             }
+            if (field_number == Proto::kVersionFieldNumber) {
+                parts.version = value;
+            } else {
+                stop_count = value;
+            }
+        } else if (!WireFormatLite::SkipField(&input, tag)) {
+            break;
+        }
+        const int field_end = input.CurrentPosition();
+        switch (field_number) {
+        case Proto::kStopsFieldNumber:
+            // make_base пишет каждую остановку справочника одним полем
+            ++parts.stop_count;
+            add_field(parts.transport_catalogue, field_begin, field_end);
+            break;
+        case Proto::kBusesFieldNumber:
+            add_field(parts.transport_catalogue, field_begin, field_end);
+            break;
+        case Proto::kMapRendererFieldNumber:
+            add_field(parts.map_renderer, field_begin, field_end);
+            break;
+        case Proto::kTransportRouterFieldNumber:
+            add_field(parts.transport_router, field_begin, field_end);
+            break;
+        case Proto::kVersionFieldNumber:
+            add_field(parts.transport_catalogue, field_begin, field_end);
+            add_field(parts.map_renderer, field_begin, field_end);
+            add_field(parts.transport_router, field_begin, field_end);
+            break;
+        case Proto::kNamesFieldNumber:
+            // на таблицу строк ссылаются и справочник, и граф
+            add_field(parts.transport_catalogue, field_begin, field_end);
+            add_field(parts.transport_router, field_begin, field_end);
+            break;
+        case Proto::kCatalogueFieldNumber:
+            add_field(parts.transport_catalogue, field_begin, field_end);
+            break;
+        case Proto::kInputHashesFieldNumber:
+            add_field(parts.input_hashes, field_begin, field_end);
+            break;
+        default:
+            break;
         }
+    }
+    if (stop_count) {
+        parts.stop_count = *stop_count;
+    }
+    return parts;
+}
 
-        *transport_catalogue_temp.add_stops() = std::move(stop);
+void TransportCatalogueExport::ParseTransportCatalogueProtoFields(const char* data, const std::vector<FieldRange>& ranges,
+                                                                  transport_catalogue::TransportCatalogue& transport_catalogue_import) const {
+    for (const auto& [begin, end] : ranges) {
+        google::protobuf::io::CodedInputStream input(reinterpret_cast<const std::uint8_t*>(data + begin), end - begin);
+        transport_catalogue_import.MergeFromCodedStream(&input);
     }
+}
+
+// _______________ Routes Table Section _______________
 
-    return transport_catalogue_temp;
+size_t TransportCatalogueExport::GetTableSectionAlignment() {
+    return std::max(MappedFile::GetPageSize(), alignof(std::uint64_t));
 }
-transport_catalogue::TransportCatalogue TransportCatalogueExport::MakeTransportCatalogueProtoBuses(const transport::TransportCatalogue& transport_catalogue) const {
-    transport_catalogue::TransportCatalogue transport_catalogue_temp;
-    for (const auto& bus_as_tc: transport_catalogue.GetBuses()) {
-        transport_catalogue::Bus bus;
-        bus.set_name(bus_as_tc.bus_name);
-        bus.set_is_roundtrip(bus_as_tc.is_roundtrip);
 
-        for (const auto stop: bus_as_tc.bus_stops) {
-            bus.add_stops(stop->stop_name);
+void TransportCatalogueExport::WriteRoutesTableSection(std::ostream& out, size_t message_size,
+                                                       const router::TransportRouter& transport_router) const {
+    auto write_padding = [&out](size_t size) {
+        static const char zeros[4096] = {};
+        while (size != 0) {
+            const size_t chunk = std::min(size, sizeof(zeros));
+            out.write(zeros, static_cast<std::streamsize>(chunk));
+            size -= chunk;
         }
+    };
 
-        *transport_catalogue_temp.add_buses() = std::move(bus);
+    const auto& routes_table = transport_router.GetRouter()->GetRoutesTable();
+    const auto& graph = transport_router.GetGraph();
+    const size_t vertex_count = routes_table.vertex_count;
+    std::vector<std::uint64_t> row_offsets{0};
+    std::vector<std::string> rows;
+    if (routes_table.HasRows()) {
+        // таблица взята из прежней базы: её строки переписываются как есть
+        row_offsets.assign(routes_table.external_row_offsets, routes_table.external_row_offsets + vertex_count + 1);
+    } else {
+        // строки независимы и сжимаются параллельно
+        rows.resize(vertex_count);
+        concurrency::ThreadPool pool;
+        pool.ParallelFor(0, vertex_count, [&](size_t begin, size_t end) {
+            for (size_t from = begin; from < end; ++from) {
+                const size_t row = routes_table.GetCell(static_cast<graph::VertexId>(from), 0);
+                graph::table_rows::EncodeRow(routes_table.GetWeights() + row, routes_table.GetPrevEdges() + row,
+                                             vertex_count, graph, rows[from]);
+            }
+        });
+        row_offsets.reserve(vertex_count + 1);
+        for (const auto& row : rows) {
+            row_offsets.push_back(row_offsets.back() + row.size());
+        }
+    }
+
+    const size_t section_alignment = GetTableSectionAlignment();
+    const size_t section_offset = (message_size + section_alignment - 1) / section_alignment * section_alignment;
+    write_padding(section_offset - message_size);
+    out.write(reinterpret_cast<const char*>(row_offsets.data()), static_cast<std::streamsize>(row_offsets.size() * sizeof(std::uint64_t)));
+    if (routes_table.HasRows()) {
+        out.write(routes_table.external_rows, static_cast<std::streamsize>(row_offsets.back()));
+    }
+    for (const auto& row : rows) {
+        out.write(row.data(), static_cast<std::streamsize>(row.size()));
+    }
+
+    TableSectionTrailer trailer{message_size, section_offset, section_alignment, {}};
+    std::memcpy(trailer.magic, TABLE_SECTION_MAGIC, sizeof(trailer.magic));
+    out.write(reinterpret_cast<const char*>(&trailer), sizeof(trailer));
+}
+
+std::optional<TransportCatalogueExport::TableSection> TransportCatalogueExport::ReadTableSection(const MappedFile& file) const {
+    char magic[sizeof(TABLE_SECTION_MAGIC)];
+    if (file.GetSize() < sizeof(TableSectionTrailerV1)) {
+        return std::nullopt;
+    }
+    std::memcpy(magic, file.GetData() + file.GetSize() - sizeof(magic), sizeof(magic));
+
+    TableSectionTrailer trailer;
+    size_t trailer_size = sizeof(TableSectionTrailer);
+    if (std::memcmp(magic, TABLE_SECTION_MAGIC, sizeof(magic)) == 0 && file.GetSize() >= sizeof(TableSectionTrailer)) {
+        std::memcpy(&trailer, file.GetData() + file.GetSize() - sizeof(trailer), sizeof(trailer));
+    } else if (std::memcmp(magic, TABLE_SECTION_MAGIC_V1, sizeof(magic)) == 0) {
+        TableSectionTrailerV1 trailer_v1;
+        std::memcpy(&trailer_v1, file.GetData() + file.GetSize() - sizeof(trailer_v1), sizeof(trailer_v1));
+        trailer = {trailer_v1.message_size, trailer_v1.section_offset, TABLE_SECTION_ALIGNMENT_V1, {}};
+        trailer_size = sizeof(TableSectionTrailerV1);
+    } else {
+        return std::nullopt; // базы без таблицы
+    }
+    // выравнивание - степень двойки, не меньше выравнивания смещений строк в начале секции
+    const std::uint64_t alignment = trailer.section_alignment;
+    if (alignment < alignof(std::uint64_t) || (alignment & (alignment - 1)) != 0
+        || trailer.message_size > trailer.section_offset
+        || trailer.section_offset > file.GetSize() - trailer_size
+        || trailer.section_offset % alignment != 0) {
+        return std::nullopt;
+    }
+    return TableSection{static_cast<size_t>(trailer.message_size), static_cast<size_t>(trailer.section_offset),
+                        static_cast<size_t>(file.GetSize() - trailer_size - trailer.section_offset)};
+}
+
+// _______________ Flat Format _______________
+
+void TransportCatalogueExport::SerializeFlat(std::ostream& out,
+                                             const transport::TransportCatalogue& transport_catalogue,
+                                             const map_renderer::MapRenderer& map_renderer,
+                                             const router::TransportRouter& transport_router,
+                                             const std::optional<InputHashes>& input_hashes) const {
+    flat::Writer writer;
+
+    const auto& catalogue = transport_catalogue.GetArrays();
+    writer.AddArray(STOP_NAME_CHARS, catalogue.stop_name_chars);
+    writer.AddArray(STOP_NAME_OFFSETS, catalogue.stop_name_offsets);
+    writer.AddArray(STOP_NAME_ORDER, catalogue.stop_name_order);
+    writer.AddArray(STOP_COORDINATES, catalogue.stop_coordinates);
+    writer.AddArray(BUS_NAME_CHARS, catalogue.bus_name_chars);
+    writer.AddArray(BUS_NAME_OFFSETS, catalogue.bus_name_offsets);
+    writer.AddArray(BUS_NAME_ORDER, catalogue.bus_name_order);
+    writer.AddArray(BUS_IS_ROUNDTRIP, catalogue.bus_is_roundtrip);
+    writer.AddArray(BUS_STOP_OFFSETS, catalogue.bus_stop_offsets);
+    writer.AddArray(BUS_STOPS, catalogue.bus_stops);
+    writer.AddArray(STOP_BUS_OFFSETS, catalogue.stop_bus_offsets);
+    writer.AddArray(STOP_BUSES, catalogue.stop_buses);
+    writer.AddArray(DISTANCE_OFFSETS, catalogue.distance_offsets);
+    writer.AddArray(DISTANCE_TARGETS, catalogue.distance_targets);
+    writer.AddArray(DISTANCE_VALUES, catalogue.distance_values);
+    // у справочника из базы, записанной до признака, его нет и в новой базе
+    if (transport_catalogue.HasExplicitDistances()) {
+        writer.AddArray(DISTANCE_IS_DERIVED, catalogue.distance_is_derived);
+    }
+
+    // настройки малы и читаются один раз - они остаются сообщениями protobuf
+    const std::string map_renderer_message = SerializeMapRenderer(map_renderer).SerializeAsString();
+    const std::string routing_settings_message = MakeTransportRouterProtoRoutingSettings(transport_router).SerializeAsString();
+    writer.AddBytes(MAP_RENDERER, map_renderer_message.data(), map_renderer_message.size());
+    writer.AddBytes(ROUTING_SETTINGS, routing_settings_message.data(), routing_settings_message.size());
+    std::string input_hashes_message;
+    if (input_hashes) {
+        input_hashes_message = MakeInputHashesProto(*input_hashes).SerializeAsString();
+        writer.AddBytes(INPUT_HASHES, input_hashes_message.data(), input_hashes_message.size());
+    }
+
+    const auto& graph = transport_router.GetGraph().GetArrays();
+    writer.AddArray(GRAPH_OFFSETS, graph.offsets);
+    writer.AddArray(GRAPH_TARGETS, graph.targets);
+    writer.AddArray(GRAPH_WEIGHTS, graph.weights);
+    writer.AddArray(GRAPH_NAME_IDS, graph.name_ids);
+    writer.AddArray(GRAPH_SPAN_COUNTS, graph.span_counts);
+    writer.AddArray(GRAPH_NAME_CHARS, graph.name_chars);
+    writer.AddArray(GRAPH_NAME_OFFSETS, graph.name_offsets);
+
+    router::TableRouter::Table decoded_table;
+    if (transport_router.GetRouter()) {
+        // таблица маршрутов велика: её контрольная сумма не проверяется при загрузке, а страницы читаются по запросу
+        const auto* routes_table = &transport_router.GetRouter()->GetRoutesTable();
+        if (routes_table->HasRows()) {
+            // таблица взята из базы protobuf сжатыми строками - во "flat" она пишется плоскостями
+            decoded_table = DecodeRoutesTableRows(*routes_table, transport_router.GetGraph());
+            routes_table = &decoded_table;
+        }
+        const size_t cell_count = routes_table->vertex_count * routes_table->vertex_count;
+        writer.AddArray(ROUTES_TABLE_WEIGHTS, ranges::Span<router::RouteTableWeight>(routes_table->GetWeights(), cell_count),
+                        GetTableSectionAlignment(), flat::SECTION_LAZY);
+        writer.AddArray(ROUTES_TABLE_PREV_EDGES, ranges::Span<graph::TableEdgeId>(routes_table->GetPrevEdges(), cell_count),
+                        GetTableSectionAlignment(), flat::SECTION_LAZY);
     }
+    if (const auto& hierarchy = transport_router.GetHierarchy()) {
+        writer.AddArray(HIERARCHY_RANKS, ranges::Span(hierarchy->GetRanks()));
+        writer.AddArray(HIERARCHY_EDGES, ranges::Span(hierarchy->GetEdges()));
+    }
+    if (const auto& landmarks = transport_router.GetLandmarks()) {
+        writer.AddArray(LANDMARK_VERTICES, ranges::Span(landmarks->GetLandmarks()));
+        writer.AddArray(LANDMARK_DISTANCES_FROM, ranges::Span(landmarks->GetDistancesFrom()));
+        writer.AddArray(LANDMARK_DISTANCES_TO, ranges::Span(landmarks->GetDistancesTo()));
+    }
+
+    writer.Write(out);
+}
+
+router::TableRouter::Table TransportCatalogueExport::DecodeRoutesTableRows(const router::TableRouter::Table& routes_table,
+                                                                           const graph::DirectedWeightedGraph<double>& graph) const {
+    const size_t vertex_count = routes_table.vertex_count;
+    router::TableRouter::Table decoded_table(vertex_count);
+    for (size_t from = 0; from < vertex_count; ++from) {
+        const size_t row = decoded_table.GetCell(static_cast<graph::VertexId>(from), 0);
+        const std::uint64_t row_begin = routes_table.external_row_offsets[from];
+        graph::table_rows::DecodeRow(routes_table.external_rows + row_begin, routes_table.external_row_offsets[from + 1] - row_begin,
+                                     vertex_count, graph, decoded_table.weights.data() + row, decoded_table.prev_edges.data() + row);
+    }
+    return decoded_table;
+}
+
+TransportCatalogueExport::DesTransportCatalogue TransportCatalogueExport::DeserializeFlat(const std::shared_ptr<const MappedFile>& file,
+                                                                                         const DatabaseSections& sections,
+                                                                                         std::ostream* timings) const {
+    const flat::Reader reader = timing::Measure("Deserialization: section directory", timings, [&] {
+        return flat::Reader(file);
+    });
+
+    // части читаются параллельно, как и в формате PROTOBUF
+    concurrency::ThreadPool pool;
+    auto map_renderer_future = pool.Submit([&] {
+        return DeserializeSection<map_renderer::MapRenderer>(
+            sections.map_renderer, "Deserialization: map renderer", timings, [&] {
+                transport_catalogue::MapRenderer map_renderer_import;
+                const std::string_view map_renderer_message = reader.GetBytes(MAP_RENDERER);
+                map_renderer_import.ParseFromArray(map_renderer_message.data(), static_cast<int>(map_renderer_message.size()));
+                return map_renderer::MapRenderer(DeserializeMapRendererRenderSettings(map_renderer_import));
+            });
+    });
+    auto transport_router_future = pool.Submit([&] {
+        return DeserializeSection<router::TransportRouter>(
+            sections.transport_router && sections.transport_catalogue, "Deserialization: transport router", timings, [&] {
+                const size_t stop_count = reader.GetSize(STOP_NAME_ORDER) / sizeof(transport::StopId);
+                return DeserializeFlatTransportRouter(reader, stop_count);
+            });
+    });
+    transport::TransportCatalogue transport_catalogue = DeserializeSection<transport::TransportCatalogue>(
+        sections.transport_catalogue, "Deserialization: transport catalogue", timings, [&] {
+            return DeserializeFlatTransportCatalogue(reader);
+        });
+
+    return DesTransportCatalogue{std::move(transport_catalogue),
+                                 map_renderer_future.get(),
+                                 transport_router_future.get()
+    };
+}
+
+transport::TransportCatalogue TransportCatalogueExport::DeserializeFlatTransportCatalogue(const flat::Reader& reader) const {
+    transport::TransportCatalogue::Arrays arrays;
+    arrays.stop_name_chars = reader.GetArray<char>(STOP_NAME_CHARS);
+    arrays.stop_name_offsets = reader.GetArray<std::uint32_t>(STOP_NAME_OFFSETS);
+    arrays.stop_name_order = reader.GetArray<transport::StopId>(STOP_NAME_ORDER);
+    arrays.stop_coordinates = reader.GetArray<geo::Coordinates>(STOP_COORDINATES);
+    arrays.bus_name_chars = reader.GetArray<char>(BUS_NAME_CHARS);
+    arrays.bus_name_offsets = reader.GetArray<std::uint32_t>(BUS_NAME_OFFSETS);
+    arrays.bus_name_order = reader.GetArray<transport::BusId>(BUS_NAME_ORDER);
+    arrays.bus_is_roundtrip = reader.GetArray<std::uint8_t>(BUS_IS_ROUNDTRIP);
+    arrays.bus_stop_offsets = reader.GetArray<std::uint32_t>(BUS_STOP_OFFSETS);
+    arrays.bus_stops = reader.GetArray<transport::StopId>(BUS_STOPS);
+    arrays.stop_bus_offsets = reader.GetArray<std::uint32_t>(STOP_BUS_OFFSETS);
+    arrays.stop_buses = reader.GetArray<transport::BusId>(STOP_BUSES);
+    arrays.distance_offsets = reader.GetArray<std::uint32_t>(DISTANCE_OFFSETS);
+    arrays.distance_targets = reader.GetArray<transport::StopId>(DISTANCE_TARGETS);
+    arrays.distance_values = reader.GetArray<std::int32_t>(DISTANCE_VALUES);
+    if (reader.HasSection(DISTANCE_IS_DERIVED)) {
+        arrays.distance_is_derived = reader.GetArray<std::uint8_t>(DISTANCE_IS_DERIVED);
+    }
+
+    // массивы остаются в отображённом файле, справочник держит его открытым
+    return transport::TransportCatalogue(arrays, reader.GetFile());
+}
+
+router::TransportRouter TransportCatalogueExport::DeserializeFlatTransportRouter(const flat::Reader& reader, size_t stop_count) const {
+    transport_catalogue::RoutingSettings routing_settings_import;
+    const std::string_view routing_settings_message = reader.GetBytes(ROUTING_SETTINGS);
+    routing_settings_import.ParseFromArray(routing_settings_message.data(), static_cast<int>(routing_settings_message.size()));
+    router::RoutingSettings routing_settings_to_tc = DeserializeTransportRouterRoutingSettings(routing_settings_import);
+
+    graph::DirectedWeightedGraph<double> graph_to_tc = DeserializeFlatTransportRouterGraph(reader);
 
-    return transport_catalogue_temp;
+    std::optional<router::TableRouter::Table> routes_table_to_tc;
+    if (routing_settings_to_tc.router_type == router::RouterType::ALL_PAIRS) {
+        routes_table_to_tc = DeserializeFlatTransportRoutesTable(reader, graph_to_tc.GetVertexCount());
+    }
+
+    // иерархия и ориентиры копируются: их структуры владеют векторами
+    using Hierarchy = graph::ContractionHierarchy<double>;
+    std::optional<Hierarchy> hierarchy_to_tc;
+    if (routing_settings_to_tc.router_type == router::RouterType::CONTRACTION_HIERARCHY
+        && reader.HasSection(HIERARCHY_RANKS) && reader.HasSection(HIERARCHY_EDGES)) {
+        const auto ranks = reader.GetArray<Hierarchy::Rank>(HIERARCHY_RANKS);
+        const auto edges = reader.GetArray<Hierarchy::HierarchyEdge>(HIERARCHY_EDGES);
+        hierarchy_to_tc = MakeHierarchy(std::vector<Hierarchy::Rank>(ranks.begin(), ranks.end()),
+                                        std::vector<Hierarchy::HierarchyEdge>(edges.begin(), edges.end()),
+                                        graph_to_tc.GetVertexCount(), graph_to_tc.GetEdgeCount());
+    }
+
+    std::optional<graph::Landmarks<double>> landmarks_to_tc;
+    if (routing_settings_to_tc.router_type == router::RouterType::ALT && reader.HasSection(LANDMARK_VERTICES)
+        && reader.HasSection(LANDMARK_DISTANCES_FROM) && reader.HasSection(LANDMARK_DISTANCES_TO)) {
+        const auto vertices = reader.GetArray<graph::VertexId>(LANDMARK_VERTICES);
+        const auto distances_from = reader.GetArray<double>(LANDMARK_DISTANCES_FROM);
+        const auto distances_to = reader.GetArray<double>(LANDMARK_DISTANCES_TO);
+        landmarks_to_tc = MakeLandmarks(std::vector<graph::VertexId>(vertices.begin(), vertices.end()),
+                                        std::vector<double>(distances_from.begin(), distances_from.end()),
+                                        std::vector<double>(distances_to.begin(), distances_to.end()),
+                                        graph_to_tc.GetVertexCount());
+    }
+
+    return router::TransportRouter(std::move(routing_settings_to_tc),
+                                   std::move(graph_to_tc),
+                                   stop_count,
+                                   std::move(routes_table_to_tc),
+                                   std::move(hierarchy_to_tc),
+                                   std::move(landmarks_to_tc));
+}
+
+graph::DirectedWeightedGraph<double> TransportCatalogueExport::DeserializeFlatTransportRouterGraph(const flat::Reader& reader) const {
+    using Graph = graph::DirectedWeightedGraph<double>;
+    Graph::Arrays arrays;
+    arrays.offsets = reader.GetArray<Graph::Index>(GRAPH_OFFSETS);
+    if (reader.HasSection(GRAPH_SOURCES)) {
+        arrays.sources = reader.GetArray<Graph::Index>(GRAPH_SOURCES);
+    }
+    arrays.targets = reader.GetArray<Graph::Index>(GRAPH_TARGETS);
+    arrays.weights = reader.GetArray<double>(GRAPH_WEIGHTS);
+    arrays.name_ids = reader.GetArray<graph::NameId>(GRAPH_NAME_IDS);
+    arrays.span_counts = reader.GetArray<Graph::Index>(GRAPH_SPAN_COUNTS);
+    arrays.name_chars = reader.GetArray<char>(GRAPH_NAME_CHARS);
+    arrays.name_offsets = reader.GetArray<std::uint32_t>(GRAPH_NAME_OFFSETS);
+
+    return Graph(arrays, reader.GetFile());
+}
+
+std::optional<router::TableRouter::Table> TransportCatalogueExport::DeserializeFlatTransportRoutesTable(const flat::Reader& reader,
+                                                                                                         size_t vertex_count) const {
+    if (!reader.HasSection(ROUTES_TABLE_WEIGHTS) || !reader.HasSection(ROUTES_TABLE_PREV_EDGES)) {
+        return std::nullopt; // таблицы нет - маршруты будут пересчитаны
+    }
+    const std::string_view weights = reader.GetBytes(ROUTES_TABLE_WEIGHTS);
+    const std::string_view prev_edges = reader.GetBytes(ROUTES_TABLE_PREV_EDGES);
+    const size_t cell_count = vertex_count * vertex_count;
+    if (prev_edges.size() != cell_count * sizeof(graph::TableEdgeId)) {
+        return std::nullopt;
+    }
+    // разрядность весов определяется по размеру секции: таблицу могла записать сборка с другой разрядностью
+    const size_t weight_size = cell_count == 0 ? sizeof(router::RouteTableWeight) : weights.size() / cell_count;
+    if ((weight_size != sizeof(float) && weight_size != sizeof(double)) || weights.size() != cell_count * weight_size) {
+        return std::nullopt;
+    }
+
+    return MakeRoutesTable(vertex_count, weight_size, weights.data(), prev_edges.data(), reader.GetFile(), true);
+}
+
+// _______________ Serialize Transport Catalogue _______________
+
+TransportCatalogueExport::ExplicitDistances TransportCatalogueExport::MakeExplicitDistances(const transport::TransportCatalogue& transport_catalogue) const {
+    // расстояние, взятое из обратного, выводится из него же при загрузке
+    ExplicitDistances distances;
+    distances.offsets.reserve(transport_catalogue.GetCountStops() + 1);
+    for (transport::StopId from = 0; from < transport_catalogue.GetCountStops(); ++from) {
+        const auto targets = transport_catalogue.GetDistanceTargets(from);
+        const auto* distance = transport_catalogue.GetDistanceValues(from).begin();
+        for (auto it = targets.begin(); it != targets.end(); ++it, ++distance) {
+            if (transport_catalogue.IsExplicitDistance(from, it - targets.begin())) {
+                distances.targets.push_back(*it);
+                distances.values.push_back(*distance);
+            }
+        }
+        distances.offsets.push_back(static_cast<std::uint32_t>(distances.targets.size()));
+    }
+    return distances;
+}
+void TransportCatalogueExport::WriteTransportCatalogueProtoCatalogue(proto_stream::Sink& sink,
+                                                                     const transport::TransportCatalogue& transport_catalogue,
+                                                                     const ExplicitDistances& distances) const {
+    using Proto = transport_catalogue::Catalogue;
+    const auto& arrays = transport_catalogue.GetArrays();
+    sink.WritePacked<double>(Proto::kLatitudesFieldNumber, arrays.stop_coordinates.size(), [&arrays](size_t stop) {
+        return arrays.stop_coordinates[stop].lat;
+    });
+    sink.WritePacked<double>(Proto::kLongitudesFieldNumber, arrays.stop_coordinates.size(), [&arrays](size_t stop) {
+        return arrays.stop_coordinates[stop].lng;
+    });
+    sink.WritePacked(Proto::kDistanceOffsetsFieldNumber, ranges::Span(distances.offsets));
+    sink.WritePacked(Proto::kDistanceTargetsFieldNumber, ranges::Span(distances.targets));
+    sink.WritePacked(Proto::kDistanceValuesFieldNumber, ranges::Span(distances.values));
+    sink.WritePacked<bool>(Proto::kIsRoundtripFieldNumber, arrays.bus_is_roundtrip.size(), [&arrays](size_t bus) {
+        return arrays.bus_is_roundtrip[bus] != 0;
+    });
+    sink.WritePacked(Proto::kBusStopOffsetsFieldNumber, arrays.bus_stop_offsets);
+    sink.WritePacked(Proto::kBusStopsFieldNumber, arrays.bus_stops);
+    if (transport_catalogue.HasExplicitDistances()) {
+        sink.WriteVarint(Proto::kExplicitDistancesFieldNumber, 1);
+    }
+}
+
+// _______________ Input Hashes _______________
+
+transport_catalogue::InputHashes TransportCatalogueExport::MakeInputHashesProto(const InputHashes& input_hashes) const {
+    transport_catalogue::InputHashes input_hashes_export;
+    input_hashes_export.set_stops(input_hashes.stops);
+    input_hashes_export.set_buses(input_hashes.buses);
+    input_hashes_export.set_routing_settings(input_hashes.routing_settings);
+    input_hashes_export.set_render_settings(input_hashes.render_settings);
+    return input_hashes_export;
+}
+InputHashes TransportCatalogueExport::DeserializeInputHashes(const transport_catalogue::InputHashes& input_hashes) const {
+    return InputHashes{input_hashes.stops(), input_hashes.buses(), input_hashes.routing_settings(), input_hashes.render_settings()};
+}
+
+// _______________ Delta _______________
+
+transport_catalogue::Delta TransportCatalogueExport::MakeDeltaProto(const DatabaseDelta& delta) const {
+    transport_catalogue::Delta delta_export;
+    *delta_export.mutable_base_hashes() = MakeInputHashesProto(delta.base_hashes);
+    for (const auto& [stop, distances] : delta.delta.stops) {
+        auto& stop_export = *delta_export.add_stops();
+        stop_export.set_name(stop.stop_name);
+        stop_export.mutable_coordinates()->set_lat(stop.stop_coordinates.lat);
+        stop_export.mutable_coordinates()->set_lng(stop.stop_coordinates.lng);
+        for (const auto& [stop_to, distance] : distances) {
+            auto& distance_export = *stop_export.add_distances();
+            distance_export.set_stop_to(stop_to);
+            distance_export.set_distance(distance);
+        }
+    }
+    for (const auto& [bus, is_roundtrip] : delta.delta.buses) {
+        auto& bus_export = *delta_export.add_buses();
+        bus_export.set_name(bus.at(0));
+        bus_export.set_is_roundtrip(is_roundtrip);
+        for (size_t i = 1; i < bus.size(); ++i) {
+            bus_export.add_stops(bus[i]);
+        }
+    }
+    for (const auto& name : delta.delta.removed_stops) {
+        delta_export.add_removed_stops(name);
+    }
+    for (const auto& name : delta.delta.removed_buses) {
+        delta_export.add_removed_buses(name);
+    }
+    return delta_export;
 }
 
 // _______________ Serialize Map Renderer _______________
@@ -89,7 +792,6 @@ transport_catalogue::TransportCatalogue TransportCatalogueExport::MakeTransportC
 transport_catalogue::MapRenderer TransportCatalogueExport::SerializeMapRenderer(const map_renderer::MapRenderer& map_renderer) const {
     transport_catalogue::MapRenderer map_renderer_temp;
     *map_renderer_temp.mutable_render_settings() = MakeMapRendererProtoRendererSettings(map_renderer);
-    *map_renderer_temp.mutable_actual_coordinates() = MakeMapRendererProtoActualCoordinates(map_renderer).actual_coordinates();
 
     return map_renderer_temp;
 }
@@ -153,133 +855,213 @@ transport_catalogue::RenderSettings TransportCatalogueExport::MakeMapRendererPro
 
     return render_settings_export;
 }
-transport_catalogue::MapRenderer TransportCatalogueExport::MakeMapRendererProtoActualCoordinates(const map_renderer::MapRenderer& map_renderer) const {
-    transport_catalogue::MapRenderer map_renderer_temp;
-    for (const auto& coord_as_tc: map_renderer.GetActualCoordinates()) {
-        transport_catalogue::Coordinates coord;
-        coord.set_lat(coord_as_tc.lat);
-        coord.set_lng(coord_as_tc.lng);
-        *map_renderer_temp.add_actual_coordinates() = std::move(coord);
-    }
-
-    return map_renderer_temp;
-}
-
 // _______________ Serialize Transport Router _______________
 
-transport_catalogue::TransportRouter TransportCatalogueExport::SerializeTransportRouter(const router::TransportRouter& transport_router) const {
-    transport_catalogue::TransportRouter transport_router_temp;
-    *transport_router_temp.mutable_routing_settings() = MakeTransportRouterProtoRoutingSettings(transport_router);
-    *transport_router_temp.mutable_graph() = MakeTransportRouterProtoGraph(transport_router);
-    *transport_router_temp.mutable_stop_names() = MakeTransportRouterProtoStopNames(transport_router).stop_names();
-    *transport_router_temp.mutable_routes_internal_data() = MakeTransportRouterProtoStopRoutesInternalData(transport_router).routes_internal_data();
-
-    return transport_router_temp;
+void TransportCatalogueExport::WriteTransportRouterProto(proto_stream::Sink& sink, const router::TransportRouter& transport_router,
+                                                         const std::vector<std::uint32_t>& name_refs) const {
+    using Proto = transport_catalogue::TransportRouter;
+    sink.WriteMessage(Proto::kRoutingSettingsFieldNumber, MakeTransportRouterProtoRoutingSettings(transport_router));
+    sink.WriteNested(Proto::kGraphFieldNumber, [&](proto_stream::Sink& graph_sink) {
+        WriteTransportRouterProtoGraph(graph_sink, transport_router, name_refs);
+    });
+    if (transport_router.GetRouter()) {
+        sink.WriteMessage(Proto::kRoutesTableFieldNumber, MakeTransportRouterProtoRoutesTable(transport_router));
+    }
+    if (transport_router.GetHierarchy()) {
+        sink.WriteNested(Proto::kHierarchyFieldNumber, [&](proto_stream::Sink& hierarchy_sink) {
+            WriteTransportRouterProtoHierarchy(hierarchy_sink, transport_router);
+        });
+    }
+    if (transport_router.GetLandmarks()) {
+        sink.WriteNested(Proto::kLandmarksFieldNumber, [&](proto_stream::Sink& landmarks_sink) {
+            WriteTransportRouterProtoLandmarks(landmarks_sink, transport_router);
+        });
+    }
 }
 transport_catalogue::RoutingSettings TransportCatalogueExport::MakeTransportRouterProtoRoutingSettings(const router::TransportRouter& transport_router) const {
     transport_catalogue::RoutingSettings routing_settings;
     routing_settings.set_bus_wait_time(transport_router.GetRoutingSettings().bus_wait_time);
     routing_settings.set_bus_velocity(transport_router.GetRoutingSettings().bus_velocity);
+    routing_settings.set_router_type(static_cast<transport_catalogue::RouterType>(transport_router.GetRoutingSettings().router_type));
+    routing_settings.set_router_cache_size(transport_router.GetRoutingSettings().router_cache_size);
+    routing_settings.set_graph_model(static_cast<transport_catalogue::GraphModel>(transport_router.GetRoutingSettings().graph_model));
+    routing_settings.set_landmark_count(transport_router.GetRoutingSettings().landmark_count);
     return routing_settings;
 }
-transport_catalogue::Graph TransportCatalogueExport::MakeTransportRouterProtoGraph(const router::TransportRouter& transport_router) const {
-    transport_catalogue::Graph graph_target;
-    const auto& graph_as_tc = transport_router.GetGraph();
-    for (size_t i = 0; i < graph_as_tc.GetEdgeCount(); ++i) {
-        const auto& edge = graph_as_tc.GetEdge(i);
-        transport_catalogue::Edge edge_tmp;
-        edge_tmp.mutable_vert_from()->set_vertex_id(edge.from);
-        edge_tmp.mutable_vert_to()->set_vertex_id(edge.to);
-        edge_tmp.set_weight(edge.weight);
-        edge_tmp.set_name(edge.name);
-        edge_tmp.set_span_count(edge.span_count);
+void TransportCatalogueExport::WriteTransportRouterProtoGraph(proto_stream::Sink& sink, const router::TransportRouter& transport_router,
+                                                              const std::vector<std::uint32_t>& name_refs) const {
+    using Proto = transport_catalogue::Graph;
+    using google::protobuf::internal::WireFormatLite;
+    const auto& arrays = transport_router.GetGraph().GetArrays();
+    // соседние концы рёбер вершины и названия подряд идущих рёбер близки: разности занимают байт-два
+    sink.WritePacked<std::uint32_t>(Proto::kOffsetsFieldNumber, arrays.offsets.size() - 1, [&arrays](size_t vertex) {
+        return arrays.offsets[vertex + 1] - arrays.offsets[vertex];
+    });
+    sink.WritePacked<std::uint32_t>(Proto::kTargetsFieldNumber, arrays.targets.size(), [&arrays](size_t edge_id) {
+        const std::uint32_t source = arrays.sources[edge_id];
+        const std::uint32_t previous = edge_id == arrays.offsets[source] ? source : arrays.targets[edge_id - 1];
+        return WireFormatLite::ZigZagEncode32(static_cast<std::int32_t>(arrays.targets[edge_id] - previous));
+    });
+    sink.WritePacked(Proto::kWeightsFieldNumber, arrays.weights);
+    sink.WritePacked<std::uint32_t>(Proto::kNameIdsFieldNumber, arrays.name_ids.size(), [&arrays](size_t edge_id) {
+        const std::uint32_t previous = edge_id == 0 ? 0 : arrays.name_ids[edge_id - 1];
+        return WireFormatLite::ZigZagEncode32(static_cast<std::int32_t>(arrays.name_ids[edge_id] - previous));
+    });
+    sink.WritePacked(Proto::kSpanCountsFieldNumber, arrays.span_counts);
+    sink.WritePacked(Proto::kNameRefsFieldNumber, ranges::Span(name_refs));
+    sink.WriteVarint(Proto::kLayoutFieldNumber, transport_catalogue::GRAPH_LAYOUT_CSR_DELTA);
+}
+transport_catalogue::RoutesTable TransportCatalogueExport::MakeTransportRouterProtoRoutesTable(const router::TransportRouter& transport_router) const {
+    transport_catalogue::RoutesTable routes_table_export;
+    const auto& routes_table = transport_router.GetRouter()->GetRoutesTable();
+    routes_table_export.set_vertex_count(routes_table.vertex_count);
+    routes_table_export.set_weight_size(sizeof(router::RouteTableWeight));
+    // сами строки пишет WriteRoutesTableSection: сначала смещения строк, за ними строки
+    routes_table_export.set_is_compressed(true);
+    routes_table_export.set_row_offsets_offset(0);
+    routes_table_export.set_rows_offset((routes_table.vertex_count + 1) * sizeof(std::uint64_t));
+
+    return routes_table_export;
+}
+void TransportCatalogueExport::WriteTransportRouterProtoHierarchy(proto_stream::Sink& sink, const router::TransportRouter& transport_router) const {
+    using Proto = transport_catalogue::ContractionHierarchy;
+    const auto& hierarchy = *transport_router.GetHierarchy();
+    sink.WritePacked(Proto::kRanksFieldNumber, ranges::Span(hierarchy.GetRanks()));
+
+    const auto& edges = hierarchy.GetEdges();
+    sink.WritePacked<std::uint32_t>(Proto::kEdgeFromFieldNumber, edges.size(), [&edges](size_t i) {
+        return edges[i].from;
+    });
+    sink.WritePacked<std::uint32_t>(Proto::kEdgeToFieldNumber, edges.size(), [&edges](size_t i) {
+        return edges[i].to;
+    });
+    sink.WritePacked<double>(Proto::kEdgeWeightFieldNumber, edges.size(), [&edges](size_t i) {
+        return edges[i].weight;
+    });
+    sink.WritePacked<std::uint32_t>(Proto::kEdgeFirstFieldNumber, edges.size(), [&edges](size_t i) {
+        return edges[i].first;
+    });
+    sink.WritePacked<std::uint32_t>(Proto::kEdgeSecondFieldNumber, edges.size(), [&edges](size_t i) {
+        return edges[i].second;
+    });
+}
+void TransportCatalogueExport::WriteTransportRouterProtoLandmarks(proto_stream::Sink& sink, const router::TransportRouter& transport_router) const {
+    using Proto = transport_catalogue::Landmarks;
+    const auto& landmarks = *transport_router.GetLandmarks();
+    sink.WritePacked(Proto::kVerticesFieldNumber, ranges::Span(landmarks.GetLandmarks()));
+    sink.WritePacked(Proto::kDistancesFromFieldNumber, ranges::Span(landmarks.GetDistancesFrom()));
+    sink.WritePacked(Proto::kDistancesToFieldNumber, ranges::Span(landmarks.GetDistancesTo()));
+}
 
-        *graph_target.add_edges() = std::move(edge_tmp);
-    }
 
-    for (size_t i = 0; i < graph_as_tc.GetVertexCount(); ++i) {
-        transport_catalogue::IncidenceList incidence_list;
-        const auto& incident_edges = graph_as_tc.GetIncidentEdges(i);
-        for (auto it = incident_edges.begin(); it != incident_edges.end(); ++it) {
-            incidence_list.add_edges_id(std::move(*it));
-        }
-        *graph_target.add_incidence_lists() = std::move(incidence_list);
-    }
+// _______________ Deserialize Transport Catalogue _______________
 
-    return graph_target;
-}
-transport_catalogue::TransportRouter TransportCatalogueExport::MakeTransportRouterProtoStopNames(const router::TransportRouter& transport_router) const {
-    transport_catalogue::TransportRouter transport_router_temp;
-    for (const auto& stop: transport_router.GetStopNames()) {
-        transport_router_temp.add_stop_names(stop);
-    }
+transport::TransportCatalogue TransportCatalogueExport::DeserializeTransportCatalogue(transport_catalogue::TransportCatalogue& transport_catalogue_import) const {
+    // версия 1: справочник строится заново, как из запросов
+    SourceStopRequests request_stops;
+    SourceBusRequests request_buses;
+    DeserializeTransportCatalogueStops(transport_catalogue_import.stops(), request_stops);
+    DeserializeTransportCatalogueBuses(transport_catalogue_import.buses(), request_buses);
 
-    return transport_router_temp;
+    return transport::TransportCatalogue(request_stops, request_buses);
 }
-transport_catalogue::TransportRouter TransportCatalogueExport::MakeTransportRouterProtoStopRoutesInternalData(const router::TransportRouter& transport_router) const {
-    transport_catalogue::TransportRouter transport_router_temp;
-    const auto& router = transport_router.GetRouter();
-    for (const auto& routes_tc: router.GetRoutesInternalData()) {
-        transport_catalogue::RoutesInternalData vector;
-        for (const auto& route_tc: routes_tc) {
-            if (route_tc) {
-                transport_catalogue::RouteInternalDataVectorElem vector_elem;
-                vector_elem.mutable_data()->set_weight(route_tc->weight);
-                if (route_tc->prev_edge) {
-                    vector_elem.mutable_data()->mutable_prev_edge()->set_edge_id(*route_tc->prev_edge);
-                }
-
-                *vector.add_route_internal_data() = std::move(vector_elem);
+transport::TransportCatalogue TransportCatalogueExport::DeserializeTransportCatalogueV2(const char* data, const std::vector<FieldRange>& ranges) const {
+    using Proto = transport_catalogue::TransportCatalogue;
+    using CatalogueProto = transport_catalogue::Catalogue;
+    using proto_stream::ReadRepeated;
+    using proto_stream::WireFormatLite;
+    // названия - ссылки на отображённый файл: справочник копирует их в свои таблицы строк
+    std::vector<std::string_view> names;
+    std::vector<double> latitudes;
+    std::vector<double> longitudes;
+    std::vector<std::uint32_t> distance_offsets;
+    std::vector<transport::StopId> distance_targets;
+    std::vector<std::int32_t> distance_values;
+    transport::TransportCatalogue::Description description;
+    description.bus_stop_offsets.clear();
+    // базы без поля explicit_distances записаны до него
+    description.has_explicit_distances = false;
+
+    for (const auto& [begin, end] : ranges) {
+        proto_stream::CodedInputStream input(reinterpret_cast<const std::uint8_t*>(data + begin), end - begin);
+        const bool is_read = proto_stream::ReadFields(input, [&](int field_number, std::uint32_t tag) {
+            const bool is_length_delimited = WireFormatLite::GetTagWireType(tag) == WireFormatLite::WIRETYPE_LENGTH_DELIMITED;
+            if (field_number == Proto::kNamesFieldNumber && is_length_delimited) {
+                return proto_stream::ReadStringView(input, names.emplace_back());
+            }
+            if (field_number != Proto::kCatalogueFieldNumber || !is_length_delimited) {
+                return WireFormatLite::SkipField(&input, tag);
             }
+            return proto_stream::ReadNested(input, [&](int catalogue_field_number, std::uint32_t catalogue_tag) {
+                switch (catalogue_field_number) {
+                case CatalogueProto::kLatitudesFieldNumber:
+                    return ReadRepeated<double>(input, catalogue_tag, latitudes);
+                case CatalogueProto::kLongitudesFieldNumber:
+                    return ReadRepeated<double>(input, catalogue_tag, longitudes);
+                case CatalogueProto::kDistanceOffsetsFieldNumber:
+                    return ReadRepeated<std::uint32_t>(input, catalogue_tag, distance_offsets);
+                case CatalogueProto::kDistanceTargetsFieldNumber:
+                    return ReadRepeated<std::uint32_t>(input, catalogue_tag, distance_targets);
+                case CatalogueProto::kDistanceValuesFieldNumber:
+                    return ReadRepeated<std::int32_t>(input, catalogue_tag, distance_values);
+                case CatalogueProto::kIsRoundtripFieldNumber:
+                    return ReadRepeated<bool>(input, catalogue_tag, description.bus_is_roundtrip);
+                case CatalogueProto::kBusStopOffsetsFieldNumber:
+                    return ReadRepeated<std::uint32_t>(input, catalogue_tag, description.bus_stop_offsets);
+                case CatalogueProto::kBusStopsFieldNumber:
+                    return ReadRepeated<std::uint32_t>(input, catalogue_tag, description.bus_stops);
+                case CatalogueProto::kExplicitDistancesFieldNumber:
+                    if (WireFormatLite::GetTagWireType(catalogue_tag) == WireFormatLite::WIRETYPE_VARINT) {
+                        std::uint32_t value = 0;
+                        if (!input.ReadVarint32(&value)) {
+                            return false;
+                        }
+                        description.has_explicit_distances = value != 0;
+                        return true;
+                    }
+                    return WireFormatLite::SkipField(&input, catalogue_tag);
+                default:
+                    return WireFormatLite::SkipField(&input, catalogue_tag);
+                }
+            });
+        });
+        if (!is_read) {
+            throw std::runtime_error("Corrupted database catalogue");
         }
-
-        *transport_router_temp.add_routes_internal_data() = std::move(vector);
     }
 
-    return transport_router_temp;
-}
-
+    const size_t stop_count = latitudes.size();
+    const size_t bus_count = description.bus_is_roundtrip.size();
+    if (longitudes.size() != stop_count || names.size() < stop_count + bus_count
+        || distance_offsets.size() != stop_count + 1 || distance_values.size() != distance_targets.size()) {
+        throw std::runtime_error("Inconsistent database catalogue");
+    }
+    description.stop_names.assign(names.begin(), names.begin() + stop_count);
+    description.bus_names.assign(names.begin() + stop_count, names.begin() + stop_count + bus_count);
+    description.stop_coordinates.reserve(stop_count);
+    for (size_t stop = 0; stop < stop_count; ++stop) {
+        description.stop_coordinates.push_back({latitudes[stop], longitudes[stop]});
+    }
 
-// _______________ Deserialize Transport Catalogue _______________
+    description.distances.reserve(distance_targets.size());
+    for (size_t from = 0; from < stop_count; ++from) {
+        const std::uint32_t begin = distance_offsets[from];
+        const std::uint32_t end = distance_offsets[from + 1];
+        if (begin > end || end > distance_targets.size()) {
+            throw std::runtime_error("Inconsistent database catalogue");
+        }
+        for (std::uint32_t i = begin; i < end; ++i) {
+            description.distances.push_back({static_cast<transport::StopId>(from), distance_targets[i], distance_values[i]});
+        }
+    }
 
-transport::TransportCatalogue TransportCatalogueExport::DeserializeTransportCatalogue(transport_catalogue::TransportCatalogue& transport_catalogue_import,
-                                                                                      SourceStopRequests& request_stops,
-                                                                                      SourceBusRequests& request_buses) const {
-    // заполняем контейнеры с остановками для создания транспортного справочника
-    Stops stops_to_tc;
-    PeekStops peek_stops_to_tc;
-    domain::DistanceBetweenStops distance_between_stops_to_tc;
-    DeserializeTransportCatalogueStops(transport_catalogue_import, request_stops);
-    CreateStops(stops_to_tc,
-                peek_stops_to_tc,
-                distance_between_stops_to_tc,
-                request_stops);
-
-    // заполняем контейнеры с автобусами для создания транспортного справочника
-    Buses buses_to_tc;
-    PeekBuses peek_buses_to_tc;
-    DeserializeTransportCatalogueBuses(transport_catalogue_import, request_buses);
-    CreateBus(peek_stops_to_tc,
-              buses_to_tc,
-              peek_buses_to_tc,
-              request_buses);
-
-    // ещё контейнер для создания транспортного справочника
-    StopBuses stop_buses_to_tc; //
-    CreateStopBuses(buses_to_tc, stop_buses_to_tc, stops_to_tc);
-
-    return transport::TransportCatalogue(std::move(stops_to_tc),
-                                         std::move(peek_stops_to_tc),
-                                         std::move(buses_to_tc),
-                                         std::move(peek_buses_to_tc),
-                                         std::move(stop_buses_to_tc),
-                                         std::move(distance_between_stops_to_tc));
-}
-void TransportCatalogueExport::DeserializeTransportCatalogueStops(transport_catalogue::TransportCatalogue& transport_catalogue_import,
+    return transport::TransportCatalogue(std::move(description));
+}
+void TransportCatalogueExport::DeserializeTransportCatalogueStops(const google::protobuf::RepeatedPtrField<transport_catalogue::Stop>& stops,
                                                                   SourceStopRequests& request_stops) const {
     // помещаем остановки в переменную request_stops
     // using SourceStopRequests = std::vector<std::pair<domain::Stop, std::map<std::string, int>> >;
-    for (auto& stop: transport_catalogue_import.stops()) {
+    for (auto& stop: stops) {
         Stop stop_to_tc = Stop(std::move(stop.name()), stop.coordinates().lat(), stop.coordinates().lng());
         std::map<std::string, int> distance_to_stop;
         for(auto& road_distance: stop.distances()) {
@@ -289,12 +1071,12 @@ void TransportCatalogueExport::DeserializeTransportCatalogueStops(transport_cata
         request_stops.push_back({std::move(stop_to_tc), std::move(distance_to_stop)});
     }
 }
-void TransportCatalogueExport::DeserializeTransportCatalogueBuses(transport_catalogue::TransportCatalogue& transport_catalogue_import,
+void TransportCatalogueExport::DeserializeTransportCatalogueBuses(const google::protobuf::RepeatedPtrField<transport_catalogue::Bus>& buses,
                                                                   SourceBusRequests& request_buses) const {
     // помещаем автобусы в переменную request_buses
     // ВАЖНО: первый элемент в векторе названий остановок - название маршрута
     // using SourceBusRequests = std::vector<std::pair<std::vector<std::string>, bool> >; // {names_stops, is_roundtrip}
-    for (auto& bus: transport_catalogue_import.buses()) {
+    for (auto& bus: buses) {
         std::vector<std::string> names_stops;
         names_stops.push_back(std::move(bus.name()));
         for (int i = 0; i < bus.stops_size(); ++i) {
@@ -305,111 +1087,17 @@ void TransportCatalogueExport::DeserializeTransportCatalogueBuses(transport_cata
     }
 }
 
-// _______________ Вспомогательные функции _______________
-
-void TransportCatalogueExport::AddPeekStop(const Stops::iterator pos, PeekStops& peek_stops) const {
-    peek_stops[pos->stop_name] = &(*pos);
-}
-void TransportCatalogueExport::AddStop(const Stop& stop, Stops& stops, PeekStops& peek_stops) const {
-    AddPeekStop(stops.insert(stops.end(), stop), peek_stops);
-}
-void TransportCatalogueExport::CreateStops(Stops& stops, PeekStops& peek_stops,
-                                           domain::DistanceBetweenStops& distance_between_stops,
-                                           const SourceStopRequests& request_stops) const {
-    for (const auto& stop : request_stops) {
-        AddStop(stop.first, stops, peek_stops);
-    }
-
-    for (const auto& stop : request_stops) {
-        const std::string& stop_from = stop.first.stop_name;
-        Stop* stop_from_address = peek_stops.at(stop_from);
-
-        for (const auto& [stop_to, distance] : stop.second) {
-            Stop* stop_to_address = peek_stops.at(stop_to);
-            if (distance_between_stops.find({stop_to_address, stop_from_address}) != distance_between_stops.end()) {
-                distance_between_stops[{stop_from_address, stop_to_address}] = distance;
-                continue;
-            }
-            distance_between_stops[{stop_from_address, stop_to_address}] = distance;
-            distance_between_stops[{stop_to_address, stop_from_address}] = distance;
-        }
-    }
-}
-
-void TransportCatalogueExport::AddPeekBus(const Buses::iterator pos, PeekBuses& peek_buses) const {
-    peek_buses[pos->bus_name] = &(*pos);
-}
-void TransportCatalogueExport::AddBus(const std::string& name, std::vector<Stop*> stops, Buses& buses, PeekBuses& peek_buses, bool is_roundtrip) const {
-    Bus bus(name, std::move(stops));
-    bus.is_roundtrip = is_roundtrip;
-    AddPeekBus(buses.insert(buses.end(), std::move(bus)), peek_buses);
-}
-void TransportCatalogueExport::CreateBus(const PeekStops& peek_stops, Buses& buses, PeekBuses& peek_buses, const SourceBusRequests& request_buses) const {
-    for (const auto& bus_pair : request_buses) {
-        const auto& bus = bus_pair.first;
-        const std::string& name = bus.at(0);
-        std::vector<Stop*> stops;
-        for (size_t i = 1; i < bus.size(); ++i) {
-            const std::string& stop = bus.at(i);
-            stops.push_back(peek_stops.at(stop));
-        }
-        bool is_roundtrip = bus_pair.second;
-        AddBus(name, std::move(stops), buses, peek_buses, is_roundtrip);
-    }
-}
+// _______________ Deserialize Map Renderer _______________
 
-void TransportCatalogueExport::CreateStopBuses(const Buses& buses, StopBuses& stop_buses, const Stops& stops) const {
-    for (const Bus& bus : buses) {
-        for (const Stop* stop : bus.bus_stops) {
-            stop_buses[stop->stop_name].insert(bus.bus_name);
-        }
-    }
+map_renderer::MapRenderer TransportCatalogueExport::DeserializeMapRenderer(const transport_catalogue::TransportCatalogue& transport_catalogue_import) const {
+    // создаем render_settings; автобусы и остановки для карты берутся из транспортного справочника
+    map_renderer::RenderSettings render_settings = DeserializeMapRendererRenderSettings(transport_catalogue_import.map_renderer());
 
-    for (const Stop& stop : stops) {
-        if (stop_buses.find(stop.stop_name) != stop_buses.end()) {
-            continue;
-        }
-        stop_buses.insert({stop.stop_name, {}});
-    }
+    return map_renderer::MapRenderer(std::move(render_settings));
 }
-
-// _______________ Deserialize Map Renderer _______________
-
-map_renderer::MapRenderer TransportCatalogueExport::DeserializeMapRenderer(transport_catalogue::TransportCatalogue& transport_catalogue_import,
-                                                                           const SourceStopRequests& request_stops,
-                                                                           const SourceBusRequests& request_buses) const {
-    transport_catalogue::MapRenderer map_renderer_import = std::move(transport_catalogue_import.map_renderer());
-
-    // создаем render_settings
-    map_renderer::RenderSettings render_settings = DeserializeMapRendererRenderSettings(map_renderer_import);
-
-    // на основе request_stops заполняем контейнеры для создания MapRender
-    Stops stops_to_mr;
-    PeekStops peek_stops_to_mr;
-    CreateStopsMap(stops_to_mr, peek_stops_to_mr, request_stops);
-
-    // на основе request_buses заполняем контейнеры для создания MapRender
-    Buses buses_to_mr;
-    PeekBuses peek_buses_to_mr;
-    ActualBuses actual_buses_to_mr;
-    ActualCoordinates actual_coordinates_to_mr;
-    ActualStops actual_stops_to_mr;
-    CreateBusMap(peek_stops_to_mr, buses_to_mr, peek_buses_to_mr,
-                 actual_buses_to_mr, actual_coordinates_to_mr, actual_stops_to_mr, request_buses);
-
-
-    return map_renderer::MapRenderer(std::move(render_settings),
-                                     std::move(stops_to_mr),
-                                     std::move(peek_stops_to_mr),
-                                     std::move(buses_to_mr),
-                                     std::move(peek_buses_to_mr),
-                                     std::move(actual_buses_to_mr),
-                                     std::move(actual_coordinates_to_mr),
-                                     std::move(actual_stops_to_mr));
-}
-map_renderer::RenderSettings TransportCatalogueExport::DeserializeMapRendererRenderSettings(transport_catalogue::MapRenderer& map_renderer) const {
+map_renderer::RenderSettings TransportCatalogueExport::DeserializeMapRendererRenderSettings(const transport_catalogue::MapRenderer& map_renderer) const {
     map_renderer::RenderSettings render_settings;
-    transport_catalogue::RenderSettings render_settings_import = std::move(map_renderer.render_settings());
+    const transport_catalogue::RenderSettings& render_settings_import = map_renderer.render_settings();
     render_settings.width = std::move(render_settings_import.width());
     render_settings.height = std::move(render_settings_import.height());
     render_settings.padding = std::move(render_settings_import.padding());
@@ -462,134 +1150,412 @@ map_renderer::RenderSettings TransportCatalogueExport::DeserializeMapRendererRen
     return render_settings;
 }
 
-// _______________ Вспомогательные функции _______________
+// _______________ Deserialize Transport Router _______________
 
-void TransportCatalogueExport::AddPeekStopMap(const Stops::iterator pos, PeekStops& peek_stops) const {
-    peek_stops[pos->stop_name] = &(*pos);
-}
-void TransportCatalogueExport::AddStopMap(const Stop& stop, Stops& stops, PeekStops& peek_stops) const {
-    AddPeekStopMap(stops.insert(stops.end(), stop), peek_stops);
-}
-void TransportCatalogueExport::CreateStopsMap(Stops& stops, PeekStops& peek_stops, const SourceStopRequests& request_stops) const {
-    for (const auto& stop : request_stops) {
-        AddStopMap(stop.first, stops, peek_stops);
+router::TransportRouter TransportCatalogueExport::DeserializeTransportRouter(const char* data, const std::vector<FieldRange>& ranges,
+                                                                            size_t stop_count,
+                                                                            const std::shared_ptr<const MappedFile>& file,
+                                                                            const std::optional<TableSection>& table_section) const {
+    using Proto = transport_catalogue::TransportCatalogue;
+    using RouterProto = transport_catalogue::TransportRouter;
+    using proto_stream::WireFormatLite;
+    google::protobuf::Arena arena;
+    auto* routing_settings_import = google::protobuf::Arena::CreateMessage<transport_catalogue::RoutingSettings>(&arena);
+    auto* routes_table_import = google::protobuf::Arena::CreateMessage<transport_catalogue::RoutesTable>(&arena);
+    auto* hierarchy_import = google::protobuf::Arena::CreateMessage<transport_catalogue::ContractionHierarchy>(&arena);
+    auto* landmarks_import = google::protobuf::Arena::CreateMessage<transport_catalogue::Landmarks>(&arena);
+    std::vector<std::string_view> names_table;
+    GraphFields graph_fields;
+
+    for (const auto& [begin, end] : ranges) {
+        proto_stream::CodedInputStream input(reinterpret_cast<const std::uint8_t*>(data + begin), end - begin);
+        const bool is_read = proto_stream::ReadFields(input, [&](int field_number, std::uint32_t tag) {
+            const bool is_length_delimited = WireFormatLite::GetTagWireType(tag) == WireFormatLite::WIRETYPE_LENGTH_DELIMITED;
+            if (field_number == Proto::kNamesFieldNumber && is_length_delimited) {
+                return proto_stream::ReadStringView(input, names_table.emplace_back());
+            }
+            if (field_number != Proto::kTransportRouterFieldNumber || !is_length_delimited) {
+                return WireFormatLite::SkipField(&input, tag);
+            }
+            return proto_stream::ReadNested(input, [&](int router_field_number, std::uint32_t router_tag) {
+                if (WireFormatLite::GetTagWireType(router_tag) != WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
+                    return WireFormatLite::SkipField(&input, router_tag);
+                }
+                switch (router_field_number) {
+                case RouterProto::kRoutingSettingsFieldNumber:
+                    return WireFormatLite::ReadMessage(&input, routing_settings_import);
+                case RouterProto::kGraphFieldNumber:
+                    return ReadTransportRouterProtoGraph(input, graph_fields);
+                case RouterProto::kRoutesTableFieldNumber:
+                    return WireFormatLite::ReadMessage(&input, routes_table_import);
+                case RouterProto::kHierarchyFieldNumber:
+                    return WireFormatLite::ReadMessage(&input, hierarchy_import);
+                case RouterProto::kLandmarksFieldNumber:
+                    return WireFormatLite::ReadMessage(&input, landmarks_import);
+                default:
+                    return WireFormatLite::SkipField(&input, router_tag);
+                }
+            });
+        });
+        if (!is_read) {
+            throw std::runtime_error("Corrupted database transport router");
+        }
+    }
+
+    // создаем routing_settings
+    router::RoutingSettings routing_settings_to_tc = DeserializeTransportRouterRoutingSettings(*routing_settings_import);
+
+    // создаем graph
+    if (graph_fields.layout > transport_catalogue::GRAPH_LAYOUT_CSR_DELTA) {
+        throw std::runtime_error("Unsupported database graph layout " + std::to_string(graph_fields.layout));
+    }
+    const bool is_original_layout = graph_fields.IsOriginalLayout();
+    graph::DirectedWeightedGraph<double> graph_to_tc = DeserializeTransportRouterGraph(std::move(graph_fields), names_table);
+
+    // создаем таблицу маршрутов (есть только у RouterType::ALL_PAIRS). В таблице базы исходного формата
+    // пустые ячейки пропущены и строки не восстановить: маршруты будут посчитаны по графу
+    std::optional<router::TableRouter::Table> routes_table_to_tc;
+    if (routing_settings_to_tc.router_type == router::RouterType::ALL_PAIRS && !is_original_layout) {
+        routes_table_to_tc = DeserializeTransportRoutesTable(*routes_table_import, graph_to_tc, file, table_section);
     }
-}
 
-void TransportCatalogueExport::AddPeekBusMap(const Buses::iterator pos, PeekBuses& peek_buses) const {
-    peek_buses[pos->bus_name] = &(*pos);
+    // создаем иерархию сжатия (есть только у RouterType::CONTRACTION_HIERARCHY)
+    std::optional<graph::ContractionHierarchy<double>> hierarchy_to_tc;
+    if (routing_settings_to_tc.router_type == router::RouterType::CONTRACTION_HIERARCHY) {
+        hierarchy_to_tc = DeserializeTransportHierarchy(*hierarchy_import, graph_to_tc.GetVertexCount(), graph_to_tc.GetEdgeCount());
+    }
+
+    // создаем ориентиры (есть только у RouterType::ALT)
+    std::optional<graph::Landmarks<double>> landmarks_to_tc;
+    if (routing_settings_to_tc.router_type == router::RouterType::ALT) {
+        landmarks_to_tc = DeserializeTransportLandmarks(*landmarks_import, graph_to_tc.GetVertexCount());
+    }
+
+    return router::TransportRouter(std::move(routing_settings_to_tc),
+                                   std::move(graph_to_tc),
+                                   stop_count,
+                                   std::move(routes_table_to_tc),
+                                   std::move(hierarchy_to_tc),
+                                   std::move(landmarks_to_tc));
+}
+router::RoutingSettings TransportCatalogueExport::DeserializeTransportRouterRoutingSettings(const transport_catalogue::RoutingSettings& routing_settings) const {
+    router::RoutingSettings routing_settings_to_tc(routing_settings.bus_wait_time(), routing_settings.bus_velocity());
+    routing_settings_to_tc.router_type = static_cast<router::RouterType>(routing_settings.router_type());
+    if (routing_settings.router_cache_size() != 0) {
+        routing_settings_to_tc.router_cache_size = routing_settings.router_cache_size();
+    }
+    routing_settings_to_tc.graph_model = static_cast<router::GraphModel>(routing_settings.graph_model());
+    if (routing_settings.landmark_count() != 0) {
+        routing_settings_to_tc.landmark_count = routing_settings.landmark_count();
+    }
+    return routing_settings_to_tc;
 }
-void TransportCatalogueExport::AddBusMap(const std::string& name, std::vector<Stop*> stops, Buses& buses, PeekBuses& peek_buses) const {
-    Bus bus(name, std::move(stops));
-    AddPeekBusMap(buses.insert(buses.end(), std::move(bus)), peek_buses);
+bool TransportCatalogueExport::ReadTransportRouterProtoGraph(proto_stream::CodedInputStream& input, GraphFields& graph_fields) const {
+    using Proto = transport_catalogue::Graph;
+    using proto_stream::ReadRepeated;
+    using proto_stream::WireFormatLite;
+    return proto_stream::ReadNested(input, [&](int field_number, std::uint32_t tag) {
+        switch (field_number) {
+        case Proto::kOffsetsFieldNumber:
+            return ReadRepeated<std::uint32_t>(input, tag, graph_fields.offsets);
+        case Proto::kTargetsFieldNumber:
+            return ReadRepeated<std::uint32_t>(input, tag, graph_fields.targets);
+        case Proto::kWeightsFieldNumber:
+            return ReadRepeated<double>(input, tag, graph_fields.weights);
+        case Proto::kNameIdsFieldNumber:
+            return ReadRepeated<std::uint32_t>(input, tag, graph_fields.name_ids);
+        case Proto::kSpanCountsFieldNumber:
+            return ReadRepeated<std::uint32_t>(input, tag, graph_fields.span_counts);
+        case Proto::kNameRefsFieldNumber:
+            return ReadRepeated<std::uint32_t>(input, tag, graph_fields.name_refs);
+        case Proto::kLayoutFieldNumber:
+            if (WireFormatLite::GetTagWireType(tag) == WireFormatLite::WIRETYPE_VARINT) {
+                return input.ReadVarint32(&graph_fields.layout);
+            }
+            return WireFormatLite::SkipField(&input, tag);
+        case Proto::kEdgesFieldNumber:
+            if (WireFormatLite::GetTagWireType(tag) == WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
+                transport_catalogue::Edge edge;
+                if (!WireFormatLite::ReadMessage(&input, &edge)) {
+                    return false;
+                }
+                graph_fields.edges.push_back({edge.vert_from().vertex_id(), edge.vert_to().vertex_id(), edge.weight(),
+                                              0, edge.span_count()});
+                graph_fields.edge_names.push_back(std::move(*edge.mutable_name()));
+                return true;
+            }
+            return WireFormatLite::SkipField(&input, tag);
+        case Proto::kIncidenceListsFieldNumber:
+            // списки инцидентности восстанавливаются по рёбрам, нужно только их число
+            ++graph_fields.incidence_list_count;
+            return WireFormatLite::SkipField(&input, tag);
+        case Proto::kNamesFieldNumber:
+            if (WireFormatLite::GetTagWireType(tag) == WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
+                std::string_view name;
+                if (!proto_stream::ReadStringView(input, name)) {
+                    return false;
+                }
+                graph_fields.names.emplace_back(name);
+                return true;
+            }
+            [[fallthrough]];
+        default:
+            return WireFormatLite::SkipField(&input, tag);
+        }
+    });
 }
-void TransportCatalogueExport::CreateBusMap(const PeekStops& peek_stops, Buses& buses, PeekBuses& peek_buses,
-                  ActualBuses& actual_buses, ActualCoordinates& actual_coordinates,
-                  ActualStops& actual_stops, const SourceBusRequests& request_buses) const {
-    for (const auto& bus_pair : request_buses) {
-        const auto& bus = bus_pair.first;
-        const std::string& name = bus.at(0);
+graph::DirectedWeightedGraph<double> TransportCatalogueExport::DeserializeTransportRouterGraph(GraphFields graph_fields,
+                                                                                               const std::vector<std::string_view>& names_table) const {
+    using Graph = graph::DirectedWeightedGraph<double>;
+    if (graph_fields.IsOriginalLayout()) {
+        // исходный формат: рёбра добавляются в записанном порядке, заморозка раскладывает их по вершинам
+        Graph graph(graph_fields.incidence_list_count);
+        for (size_t i = 0; i < graph_fields.edges.size(); ++i) {
+            auto edge = graph_fields.edges[i];
+            edge.name_id = graph.AddName(graph_fields.edge_names[i]);
+            graph.AddEdge(edge);
+        }
+        graph.Freeze();
+        return graph;
+    }
+    std::vector<std::string> names = std::move(graph_fields.names);
+    names.reserve(names.size() + graph_fields.name_refs.size());
+    // версия 2: названия - номера строк общей таблицы
+    for (const auto name_ref : graph_fields.name_refs) {
+        if (name_ref >= names_table.size()) {
+            throw std::runtime_error("Graph name is out of the database string table");
+        }
+        names.emplace_back(names_table[name_ref]);
+    }
+    if (graph_fields.layout == transport_catalogue::GRAPH_LAYOUT_CSR_DELTA) {
+        DecodeTransportRouterGraphDeltas(graph_fields);
+    }
 
-        std::vector<Stop*> stops;
-        for (size_t i = 1; i < bus.size(); ++i) {
-            const std::string& stop = bus.at(i);
-            stops.push_back(peek_stops.at(stop));
+    return Graph(std::move(graph_fields.offsets), std::move(graph_fields.targets), std::move(graph_fields.weights),
+                 std::move(graph_fields.name_ids), std::move(graph_fields.span_counts), std::move(names));
+}
+void TransportCatalogueExport::DecodeTransportRouterGraphDeltas(GraphFields& graph_fields) const {
+    using google::protobuf::internal::WireFormatLite;
+    // offsets записаны числами рёбер вершин
+    std::vector<graph::DirectedWeightedGraph<double>::Index> offsets;
+    offsets.reserve(graph_fields.offsets.size() + 1);
+    offsets.push_back(0);
+    std::uint64_t edge_count = 0;
+    for (const auto degree : graph_fields.offsets) {
+        edge_count += degree;
+        if (edge_count > graph_fields.targets.size()) {
+            throw std::runtime_error("Graph offsets are out of the database edges");
         }
+        offsets.push_back(static_cast<std::uint32_t>(edge_count));
+    }
+    graph_fields.offsets = std::move(offsets);
 
-        AddBusMap(name, std::move(stops), buses, peek_buses);
-        if (bus.size() > 1) {
-            const auto bus_pos = peek_buses.at(name);
-            actual_buses.insert({bus_pos->bus_name, bus_pair.second});
-            for (const auto stop : bus_pos->bus_stops) {
-                actual_coordinates.push_back(stop->stop_coordinates);
-                actual_stops.insert(stop->stop_name);
-            }
+    for (size_t vertex = 0; vertex + 1 < graph_fields.offsets.size(); ++vertex) {
+        std::uint32_t previous = static_cast<std::uint32_t>(vertex);
+        for (auto edge_id = graph_fields.offsets[vertex]; edge_id < graph_fields.offsets[vertex + 1]; ++edge_id) {
+            previous += static_cast<std::uint32_t>(WireFormatLite::ZigZagDecode32(graph_fields.targets[edge_id]));
+            graph_fields.targets[edge_id] = previous;
         }
+    }
+    std::uint32_t previous = 0;
+    for (auto& name_id : graph_fields.name_ids) {
+        previous += static_cast<std::uint32_t>(WireFormatLite::ZigZagDecode32(name_id));
+        name_id = previous;
+    }
+}
+std::optional<router::TableRouter::Table> TransportCatalogueExport::DeserializeTransportRoutesTable(const transport_catalogue::RoutesTable& routes_table,
+                                                                                                     const graph::DirectedWeightedGraph<double>& graph,
+                                                                                                     const std::shared_ptr<const MappedFile>& file,
+                                                                                                     const std::optional<TableSection>& table_section) const {
+    if (routes_table.is_compressed()) {
+        if (!table_section) {
+            return std::nullopt;
+        }
+        return MakeCompressedRoutesTable(routes_table, graph, file, *table_section);
+    }
 
+    const size_t vertex_count = routes_table.vertex_count();
+    const size_t cell_count = vertex_count * vertex_count;
+    const size_t weight_size = routes_table.weight_size();
+    const size_t weights_size = cell_count * weight_size;
+    const size_t prev_edges_size = cell_count * sizeof(graph::TableEdgeId);
+    if (weight_size != sizeof(float) && weight_size != sizeof(double)) {
+        return std::nullopt; // таблицы нет или она повреждена - маршруты будут пересчитаны
+    }
+
+    // плоскости лежат либо в самом сообщении, либо в секции таблицы после него
+    const char* weights_data = routes_table.weights().data();
+    const char* prev_edges_data = routes_table.prev_edges().data();
+    size_t section_size = 0;
+    if (table_section && cell_count != 0 && routes_table.weights().empty() && routes_table.prev_edges().empty()) {
+        section_size = table_section->size;
+        if (routes_table.weights_offset() > section_size || weights_size > section_size - routes_table.weights_offset()
+            || routes_table.prev_edges_offset() > section_size || prev_edges_size > section_size - routes_table.prev_edges_offset()) {
+            return std::nullopt;
+        }
+        weights_data = file->GetData() + table_section->offset + routes_table.weights_offset();
+        prev_edges_data = file->GetData() + table_section->offset + routes_table.prev_edges_offset();
+    } else if (routes_table.weights().size() != weights_size || routes_table.prev_edges().size() != prev_edges_size) {
+        return std::nullopt;
     }
+
+    return MakeRoutesTable(vertex_count, weight_size, weights_data, prev_edges_data, file, section_size != 0);
 }
+std::optional<router::TableRouter::Table> TransportCatalogueExport::MakeCompressedRoutesTable(const transport_catalogue::RoutesTable& routes_table,
+                                                                                               const graph::DirectedWeightedGraph<double>& graph,
+                                                                                               const std::shared_ptr<const MappedFile>& file,
+                                                                                               const TableSection& table_section) const {
+    const size_t vertex_count = routes_table.vertex_count();
+    const size_t weight_size = routes_table.weight_size();
+    const size_t section_offset = table_section.offset;
+    const size_t section_size = table_section.size;
+    const size_t row_offsets_size = (vertex_count + 1) * sizeof(std::uint64_t);
+    if ((weight_size != sizeof(float) && weight_size != sizeof(double)) || vertex_count != graph.GetVertexCount()
+        || routes_table.row_offsets_offset() % alignof(std::uint64_t) != 0
+        || routes_table.row_offsets_offset() > section_size || row_offsets_size > section_size - routes_table.row_offsets_offset()
+        || routes_table.rows_offset() > section_size) {
+        return std::nullopt; // таблица повреждена - маршруты будут пересчитаны
+    }
+    const char* section = file->GetData() + section_offset;
+    const auto* row_offsets = reinterpret_cast<const std::uint64_t*>(section + routes_table.row_offsets_offset());
+    const char* rows = section + routes_table.rows_offset();
+    const size_t rows_size = section_size - routes_table.rows_offset();
+    if (row_offsets[0] != 0 || row_offsets[vertex_count] > rows_size
+        || !std::is_sorted(row_offsets, row_offsets + vertex_count + 1)) {
+        return std::nullopt;
+    }
 
-// _______________ Deserialize Transport Router _______________
+    if (weight_size == sizeof(router::RouteTableWeight)) {
+        // строки читаются прямо из отображённого файла: запрос маршрута трогает страницы одной строки
+        file->AdviseRandomAccess(section_offset, section_size);
+        return router::TableRouter::Table(vertex_count, file, row_offsets, rows);
+    }
 
-router::TransportRouter TransportCatalogueExport::DeserializeTransportRouter(transport_catalogue::TransportCatalogue& transport_catalogue_import) const {
-    transport_catalogue::TransportRouter transport_router_import = std::move(transport_catalogue_import.transport_router());
+    // таблица записана сборкой с другой разрядностью весов: строки декодируются в ней и приводятся
+    router::TableRouter::Table routes_table_to_tc(vertex_count);
+    auto decode_rows = [&](auto stored_weight) {
+        std::vector<decltype(stored_weight)> row_weights(vertex_count);
+        for (size_t from = 0; from < vertex_count; ++from) {
+            const size_t row = routes_table_to_tc.GetCell(static_cast<graph::VertexId>(from), 0);
+            graph::table_rows::DecodeRow(rows + row_offsets[from], row_offsets[from + 1] - row_offsets[from], vertex_count,
+                                         graph, row_weights.data(), routes_table_to_tc.prev_edges.data() + row);
+            std::copy(row_weights.begin(), row_weights.end(), routes_table_to_tc.weights.begin() + row);
+        }
+    };
+    if (weight_size == sizeof(float)) {
+        decode_rows(float{});
+    } else {
+        decode_rows(double{});
+    }
+    return routes_table_to_tc;
+}
+std::optional<router::TableRouter::Table> TransportCatalogueExport::MakeRoutesTable(size_t vertex_count, size_t weight_size,
+                                                                                     const char* weights_data, const char* prev_edges_data,
+                                                                                     const std::shared_ptr<const MappedFile>& file,
+                                                                                     bool is_in_file) const {
+    const size_t cell_count = vertex_count * vertex_count;
+    const size_t weights_size = cell_count * weight_size;
+    const size_t prev_edges_size = cell_count * sizeof(graph::TableEdgeId);
+    auto is_aligned = [](const char* data, size_t alignment) {
+        return reinterpret_cast<std::uintptr_t>(data) % alignment == 0;
+    };
+    if (is_in_file && weight_size == sizeof(router::RouteTableWeight)
+        && is_aligned(weights_data, alignof(router::RouteTableWeight)) && is_aligned(prev_edges_data, alignof(graph::TableEdgeId))) {
+        // таблица читается прямо из отображённого файла: запрос маршрута трогает несколько страниц
+        // одной строки, упреждающее чтение соседних страниц ему не нужно
+        const size_t offset = std::min(weights_data, prev_edges_data) - file->GetData();
+        const size_t size = std::max(weights_data + weights_size, prev_edges_data + prev_edges_size) - file->GetData() - offset;
+        file->AdviseRandomAccess(offset, size);
+        file->AdviseHugePages(offset, size);
+        return router::TableRouter::Table(vertex_count, file,
+                                          reinterpret_cast<const router::RouteTableWeight*>(weights_data),
+                                          reinterpret_cast<const graph::TableEdgeId*>(prev_edges_data));
+    }
 
-    // создаем routing_settings
-    router::RoutingSettings routing_settings_to_tc(std::move(transport_router_import.routing_settings().bus_wait_time()),
-                                                   std::move(transport_router_import.routing_settings().bus_velocity()));
+    router::TableRouter::Table routes_table_to_tc(vertex_count);
+    // таблица могла быть записана сборкой с другой разрядностью весов
+    auto copy_weights = [&](auto stored_weight) {
+        using StoredWeight = decltype(stored_weight);
+        if constexpr (std::is_same_v<StoredWeight, router::RouteTableWeight>) {
+            std::memcpy(routes_table_to_tc.weights.data(), weights_data, weights_size);
+        } else {
+            std::vector<StoredWeight> stored_weights(cell_count);
+            std::memcpy(stored_weights.data(), weights_data, weights_size);
+            std::copy(stored_weights.begin(), stored_weights.end(), routes_table_to_tc.weights.begin());
+        }
+    };
+    if (weight_size == sizeof(float)) {
+        copy_weights(float{});
+    } else {
+        copy_weights(double{});
+    }
+    std::memcpy(routes_table_to_tc.prev_edges.data(), prev_edges_data, prev_edges_size);
 
-    // создаем graph
-    transport_catalogue::Graph graph_from_ser = std::move(transport_router_import.graph());
-    graph::DirectedWeightedGraph<double> graph_to_tc = DeserializeTransportRouterGraph(graph_from_ser);
+    return routes_table_to_tc;
+}
 
-    // создаем stop_names
-    std::vector<std::string> stop_names_to_tc;
-    for (auto &stop: transport_router_import.stop_names()) {
-        stop_names_to_tc.emplace_back(std::move(stop));
+std::optional<graph::ContractionHierarchy<double>> TransportCatalogueExport::DeserializeTransportHierarchy(const transport_catalogue::ContractionHierarchy& hierarchy,
+                                                                                                      size_t vertex_count, size_t edge_count) const {
+    using Hierarchy = graph::ContractionHierarchy<double>;
+    const size_t hierarchy_edge_count = hierarchy.edge_from_size();
+    if (static_cast<size_t>(hierarchy.edge_to_size()) != hierarchy_edge_count
+        || static_cast<size_t>(hierarchy.edge_weight_size()) != hierarchy_edge_count
+        || static_cast<size_t>(hierarchy.edge_first_size()) != hierarchy_edge_count
+        || static_cast<size_t>(hierarchy.edge_second_size()) != hierarchy_edge_count) {
+        return std::nullopt; // иерархии нет или она повреждена - она будет построена заново
     }
 
-    // создаем routes_internal_data
-    graph::Router<double>::RoutesInternalData internal_data_to_tc = DeserializeTransportRoutesInternalData(transport_router_import);
+    std::vector<Hierarchy::Rank> ranks(hierarchy.ranks().begin(), hierarchy.ranks().end());
+    std::vector<Hierarchy::HierarchyEdge> edges;
+    edges.reserve(hierarchy_edge_count);
+    for (size_t i = 0; i < hierarchy_edge_count; ++i) {
+        edges.push_back({hierarchy.edge_from(i), hierarchy.edge_to(i), hierarchy.edge_weight(i),
+                         hierarchy.edge_first(i), hierarchy.edge_second(i)});
+    }
 
-    return router::TransportRouter(std::move(routing_settings_to_tc),
-                                   std::move(graph_to_tc),
-                                   std::move(stop_names_to_tc),
-                                   std::move(internal_data_to_tc));
-}
-graph::DirectedWeightedGraph<double> TransportCatalogueExport::DeserializeTransportRouterGraph(transport_catalogue::Graph& graph_from_ser) const {
-    std::vector<graph::Edge<double>> edges_to_graph;
-    std::vector<std::vector<graph::EdgeId> > incidence_lists_to_graph;
-
-    for (auto& edge_from_ser: graph_from_ser.edges()) {
-        graph::Edge<double> edge;
-        edge.from = std::move(edge_from_ser.vert_from().vertex_id());
-        edge.to = std::move(edge_from_ser.vert_to().vertex_id());
-        edge.weight = std::move(edge_from_ser.weight());
-        edge.name = std::move(edge_from_ser.name());
-        edge.span_count = std::move(edge_from_ser.span_count());
-
-        edges_to_graph.push_back(std::move(edge));
-    }
-
-    for (size_t i = 0; i < graph_from_ser.incidence_lists_size(); ++i) {
-        std::vector<graph::EdgeId> incidence_list_to;
-        for (size_t j = 0; j < graph_from_ser.incidence_lists(i).edges_id_size(); ++j) {
-            incidence_list_to.emplace_back(std::move(graph_from_ser.incidence_lists(i).edges_id(j)));
-        }
-        incidence_lists_to_graph.emplace_back(std::move(incidence_list_to));
-    }
-
-    return graph::DirectedWeightedGraph<double> (std::move(edges_to_graph), std::move(incidence_lists_to_graph));;
-}
-graph::Router<double>::RoutesInternalData TransportCatalogueExport::DeserializeTransportRoutesInternalData(transport_catalogue::TransportRouter& transport_router) const {
-    graph::Router<double>::RoutesInternalData internal_data_to_tc;
-    for (auto& routes: transport_router.routes_internal_data()) {
-        std::vector <std::optional<graph::Router<double>::RouteInternalData>> routes_to_tc;
-        for (auto &route: routes.route_internal_data()) {
-            switch (route.elem_case()) {
-                case transport_catalogue::RouteInternalDataVectorElem::ElemCase::ELEM_NOT_SET:
-                    routes_to_tc.push_back(std::nullopt);
-                    break;
-                case transport_catalogue::RouteInternalDataVectorElem::ElemCase::kData:
-                    graph::Router<double>::RouteInternalData route_to_tc{};
-                    route_to_tc.weight = std::move(route.data().weight());
-                    switch (route.data().prev_case()) {
-                        case transport_catalogue::RouteInternalData::PrevCase::kPrevEdge:
-                            route_to_tc.prev_edge = std::make_optional(std::move(route.data().prev_edge().edge_id()));
-                            break;
-                        case transport_catalogue::RouteInternalData::PrevCase::PREV_NOT_SET:
-                            route_to_tc.prev_edge = std::nullopt;
-                            break;
-                    }
-                    routes_to_tc.push_back(std::move(route_to_tc));
-                    break;
-            }
+    return MakeHierarchy(std::move(ranks), std::move(edges), vertex_count, edge_count);
+}
+std::optional<graph::ContractionHierarchy<double>> TransportCatalogueExport::MakeHierarchy(std::vector<graph::ContractionHierarchy<double>::Rank> ranks,
+                                                                                       std::vector<graph::ContractionHierarchy<double>::HierarchyEdge> edges,
+                                                                                       size_t vertex_count, size_t edge_count) const {
+    if (ranks.size() != vertex_count) {
+        return std::nullopt;
+    }
+    for (size_t i = 0; i < edges.size(); ++i) {
+        const auto& edge = edges[i];
+        // шорткат ссылается только на рёбра, добавленные раньше него
+        const bool is_valid = edge.from < vertex_count && edge.to < vertex_count
+                              && (edge.IsShortcut() ? edge.first < i && edge.second < i : edge.first < edge_count);
+        if (!is_valid) {
+            return std::nullopt;
         }
+    }
+
+    return graph::ContractionHierarchy<double>(std::move(ranks), std::move(edges));
+}
 
-        internal_data_to_tc.push_back(std::move(routes_to_tc));
+std::optional<graph::Landmarks<double>> TransportCatalogueExport::DeserializeTransportLandmarks(const transport_catalogue::Landmarks& landmarks,
+                                                                                               size_t vertex_count) const {
+    return MakeLandmarks(std::vector<graph::VertexId>(landmarks.vertices().begin(), landmarks.vertices().end()),
+                         std::vector<double>(landmarks.distances_from().begin(), landmarks.distances_from().end()),
+                         std::vector<double>(landmarks.distances_to().begin(), landmarks.distances_to().end()),
+                         vertex_count);
+}
+std::optional<graph::Landmarks<double>> TransportCatalogueExport::MakeLandmarks(std::vector<graph::VertexId> vertices,
+                                                                                std::vector<double> distances_from,
+                                                                                std::vector<double> distances_to,
+                                                                                size_t vertex_count) const {
+    const size_t cell_count = vertices.size() * vertex_count;
+    if (vertices.empty() || distances_from.size() != cell_count || distances_to.size() != cell_count) {
+        return std::nullopt; // ориентиров нет или они повреждены - они будут выбраны заново
+    }
+    for (const auto vertex : vertices) {
+        if (vertex >= vertex_count) {
+            return std::nullopt;
+        }
     }
 
-    return internal_data_to_tc;
+    return graph::Landmarks<double>(vertex_count, std::move(vertices), std::move(distances_from), std::move(distances_to));
 }
 
 }
\ No newline at end of file
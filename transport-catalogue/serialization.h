@@ -5,16 +5,76 @@
 #include "transport_catalogue.h"
 #include "map_renderer.h"
 #include "transport_router.h"
+#include "mapped_file.h"
+#include "flat_format.h"
+#include "proto_stream.h"
 
+#include <cstdint>
 #include <filesystem>
 #include <iostream>
 #include <fstream>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 namespace serialization {
 
 using namespace domain;
 
+// Формат файла базы, задаётся полем "format" в serialization_settings
+enum class DatabaseFormat {
+    PROTOBUF, // сообщение transport_catalogue::TransportCatalogue (по умолчанию)
+    FLAT      // плоский файл секций flat, массивы читаются на месте
+};
+
+DatabaseFormat ParseDatabaseFormat(std::string_view name);
+
+// Части базы, которые читает Deserialize. Пропущенная часть не разбирается и остаётся пустой.
+// Маршрутизатору нужно число остановок из справочника, поэтому без справочника он читается пустым
+struct DatabaseSections {
+    bool transport_catalogue = true;
+    bool map_renderer = true;
+    bool transport_router = true;
+};
+
+// Хеши разделов входного JSON make_base. Справочник строится из остановок и автобусов, карта - из
+// render_settings, маршрутизатор - из справочника и routing_settings
+struct InputHashes {
+    std::uint64_t stops = 0;
+    std::uint64_t buses = 0;
+    std::uint64_t routing_settings = 0;
+    std::uint64_t render_settings = 0;
+};
+
+bool operator==(const InputHashes& lhs, const InputHashes& rhs);
+
+// Части базы, входные разделы которых не изменились: их можно взять из базы как есть
+DatabaseSections FindUnchangedSections(const InputHashes& previous, const InputHashes& current);
+
+// Изменение базы (make_delta) и хеши входных разделов базы, к которой оно относится
+struct DatabaseDelta {
+    InputHashes base_hashes;
+    transport::TransportCatalogue::Delta delta;
+};
+
+/*
+ * Файл базы - сообщение transport_catalogue::TransportCatalogue версии PROTO_VERSION: справочник -
+ * упакованными массивами по номерам, все названия - в одной таблице строк. Базы версии 1 (остановки
+ * и автобусы сообщениями с названиями) тоже читаются, в том числе с графом исходного формата (Graph.layout
+ * не задан, рёбра - сообщениями): его таблица маршрутов не читается. Таблица маршрутов RouterType::ALL_PAIRS
+ * пишется после него отдельной секцией, выровненной на страницу: сжатые строки таблицы
+ * (см. routes_table_rows.h) с массивом их смещений. Прежние базы хранят в секции плоскости весов и рёбер
+ * как есть, каждую с выровненного смещения. В конце файла - концевик TableSectionTrailer.
+ * process_requests отображает файл в память и читает таблицу на месте, без разбора и копирования:
+ * запрос маршрута декодирует одну строку.
+ * Файл без концевика - сообщение целиком (так пишутся базы без таблицы).
+ *
+ * DatabaseFormat::FLAT - файл секций flat (см. flat_format.h): массивы справочника, графа, таблицы маршрутов,
+ * иерархии и ориентиров лежат в нём как есть. Справочник, граф и таблица маршрутов читаются прямо
+ * из отображённого файла. Формат файла Deserialize определяет по его началу
+ */
 class TransportCatalogueExport {
 public:
     TransportCatalogueExport() = default;
@@ -28,72 +88,247 @@ public:
     void Serialize(const std::filesystem::path& path,
                    const transport::TransportCatalogue& transport_catalogue,
                    const map_renderer::MapRenderer& map_renderer,
-                   const router::TransportRouter& transport_router) const;
-    DesTransportCatalogue Deserialize(const std::filesystem::path& path) const;
+                   const router::TransportRouter& transport_router,
+                   DatabaseFormat format = DatabaseFormat::PROTOBUF,
+                   const std::optional<InputHashes>& input_hashes = std::nullopt) const;
+    // Файл пишется рядом под временным именем и затем заменяет прежний: прежняя база может быть
+    // отображена в память - части, взятые из неё, читаются прямо из файла
+    // С timings длительность чтения каждой части выводится в поток
+    DesTransportCatalogue Deserialize(const std::filesystem::path& path,
+                                      const DatabaseSections& sections = {},
+                                      std::ostream* timings = nullptr) const;
+    // Хеши входных разделов, записанные в базу; nullopt - файла нет, он не читается или хешей в нём нет
+    std::optional<InputHashes> ReadInputHashes(const std::filesystem::path& path) const;
+
+    // Файл изменения базы - сообщение transport_catalogue::Delta. Повреждённый файл - std::runtime_error
+    void SerializeDelta(const std::filesystem::path& path, const DatabaseDelta& delta) const;
+    DatabaseDelta DeserializeDelta(const std::filesystem::path& path) const;
+    // База path с наложенным изменением из delta_path; изменение другой базы - std::runtime_error.
+    // Справочник строится из базы и изменения, маршрутизатор - по маршрутизатору базы (см. TransportRouter)
+    DesTransportCatalogue Deserialize(const std::filesystem::path& path,
+                                      const std::filesystem::path& delta_path,
+                                      const DatabaseSections& sections = {},
+                                      std::ostream* timings = nullptr) const;
+    // Хеши базы, в которую свёрнуто изменение: хеши остановок и автобусов смешиваются с хешем изменения,
+    // так что следующий make_base не возьмёт из неё справочник и маршрутизатор
+    InputHashes MakeCompactedInputHashes(const DatabaseDelta& delta) const;
 
 private:
+    static constexpr std::uint32_t PROTO_VERSION = 2;
+
+    // Секция таблицы выравнивается на страницу записавшей машины: этого хватает, чтобы отображать её
+    // и размечать madvise. Выравнивание записано в концевике, так что читаются и базы с другим
+    static constexpr char TABLE_SECTION_MAGIC[8] = {'T', 'C', 'R', 'O', 'U', 'T', 'E', '2'};
+    struct TableSectionTrailer {
+        std::uint64_t message_size;      // размер сообщения в начале файла
+        std::uint64_t section_offset;    // начало секции таблицы
+        std::uint64_t section_alignment; // выравнивание начала секции
+        char magic[8];
+    };
+    // концевик прежних баз: без выравнивания, секция выровнена на 64 KiB
+    static constexpr char TABLE_SECTION_MAGIC_V1[8] = {'T', 'C', 'R', 'O', 'U', 'T', 'E', 'S'};
+    static constexpr size_t TABLE_SECTION_ALIGNMENT_V1 = 64 * 1024;
+    struct TableSectionTrailerV1 {
+        std::uint64_t message_size;
+        std::uint64_t section_offset;
+        char magic[8];
+    };
+
+    // Секция таблицы, найденная по концевику: сообщение - [0, message_size), секция - [offset, offset + size)
+    struct TableSection {
+        size_t message_size;
+        size_t offset;
+        size_t size;
+    };
+
+    static size_t GetTableSectionAlignment();
+    void WriteRoutesTableSection(std::ostream& out, size_t message_size, const router::TransportRouter& transport_router) const;
+    std::optional<TableSection> ReadTableSection(const MappedFile& file) const;
+
+    // Сообщение базы пишется в поток по частям (см. proto_stream.h): большие массивы справочника и графа -
+    // прямо из их памяти, дерево сообщений не строится. Возвращает размер сообщения
+    size_t SerializeProto(std::ostream& out,
+                          const transport::TransportCatalogue& transport_catalogue,
+                          const map_renderer::MapRenderer& map_renderer,
+                          const router::TransportRouter& transport_router,
+                          const std::optional<InputHashes>& input_hashes) const;
+
+    // Поля верхнего уровня сообщения базы по частям: диапазоны байтов [first, second) от начала сообщения.
+    // Части разбираются независимо, а поля ненужных частей не разбираются совсем
+    using FieldRange = std::pair<int, int>;
+    struct MessageParts {
+        std::vector<FieldRange> transport_catalogue;
+        std::vector<FieldRange> map_renderer;
+        std::vector<FieldRange> transport_router;
+        std::vector<FieldRange> input_hashes;
+        std::uint32_t version = 1;
+        size_t stop_count = 0;
+    };
+    MessageParts ScanTransportCatalogueProto(const char* data, size_t size) const;
+    void ParseTransportCatalogueProtoFields(const char* data, const std::vector<FieldRange>& ranges,
+                                            transport_catalogue::TransportCatalogue& transport_catalogue_import) const;
+
+    // _______________ Flat Format _______________
+    enum FlatSection : flat::SectionId {
+        STOP_NAME_CHARS = 1,
+        STOP_NAME_OFFSETS,
+        STOP_NAME_ORDER,
+        STOP_COORDINATES,
+        BUS_NAME_CHARS,
+        BUS_NAME_OFFSETS,
+        BUS_NAME_ORDER,
+        BUS_IS_ROUNDTRIP,
+        BUS_STOP_OFFSETS,
+        BUS_STOPS,
+        STOP_BUS_OFFSETS,
+        STOP_BUSES,
+        DISTANCE_OFFSETS,
+        DISTANCE_TARGETS,
+        DISTANCE_VALUES,
+        DISTANCE_IS_DERIVED,      // нет в базах, записанных до его появления
+
+        MAP_RENDERER = 100,       // сообщение transport_catalogue::MapRenderer
+        ROUTING_SETTINGS,         // сообщение transport_catalogue::RoutingSettings
+        INPUT_HASHES,             // сообщение transport_catalogue::InputHashes
+
+        GRAPH_OFFSETS = 200,
+        GRAPH_SOURCES,            // пишется только старыми версиями: начала рёбер выводятся из GRAPH_OFFSETS
+        GRAPH_TARGETS,
+        GRAPH_WEIGHTS,
+        GRAPH_NAME_IDS,
+        GRAPH_SPAN_COUNTS,
+        GRAPH_NAME_CHARS,
+        GRAPH_NAME_OFFSETS,
+
+        ROUTES_TABLE_WEIGHTS = 300,
+        ROUTES_TABLE_PREV_EDGES,
+        HIERARCHY_RANKS,
+        HIERARCHY_EDGES,
+        LANDMARK_VERTICES,
+        LANDMARK_DISTANCES_FROM,
+        LANDMARK_DISTANCES_TO
+    };
+
+    void SerializeFlat(std::ostream& out,
+                       const transport::TransportCatalogue& transport_catalogue,
+                       const map_renderer::MapRenderer& map_renderer,
+                       const router::TransportRouter& transport_router,
+                       const std::optional<InputHashes>& input_hashes) const;
+    router::TableRouter::Table DecodeRoutesTableRows(const router::TableRouter::Table& routes_table,
+                                                     const graph::DirectedWeightedGraph<double>& graph) const;
+    DesTransportCatalogue DeserializeFlat(const std::shared_ptr<const MappedFile>& file,
+                                          const DatabaseSections& sections, std::ostream* timings) const;
+    transport::TransportCatalogue DeserializeFlatTransportCatalogue(const flat::Reader& reader) const;
+    router::TransportRouter DeserializeFlatTransportRouter(const flat::Reader& reader, size_t stop_count) const;
+    graph::DirectedWeightedGraph<double> DeserializeFlatTransportRouterGraph(const flat::Reader& reader) const;
+    std::optional<router::TableRouter::Table> DeserializeFlatTransportRoutesTable(const flat::Reader& reader, size_t vertex_count) const;
+
     // _______________ Serialize Transport Catalogue _______________
-    transport_catalogue::TransportCatalogue MakeTransportCatalogueProtoStops(const transport::TransportCatalogue& transport_catalogue) const;
-    transport_catalogue::TransportCatalogue MakeTransportCatalogueProtoBuses(const transport::TransportCatalogue& transport_catalogue) const;
+    // Явно заданные расстояния справочника в CSR-виде: взятые из обратных выводятся при загрузке
+    struct ExplicitDistances {
+        std::vector<std::uint32_t> offsets{0};
+        std::vector<transport::StopId> targets;
+        std::vector<std::int32_t> values;
+    };
+    ExplicitDistances MakeExplicitDistances(const transport::TransportCatalogue& transport_catalogue) const;
+    void WriteTransportCatalogueProtoCatalogue(proto_stream::Sink& sink,
+                                               const transport::TransportCatalogue& transport_catalogue,
+                                               const ExplicitDistances& distances) const;
+
+    // _______________ Input Hashes _______________
+    transport_catalogue::InputHashes MakeInputHashesProto(const InputHashes& input_hashes) const;
+    InputHashes DeserializeInputHashes(const transport_catalogue::InputHashes& input_hashes) const;
+
+    // _______________ Delta _______________
+    transport_catalogue::Delta MakeDeltaProto(const DatabaseDelta& delta) const;
 
     // _______________ Serialize Map Renderer _______________
     transport_catalogue::MapRenderer SerializeMapRenderer(const map_renderer::MapRenderer& map_renderer) const;
     transport_catalogue::RenderSettings MakeMapRendererProtoRendererSettings(const map_renderer::MapRenderer& map_renderer) const;
-    transport_catalogue::MapRenderer MakeMapRendererProtoActualCoordinates(const map_renderer::MapRenderer& map_renderer) const;
 
     // _______________ Serialize Transport Router _______________
-    transport_catalogue::TransportRouter SerializeTransportRouter(const router::TransportRouter& transport_router) const;
+    // name_refs - номера строк названий рёбер графа в общей таблице строк
+    void WriteTransportRouterProto(proto_stream::Sink& sink, const router::TransportRouter& transport_router,
+                                   const std::vector<std::uint32_t>& name_refs) const;
     transport_catalogue::RoutingSettings MakeTransportRouterProtoRoutingSettings(const router::TransportRouter& transport_router) const;
-    transport_catalogue::Graph MakeTransportRouterProtoGraph(const router::TransportRouter& transport_router) const;
-    transport_catalogue::TransportRouter MakeTransportRouterProtoStopNames(const router::TransportRouter& transport_router) const;
-    transport_catalogue::TransportRouter MakeTransportRouterProtoStopRoutesInternalData(const router::TransportRouter& transport_router) const;
+    void WriteTransportRouterProtoGraph(proto_stream::Sink& sink, const router::TransportRouter& transport_router,
+                                        const std::vector<std::uint32_t>& name_refs) const;
+    transport_catalogue::RoutesTable MakeTransportRouterProtoRoutesTable(const router::TransportRouter& transport_router) const;
+    void WriteTransportRouterProtoHierarchy(proto_stream::Sink& sink, const router::TransportRouter& transport_router) const;
+    void WriteTransportRouterProtoLandmarks(proto_stream::Sink& sink, const router::TransportRouter& transport_router) const;
 
 private:
     // _______________ Deserialize Transport Catalogue _______________
-    transport::TransportCatalogue DeserializeTransportCatalogue(transport_catalogue::TransportCatalogue& transport_catalogue_import,
-                                                                SourceStopRequests& request_stops,
-                                                                SourceBusRequests& request_buses) const;
-    void DeserializeTransportCatalogueStops(transport_catalogue::TransportCatalogue& transport_catalogue_import,
+    // версия 1 - из разобранного сообщения
+    transport::TransportCatalogue DeserializeTransportCatalogue(transport_catalogue::TransportCatalogue& transport_catalogue_import) const;
+    // версия 2 - прямо из полей части справочника: массивы читаются в справочник, названия - ссылками на файл
+    transport::TransportCatalogue DeserializeTransportCatalogueV2(const char* data, const std::vector<FieldRange>& ranges) const;
+    // остановки и автобусы сообщениями версии 1 (справочник версии 1 и файл изменения)
+    void DeserializeTransportCatalogueStops(const google::protobuf::RepeatedPtrField<transport_catalogue::Stop>& stops,
                                             SourceStopRequests& request_stops) const;
-    void DeserializeTransportCatalogueBuses(transport_catalogue::TransportCatalogue& transport_catalogue_import,
+    void DeserializeTransportCatalogueBuses(const google::protobuf::RepeatedPtrField<transport_catalogue::Bus>& buses,
                                             SourceBusRequests& request_buses) const;
 
-    // _______________ Вспомогательные функции _______________
-
-    void AddPeekStop(const Stops::iterator pos, PeekStops& peek_stops) const;
-    void AddStop(const Stop& stop, Stops& stops, PeekStops& peek_stops) const;
-    void CreateStops(Stops& stops, PeekStops& peek_stops,
-                     domain::DistanceBetweenStops& distance_between_stops,
-                     const SourceStopRequests& request_stops) const;
-
-    void AddPeekBus(const Buses::iterator pos, PeekBuses& peek_buses) const;
-    void AddBus(const std::string& name, std::vector<Stop*> stops, Buses& buses, PeekBuses& peek_buses, bool is_roundtrip) const;
-    void CreateBus(const PeekStops& peek_stops, Buses& buses, PeekBuses& peek_buses, const SourceBusRequests& request_buses) const;
-
-    void CreateStopBuses(const Buses& buses, StopBuses& stop_buses, const Stops& stops) const;
-
     // _______________ Deserialize Map Renderer _______________
-    map_renderer::MapRenderer DeserializeMapRenderer(transport_catalogue::TransportCatalogue& transport_catalogue_import,
-                                                     const SourceStopRequests& request_stops,
-                                                     const SourceBusRequests& request_buses) const;
-    map_renderer::RenderSettings DeserializeMapRendererRenderSettings(transport_catalogue::MapRenderer& map_renderer) const;
-
-    // _______________ Вспомогательные функции _______________
-
-    void AddPeekStopMap(const Stops::iterator pos, PeekStops& peek_stops) const;
-    void AddStopMap(const Stop& stop, Stops& stops, PeekStops& peek_stops) const;
-    void CreateStopsMap(Stops& stops, PeekStops& peek_stops, const SourceStopRequests& request_stops) const;
-
-    void AddPeekBusMap(const Buses::iterator pos, PeekBuses& peek_buses) const;
-    void AddBusMap(const std::string& name, std::vector<Stop*> stops, Buses& buses, PeekBuses& peek_buses) const;
-    void CreateBusMap(const PeekStops& peek_stops, Buses& buses, PeekBuses& peek_buses,
-                      ActualBuses& actual_buses, ActualCoordinates& actual_coordinates,
-                      ActualStops& actual_stops, const SourceBusRequests& request_buses) const;
+    map_renderer::MapRenderer DeserializeMapRenderer(const transport_catalogue::TransportCatalogue& transport_catalogue_import) const;
+    map_renderer::RenderSettings DeserializeMapRendererRenderSettings(const transport_catalogue::MapRenderer& map_renderer) const;
 
     // _______________ Deserialize Transport Router _______________
-    router::TransportRouter DeserializeTransportRouter(transport_catalogue::TransportCatalogue& transport_catalogue_import) const;
-    graph::DirectedWeightedGraph<double> DeserializeTransportRouterGraph(transport_catalogue::Graph& graph_from_ser) const;
-    graph::Router<double>::RoutesInternalData DeserializeTransportRoutesInternalData(transport_catalogue::TransportRouter& transport_router) const;
+    // Граф читается из полей части маршрутизатора прямо в массивы, остальные сообщения - на арене
+    router::TransportRouter DeserializeTransportRouter(const char* data, const std::vector<FieldRange>& ranges,
+                                                       size_t stop_count,
+                                                       const std::shared_ptr<const MappedFile>& file,
+                                                       const std::optional<TableSection>& table_section) const;
+    router::RoutingSettings DeserializeTransportRouterRoutingSettings(const transport_catalogue::RoutingSettings& routing_settings) const;
+    // Поля сообщения transport_catalogue::Graph
+    struct GraphFields {
+        std::vector<graph::DirectedWeightedGraph<double>::Index> offsets;
+        std::vector<graph::DirectedWeightedGraph<double>::Index> targets;
+        std::vector<double> weights;
+        std::vector<graph::NameId> name_ids;
+        std::vector<graph::DirectedWeightedGraph<double>::Index> span_counts;
+        std::vector<std::string> names;
+        std::vector<std::uint32_t> name_refs;
+        std::uint32_t layout = 0;
+        // исходный формат: рёбра с названиями строками, число вершин - число списков инцидентности
+        std::vector<graph::Edge<double>> edges;
+        std::vector<std::string> edge_names;
+        size_t incidence_list_count = 0;
+
+        bool IsOriginalLayout() const {
+            return !edges.empty() || incidence_list_count != 0;
+        }
+    };
+    bool ReadTransportRouterProtoGraph(proto_stream::CodedInputStream& input, GraphFields& graph_fields) const;
+    graph::DirectedWeightedGraph<double> DeserializeTransportRouterGraph(GraphFields graph_fields,
+                                                                         const std::vector<std::string_view>& names_table) const;
+    // Раскрывает разности вида GRAPH_LAYOUT_CSR_DELTA в обычные CSR-массивы
+    void DecodeTransportRouterGraphDeltas(GraphFields& graph_fields) const;
+    std::optional<router::TableRouter::Table> DeserializeTransportRoutesTable(const transport_catalogue::RoutesTable& routes_table,
+                                                                              const graph::DirectedWeightedGraph<double>& graph,
+                                                                              const std::shared_ptr<const MappedFile>& file,
+                                                                              const std::optional<TableSection>& table_section) const;
+    // Сжатые строки читаются на месте; записанные с другой разрядностью весов декодируются в плоскости
+    std::optional<router::TableRouter::Table> MakeCompressedRoutesTable(const transport_catalogue::RoutesTable& routes_table,
+                                                                        const graph::DirectedWeightedGraph<double>& graph,
+                                                                        const std::shared_ptr<const MappedFile>& file,
+                                                                        const TableSection& table_section) const;
+    // is_in_file - плоскости лежат в отображённом файле и при подходящей разрядности весов читаются на месте
+    std::optional<router::TableRouter::Table> MakeRoutesTable(size_t vertex_count, size_t weight_size,
+                                                              const char* weights_data, const char* prev_edges_data,
+                                                              const std::shared_ptr<const MappedFile>& file,
+                                                              bool is_in_file) const;
+    std::optional<graph::ContractionHierarchy<double>> DeserializeTransportHierarchy(const transport_catalogue::ContractionHierarchy& hierarchy,
+                                                                                     size_t vertex_count, size_t edge_count) const;
+    std::optional<graph::ContractionHierarchy<double>> MakeHierarchy(std::vector<graph::ContractionHierarchy<double>::Rank> ranks,
+                                                                     std::vector<graph::ContractionHierarchy<double>::HierarchyEdge> edges,
+                                                                     size_t vertex_count, size_t edge_count) const;
+    std::optional<graph::Landmarks<double>> DeserializeTransportLandmarks(const transport_catalogue::Landmarks& landmarks,
+                                                                          size_t vertex_count) const;
+    std::optional<graph::Landmarks<double>> MakeLandmarks(std::vector<graph::VertexId> vertices,
+                                                          std::vector<double> distances_from,
+                                                          std::vector<double> distances_to,
+                                                          size_t vertex_count) const;
 
 };
 
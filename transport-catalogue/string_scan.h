@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// STRING_SCAN_SCALAR отключает SIMD: так собирается скалярный вариант бенчмарка для сравнения
+#if defined(STRING_SCAN_SCALAR)
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define STRING_SCAN_AVX2
+#define STRING_SCAN_SSE2
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define STRING_SCAN_SSE2
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace string_scan {
+
+namespace detail {
+
+inline unsigned CountTrailingZeros(std::uint32_t mask) {
+#if defined(_MSC_VER)
+    unsigned long index = 0;
+    _BitScanForward(&index, mask);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+
+#if defined(STRING_SCAN_SSE2)
+// Маска байтов блока, равных одному из Chars
+template <char... Chars>
+inline std::uint32_t MatchMask16(const char* data) {
+    const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+    __m128i matches = _mm_setzero_si128();
+    ((matches = _mm_or_si128(matches, _mm_cmpeq_epi8(block, _mm_set1_epi8(Chars)))), ...);
+    return static_cast<std::uint32_t>(_mm_movemask_epi8(matches));
+}
+#endif
+
+#if defined(STRING_SCAN_AVX2)
+template <char... Chars>
+inline std::uint32_t MatchMask32(const char* data) {
+    const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+    __m256i matches = _mm256_setzero_si256();
+    ((matches = _mm256_or_si256(matches, _mm256_cmpeq_epi8(block, _mm256_set1_epi8(Chars)))), ...);
+    return static_cast<std::uint32_t>(_mm256_movemask_epi8(matches));
+}
+#endif
+
+}  // namespace detail
+
+/*
+ * Позиция первого из символов Chars в text начиная с pos, text.size(), если их нет.
+ * Текст просматривается блоками по 32 (AVX2) и 16 (SSE2) байт, остаток короче блока - по символу.
+ * Байты UTF-8 многобайтовых символов (кириллица) старше 0x7F и с ASCII-символами Chars не совпадают,
+ * так что строки между найденными символами можно копировать целиком
+ */
+template <char... Chars>
+size_t FindFirstOf(std::string_view text, size_t pos) {
+    const char* data = text.data();
+    const size_t size = text.size();
+#if defined(STRING_SCAN_AVX2)
+    for (; pos + 32 <= size; pos += 32) {
+        if (const std::uint32_t mask = detail::MatchMask32<Chars...>(data + pos); mask != 0) {
+            return pos + detail::CountTrailingZeros(mask);
+        }
+    }
+#endif
+#if defined(STRING_SCAN_SSE2)
+    for (; pos + 16 <= size; pos += 16) {
+        if (const std::uint32_t mask = detail::MatchMask16<Chars...>(data + pos); mask != 0) {
+            return pos + detail::CountTrailingZeros(mask);
+        }
+    }
+#endif
+    for (; pos < size; ++pos) {
+        const char ch = data[pos];
+        if (((ch == Chars) || ...)) {
+            return pos;
+        }
+    }
+    return size;
+}
+
+}  // namespace string_scan
@@ -1,4 +1,5 @@
 #include "svg.h"
+#include "string_scan.h"
 
 namespace svg {
 
@@ -131,29 +132,32 @@ Text& Text::SetFontWeight(std::string font_weight) {
 }
 
 Text& Text::SetData(std::string data) {
-    size_t i = 0;
-    while (i < data.size()) {
-        switch (data[i]) {
+    data_.reserve(data_.size() + data.size());
+    for (size_t pos = 0; pos != data.size();) {
+        // участок без специальных символов XML копируется целиком
+        const size_t special = string_scan::FindFirstOf<'"', '\'', '<', '>', '&'>(data, pos);
+        data_.append(data, pos, special - pos);
+        if (special == data.size()) {
+            break;
+        }
+        switch (data[special]) {
             case '\"':
-                data_+= "&quot;"s;
+                data_ += "&quot;"sv;
                 break;
             case '\'':
-                data_+= "&apos;"s;
+                data_ += "&apos;"sv;
                 break;
             case '<':
-                data_+= "&lt;"s;
+                data_ += "&lt;"sv;
                 break;
             case '>':
-                data_+= "&gt;"s;
-                break;
-            case '&':
-                data_+= "&amp;"s;
+                data_ += "&gt;"sv;
                 break;
             default:
-                data_+= data[i];
+                data_ += "&amp;"sv;
                 break;
         }
-        ++i;
+        pos = special + 1;
     }
 
     return *this;
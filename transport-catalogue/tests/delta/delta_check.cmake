@@ -0,0 +1,52 @@
+# Изменение базы, наложенное при загрузке и свёрнутое compact, отвечает на запросы так же, как база,
+# построенная make_base заново из изменённых запросов.
+# Параметры: TRANSPORT_CATALOGUE - программа, SOURCE_DIR - эта директория, WORK_DIR - рабочая директория,
+# ROUTER - значение "router", FORMAT - формат базы
+
+file(REMOVE_RECURSE ${WORK_DIR})
+file(MAKE_DIRECTORY ${WORK_DIR})
+foreach (input make_base make_full compact)
+    configure_file(${SOURCE_DIR}/${input}.json.in ${WORK_DIR}/${input}.json @ONLY)
+endforeach()
+configure_file(${SOURCE_DIR}/make_delta.json ${WORK_DIR}/make_delta.json COPYONLY)
+set(DATABASE base.db)
+set(DELTA base.delta)
+configure_file(${SOURCE_DIR}/process_requests.json.in ${WORK_DIR}/process_base.json @ONLY)
+set(DATABASE full.db)
+set(DELTA full.delta)
+configure_file(${SOURCE_DIR}/process_requests.json.in ${WORK_DIR}/process_full.json @ONLY)
+
+function(run mode input output)
+    execute_process(COMMAND ${TRANSPORT_CATALOGUE} ${mode}
+                    WORKING_DIRECTORY ${WORK_DIR}
+                    INPUT_FILE ${WORK_DIR}/${input}
+                    OUTPUT_FILE ${WORK_DIR}/${output}
+                    ERROR_VARIABLE error
+                    RESULT_VARIABLE result)
+    if (NOT result EQUAL 0)
+        message(FATAL_ERROR "${mode} < ${input} failed (${result}): ${error}")
+    endif()
+endfunction()
+
+function(compare expected actual)
+    execute_process(COMMAND ${CMAKE_COMMAND} -E compare_files ${WORK_DIR}/${expected} ${WORK_DIR}/${actual}
+                    RESULT_VARIABLE result)
+    if (NOT result EQUAL 0)
+        file(READ ${WORK_DIR}/${expected} expected_text)
+        file(READ ${WORK_DIR}/${actual} actual_text)
+        message(FATAL_ERROR "${actual} differs from ${expected}\n${expected}:\n${expected_text}\n${actual}:\n${actual_text}")
+    endif()
+endfunction()
+
+run(make_base make_full.json make_full.out)
+run(process_requests process_full.json full.txt)
+run(make_base make_base.json make_base.out)
+run(make_delta make_delta.json make_delta.out)
+run(process_requests process_base.json delta.txt)
+compare(full.txt delta.txt)
+run(compact compact.json compact.out)
+if (EXISTS ${WORK_DIR}/base.delta)
+    message(FATAL_ERROR "compact left base.delta in place")
+endif()
+run(process_requests process_base.json compact.txt)
+compare(full.txt compact.txt)
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdlib>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace concurrency {
+
+/*
+ * Пул потоков фиксированного размера. Задачи выполняются в порядке поступления,
+ * результат возвращается через std::future
+ */
+class ThreadPool {
+public:
+    // thread_count == 0 - по числу аппаратных потоков. Вызывающий поток считается одним из них
+    explicit ThreadPool(size_t thread_count = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t GetThreadCount() const;
+
+    template <typename Task>
+    std::future<std::invoke_result_t<Task>> Submit(Task task);
+
+    // Делит [begin, end) на непрерывные части по числу потоков и вызывает func(part_begin, part_end)
+    // для каждой части. Первая часть выполняется в вызывающем потоке. Возвращает управление,
+    // когда обработаны все части
+    template <typename Func>
+    void ParallelFor(size_t begin, size_t end, Func func);
+
+private:
+    std::vector<std::thread> workers_;
+    std::queue<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable has_task_;
+    bool stopped_ = false;
+
+    void Work();
+};
+
+template <typename Task>
+std::future<std::invoke_result_t<Task>> ThreadPool::Submit(Task task) {
+    using Result = std::invoke_result_t<Task>;
+    auto packaged_task = std::make_shared<std::packaged_task<Result()>>(std::move(task));
+    std::future<Result> result = packaged_task->get_future();
+    if (workers_.empty()) { // однопоточный пул: выполняем задачу сразу
+        (*packaged_task)();
+        return result;
+    }
+    {
+        std::lock_guard guard(mutex_);
+        tasks_.push([packaged_task] { (*packaged_task)(); });
+    }
+    has_task_.notify_one();
+    return result;
+}
+
+template <typename Func>
+void ThreadPool::ParallelFor(size_t begin, size_t end, Func func) {
+    if (begin >= end) {
+        return;
+    }
+    const size_t part_count = std::min(end - begin, workers_.size() + 1);
+    const size_t part_size = (end - begin + part_count - 1) / part_count;
+
+    std::vector<std::future<void>> parts;
+    parts.reserve(part_count);
+    for (size_t part_begin = begin + part_size; part_begin < end; part_begin += part_size) {
+        const size_t part_end = std::min(end, part_begin + part_size);
+        parts.push_back(Submit([&func, part_begin, part_end] { func(part_begin, part_end); }));
+    }
+    func(begin, std::min(end, begin + part_size));
+
+    for (auto& part : parts) {
+        part.get();
+    }
+}
+
+}  // namespace concurrency
@@ -1,71 +1,503 @@
-#include <deque>
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
 #include <string>
 #include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
-#include <set>
-#include <iostream>
 
 #include "transport_catalogue.h"
 
 namespace transport {
 
-TransportCatalogue::TransportCatalogue(Stops stops,
-                                       PeekStops peek_stops,
-                                       Buses buses,
-                                       PeekBuses peek_buses,
-                                       StopBuses stop_buses,
-                                       domain::DistanceBetweenStops distance_between_stops)
-                                       : stops_(std::move(stops))
-                                       , peek_stops_(std::move(peek_stops))
-                                       , buses_(std::move(buses))
-                                       , peek_buses_(std::move(peek_buses))
-                                       , stop_buses_(std::move(stop_buses))
-                                       , distance_between_stops_(std::move(distance_between_stops)) {
-}
+namespace {
 
-const Bus* TransportCatalogue::FindBusByName(std::string_view name) const {
-    if (peek_buses_.find(name) == peek_buses_.end()) {
-        return nullptr;
+std::string_view GetString(ranges::Span<char> chars, ranges::Span<std::uint32_t> offsets, std::uint32_t index) {
+    if (index + 1 >= offsets.size()) {
+        throw std::out_of_range("String index is out of range");
     }
+    return {chars.data() + offsets[index], offsets[index + 1] - offsets[index]};
+}
+
+void AddString(std::vector<char>& chars, std::vector<std::uint32_t>& offsets, std::string_view str) {
+    chars.insert(chars.end(), str.begin(), str.end());
+    offsets.push_back(static_cast<std::uint32_t>(chars.size()));
+}
 
-    return peek_buses_.at(name);
+// Номера строк таблицы в порядке возрастания строк; равные строки - в порядке номеров
+std::vector<std::uint32_t> SortByName(ranges::Span<char> chars, ranges::Span<std::uint32_t> offsets) {
+    std::vector<std::uint32_t> order(offsets.size() - 1);
+    for (std::uint32_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](std::uint32_t lhs, std::uint32_t rhs) {
+        return GetString(chars, offsets, lhs) < GetString(chars, offsets, rhs);
+    });
+    return order;
 }
 
-const Stop* TransportCatalogue::FindStopByName(std::string_view name) const {
-    if (peek_stops_.find(name) == peek_stops_.end()) {
-        return nullptr;
+std::optional<std::uint32_t> FindByName(ranges::Span<char> chars, ranges::Span<std::uint32_t> offsets,
+                                        ranges::Span<std::uint32_t> order, std::string_view name) {
+    const auto it = std::lower_bound(order.begin(), order.end(), name, [&](std::uint32_t index, std::string_view value) {
+        return GetString(chars, offsets, index) < value;
+    });
+    if (it == order.end() || GetString(chars, offsets, *it) != name) {
+        return std::nullopt;
     }
+    return *it;
+}
 
-    return peek_stops_.at(name);
+void CheckOffsets(ranges::Span<std::uint32_t> offsets, size_t count, size_t total) {
+    if (offsets.size() != count + 1 || offsets.front() != 0 || offsets.back() != total) {
+        throw std::invalid_argument("Inconsistent catalogue offsets");
+    }
+    for (size_t i = 0; i < count; ++i) {
+        if (offsets[i] > offsets[i + 1]) {
+            throw std::invalid_argument("Catalogue offsets should be non-decreasing");
+        }
+    }
 }
 
-const std::set<std::string_view>* TransportCatalogue::FindBusesForStop(std::string_view stop) const {
-    if (peek_stops_.find(stop) == peek_stops_.end()) {
-        return nullptr;
+void CheckIds(ranges::Span<std::uint32_t> ids, size_t count) {
+    for (const auto id : ids) {
+        if (id >= count) {
+            throw std::invalid_argument("Catalogue id is out of range");
+        }
     }
+}
 
-    return &stop_buses_.at(stop);
+}  // namespace
+
+TransportCatalogue::TransportCatalogue()
+: storage_(std::make_shared<OwnedArrays>())
+, arrays_(std::static_pointer_cast<const OwnedArrays>(storage_)->GetArrays()) {
 }
 
-int TransportCatalogue::DistanceBetweenStops(const std::pair<Stop*, Stop*>& stops) const {
-    if (distance_between_stops_.find(stops) == distance_between_stops_.end()) {
-        return 0;
+TransportCatalogue::TransportCatalogue(const SourceStopRequests& request_stops, const SourceBusRequests& request_buses) {
+    auto owned = std::make_shared<OwnedArrays>();
+    FillStops(*owned, request_stops);
+    FillBuses(*owned, request_buses);
+    FillStopBuses(*owned);
+    FillDistances(*owned, request_stops);
+    arrays_ = owned->GetArrays();
+    storage_ = std::move(owned);
+}
+
+TransportCatalogue::TransportCatalogue(Description description) {
+    auto owned = std::make_shared<OwnedArrays>();
+    if (description.stop_names.size() != description.stop_coordinates.size()
+        || description.bus_names.size() != description.bus_is_roundtrip.size()) {
+        throw std::invalid_argument("Inconsistent catalogue description");
+    }
+    for (const auto name : description.stop_names) {
+        AddString(owned->stop_name_chars, owned->stop_name_offsets, name);
+    }
+    owned->stop_name_order = SortByName(owned->stop_name_chars, owned->stop_name_offsets);
+    owned->stop_coordinates = std::move(description.stop_coordinates);
+    for (const auto name : description.bus_names) {
+        AddString(owned->bus_name_chars, owned->bus_name_offsets, name);
     }
+    owned->bus_name_order = SortByName(owned->bus_name_chars, owned->bus_name_offsets);
+    owned->bus_is_roundtrip = std::move(description.bus_is_roundtrip);
+
+    // автобусы остановок строятся по bus_stops, поэтому он проверяется до этого
+    CheckOffsets(description.bus_stop_offsets, owned->bus_is_roundtrip.size(), description.bus_stops.size());
+    CheckIds(description.bus_stops, owned->stop_coordinates.size());
+    owned->bus_stop_offsets = std::move(description.bus_stop_offsets);
+    owned->bus_stops = std::move(description.bus_stops);
+    FillStopBuses(*owned);
+    FillDistances(*owned, description.distances, description.has_explicit_distances);
+
+    arrays_ = owned->GetArrays();
+    storage_ = std::move(owned);
+    CheckArrays();
+}
 
-    return distance_between_stops_.at(stops);
+TransportCatalogue::TransportCatalogue(const Arrays& arrays, std::shared_ptr<const void> storage)
+: storage_(std::move(storage))
+, arrays_(arrays) {
+    CheckArrays();
+}
+
+std::optional<StopId> TransportCatalogue::FindStopId(std::string_view name) const {
+    return FindByName(arrays_.stop_name_chars, arrays_.stop_name_offsets, arrays_.stop_name_order, name);
+}
+
+std::optional<BusId> TransportCatalogue::FindBusId(std::string_view name) const {
+    return FindByName(arrays_.bus_name_chars, arrays_.bus_name_offsets, arrays_.bus_name_order, name);
 }
 
 size_t TransportCatalogue::GetCountStops() const {
-    return stops_.size();
+    return arrays_.stop_coordinates.size();
 }
 size_t TransportCatalogue::GetCountBuses() const {
-    return buses_.size();
+    return arrays_.bus_is_roundtrip.size();
+}
+
+std::string_view TransportCatalogue::GetStopName(StopId stop) const {
+    return GetString(arrays_.stop_name_chars, arrays_.stop_name_offsets, stop);
 }
-const Stops& TransportCatalogue::GetStops() const {
-    return stops_;
+geo::Coordinates TransportCatalogue::GetStopCoordinates(StopId stop) const {
+    return arrays_.stop_coordinates.at(stop);
 }
-const Buses& TransportCatalogue::GetBuses() const {
-    return buses_;
+TransportCatalogue::BusIdsRange TransportCatalogue::GetStopBuses(StopId stop) const {
+    return {arrays_.stop_buses.data() + arrays_.stop_bus_offsets.at(stop),
+            arrays_.stop_buses.data() + arrays_.stop_bus_offsets.at(stop + 1)};
+}
+
+std::string_view TransportCatalogue::GetBusName(BusId bus) const {
+    return GetString(arrays_.bus_name_chars, arrays_.bus_name_offsets, bus);
+}
+bool TransportCatalogue::IsRoundtrip(BusId bus) const {
+    return arrays_.bus_is_roundtrip.at(bus) != 0;
+}
+TransportCatalogue::StopIdsRange TransportCatalogue::GetBusStops(BusId bus) const {
+    return {arrays_.bus_stops.data() + arrays_.bus_stop_offsets.at(bus),
+            arrays_.bus_stops.data() + arrays_.bus_stop_offsets.at(bus + 1)};
+}
+
+int TransportCatalogue::GetDistance(StopId from, StopId to) const {
+    const StopId* begin = arrays_.distance_targets.data() + arrays_.distance_offsets.at(from);
+    const StopId* end = arrays_.distance_targets.data() + arrays_.distance_offsets.at(from + 1);
+    const StopId* it = std::lower_bound(begin, end, to);
+    if (it == end || *it != to) {
+        return 0;
+    }
+    return arrays_.distance_values[it - arrays_.distance_targets.data()];
+}
+
+TransportCatalogue::StopIdsRange TransportCatalogue::GetDistanceTargets(StopId from) const {
+    return {arrays_.distance_targets.data() + arrays_.distance_offsets.at(from),
+            arrays_.distance_targets.data() + arrays_.distance_offsets.at(from + 1)};
+}
+
+TransportCatalogue::DistancesRange TransportCatalogue::GetDistanceValues(StopId from) const {
+    return {arrays_.distance_values.data() + arrays_.distance_offsets.at(from),
+            arrays_.distance_values.data() + arrays_.distance_offsets.at(from + 1)};
+}
+
+bool TransportCatalogue::HasExplicitDistances() const {
+    return !arrays_.distance_is_derived.empty() || arrays_.distance_targets.empty();
+}
+
+bool TransportCatalogue::IsExplicitDistance(StopId from, size_t index) const {
+    const size_t entry = arrays_.distance_offsets.at(from) + index;
+    if (entry >= arrays_.distance_offsets.at(from + 1)) {
+        throw std::out_of_range("Distance index is out of range");
+    }
+    if (!arrays_.distance_is_derived.empty()) {
+        return arrays_.distance_is_derived[entry] == 0;
+    }
+    const StopId to = arrays_.distance_targets[entry];
+    return to >= from || GetDistance(to, from) != arrays_.distance_values[entry];
+}
+
+const TransportCatalogue::Arrays& TransportCatalogue::GetArrays() const {
+    return arrays_;
+}
+
+// ---------------Delta---------------
+
+void TransportCatalogue::Delta::Merge(Delta later) {
+    // более позднее изменение названия вытесняет все прежние изменения того же названия
+    auto replace = [](auto& changed, std::vector<std::string>& removed, auto& later_changed,
+                      std::vector<std::string>& later_removed, auto get_name) {
+        std::unordered_set<std::string> later_names(later_removed.begin(), later_removed.end());
+        for (const auto& item : later_changed) {
+            later_names.insert(get_name(item));
+        }
+        changed.erase(std::remove_if(changed.begin(), changed.end(), [&](const auto& item) {
+            return later_names.count(get_name(item)) != 0;
+        }), changed.end());
+        removed.erase(std::remove_if(removed.begin(), removed.end(), [&](const std::string& name) {
+            return later_names.count(name) != 0;
+        }), removed.end());
+        std::move(later_changed.begin(), later_changed.end(), std::back_inserter(changed));
+        std::move(later_removed.begin(), later_removed.end(), std::back_inserter(removed));
+    };
+    replace(stops, removed_stops, later.stops, later.removed_stops, [](const auto& stop) -> const std::string& {
+        return stop.first.stop_name;
+    });
+    replace(buses, removed_buses, later.buses, later.removed_buses, [](const auto& bus) -> const std::string& {
+        return bus.first.at(0);
+    });
+}
+
+TransportCatalogue TransportCatalogue::ApplyDelta(const Delta& delta) const {
+    std::unordered_map<std::string_view, const SourceStopRequests::value_type*> changed_stops;
+    for (const auto& stop : delta.stops) {
+        changed_stops[stop.first.stop_name] = &stop;
+    }
+    std::unordered_map<std::string_view, const SourceBusRequests::value_type*> changed_buses;
+    for (const auto& bus : delta.buses) {
+        changed_buses[bus.first.at(0)] = &bus;
+    }
+    const std::unordered_set<std::string_view> removed_stops(delta.removed_stops.begin(), delta.removed_stops.end());
+    const std::unordered_set<std::string_view> removed_buses(delta.removed_buses.begin(), delta.removed_buses.end());
+    for (const auto& name : delta.removed_stops) {
+        if (changed_stops.count(name) != 0) {
+            throw std::invalid_argument("Stop is both changed and removed: " + name);
+        }
+    }
+    for (const auto& name : delta.removed_buses) {
+        if (changed_buses.count(name) != 0) {
+            throw std::invalid_argument("Bus is both changed and removed: " + name);
+        }
+    }
+
+    // остановки: прежние без удалённых (заменённые - на своих местах), затем новые
+    Description description;
+    std::vector<std::optional<StopId>> stop_ids(GetCountStops());
+    std::unordered_map<std::string_view, StopId> new_stop_ids;
+    auto add_stop = [&](std::string_view name, geo::Coordinates coordinates) {
+        const auto stop = static_cast<StopId>(description.stop_names.size());
+        description.stop_names.push_back(name);
+        description.stop_coordinates.push_back(coordinates);
+        new_stop_ids[name] = stop;
+        return stop;
+    };
+    for (StopId stop = 0; stop < GetCountStops(); ++stop) {
+        const std::string_view name = GetStopName(stop);
+        if (removed_stops.count(name) != 0) {
+            continue;
+        }
+        const auto it = changed_stops.find(name);
+        stop_ids[stop] = add_stop(name, it == changed_stops.end() ? GetStopCoordinates(stop) : it->second->first.stop_coordinates);
+    }
+    // название, изменённое в delta несколько раз, берётся из последнего изменения
+    for (const auto& stop : delta.stops) {
+        const std::string_view name = stop.first.stop_name;
+        if (!FindStopId(name) && new_stop_ids.count(name) == 0) {
+            add_stop(name, changed_stops.at(name)->first.stop_coordinates);
+        }
+    }
+    auto find_stop = [&new_stop_ids](const std::string& name) {
+        const auto it = new_stop_ids.find(name);
+        if (it == new_stop_ids.end()) {
+            throw std::invalid_argument("Unknown stop: " + name);
+        }
+        return it->second;
+    };
+
+    // явно заданные расстояния от остающихся остановок сохраняются, от заменённых - только новые;
+    // взятые из обратных выводятся заново, так что расстояние из прежнего списка заменённой остановки не остаётся.
+    // Без признака явных расстояний выводившимся считается расстояние до заменённой остановки, равное прежнему
+    // обратному, если новый список задаёт обратное заново; иначе оно сохраняется
+    const bool has_explicit_distances = HasExplicitDistances();
+    description.has_explicit_distances = has_explicit_distances;
+    for (StopId from = 0; from < GetCountStops(); ++from) {
+        if (!stop_ids[from] || changed_stops.count(GetStopName(from)) != 0) {
+            continue;
+        }
+        const auto targets = GetDistanceTargets(from);
+        const auto* distance = GetDistanceValues(from).begin();
+        for (auto it = targets.begin(); it != targets.end(); ++it, ++distance) {
+            if (!stop_ids[*it]) {
+                continue;
+            }
+            if (has_explicit_distances) {
+                if (!IsExplicitDistance(from, it - targets.begin())) {
+                    continue;
+                }
+            } else if (const auto changed = changed_stops.find(GetStopName(*it)); changed != changed_stops.end()
+                       && GetDistance(*it, from) == *distance
+                       && changed->second->second.count(std::string(GetStopName(from))) != 0) {
+                continue;
+            }
+            description.distances.push_back({*stop_ids[from], *stop_ids[*it], *distance});
+        }
+    }
+    for (const auto& [name, stop] : changed_stops) {
+        const StopId from = new_stop_ids.at(name);
+        for (const auto& [to, distance] : stop->second) {
+            description.distances.push_back({from, find_stop(to), distance});
+        }
+    }
+
+    // автобусы: прежние без удалённых (заменённые - на своих местах), затем новые
+    auto add_bus = [&](std::string_view name, bool is_roundtrip) {
+        description.bus_names.push_back(name);
+        description.bus_is_roundtrip.push_back(is_roundtrip ? 1 : 0);
+    };
+    auto add_changed_bus = [&](const SourceBusRequests::value_type& bus) {
+        add_bus(bus.first.at(0), bus.second);
+        for (size_t i = 1; i < bus.first.size(); ++i) {
+            description.bus_stops.push_back(find_stop(bus.first[i]));
+        }
+        description.bus_stop_offsets.push_back(static_cast<std::uint32_t>(description.bus_stops.size()));
+    };
+    for (BusId bus = 0; bus < GetCountBuses(); ++bus) {
+        const std::string_view name = GetBusName(bus);
+        if (removed_buses.count(name) != 0) {
+            continue;
+        }
+        if (const auto it = changed_buses.find(name); it != changed_buses.end()) {
+            add_changed_bus(*it->second);
+            continue;
+        }
+        add_bus(name, IsRoundtrip(bus));
+        for (const StopId stop : GetBusStops(bus)) {
+            if (!stop_ids[stop]) {
+                throw std::invalid_argument("Bus " + std::string(name) + " goes through removed stop "
+                                            + std::string(GetStopName(stop)));
+            }
+            description.bus_stops.push_back(*stop_ids[stop]);
+        }
+        description.bus_stop_offsets.push_back(static_cast<std::uint32_t>(description.bus_stops.size()));
+    }
+    std::unordered_set<std::string_view> new_buses;
+    for (const auto& bus : delta.buses) {
+        const std::string_view name = bus.first.at(0);
+        if (!FindBusId(name) && new_buses.insert(name).second) {
+            add_changed_bus(*changed_buses.at(name));
+        }
+    }
+
+    return TransportCatalogue(std::move(description));
+}
+
+TransportCatalogue::Arrays TransportCatalogue::OwnedArrays::GetArrays() const {
+    return {stop_name_chars, stop_name_offsets, stop_name_order, stop_coordinates,
+            bus_name_chars, bus_name_offsets, bus_name_order, bus_is_roundtrip,
+            bus_stop_offsets, bus_stops, stop_bus_offsets, stop_buses,
+            distance_offsets, distance_targets, distance_values, distance_is_derived};
+}
+
+// ---------------Filling---------------
+
+void TransportCatalogue::FillStops(OwnedArrays& owned, const SourceStopRequests& request_stops) {
+    owned.stop_name_offsets.reserve(request_stops.size() + 1);
+    owned.stop_coordinates.reserve(request_stops.size());
+    for (const auto& [stop, distances] : request_stops) {
+        AddString(owned.stop_name_chars, owned.stop_name_offsets, stop.stop_name);
+        owned.stop_coordinates.push_back(stop.stop_coordinates);
+    }
+    owned.stop_name_order = SortByName(owned.stop_name_chars, owned.stop_name_offsets);
+
+    // массивы остановок больше не растут: поиск остановок по названию при заполнении идёт по ним
+    arrays_ = owned.GetArrays();
+}
+
+void TransportCatalogue::FillBuses(OwnedArrays& owned, const SourceBusRequests& request_buses) {
+    owned.bus_name_offsets.reserve(request_buses.size() + 1);
+    owned.bus_is_roundtrip.reserve(request_buses.size());
+    owned.bus_stop_offsets.reserve(request_buses.size() + 1);
+    for (const auto& [bus, is_roundtrip] : request_buses) {
+        // первый элемент - название автобуса, дальше - названия остановок
+        AddString(owned.bus_name_chars, owned.bus_name_offsets, bus.at(0));
+        owned.bus_is_roundtrip.push_back(is_roundtrip ? 1 : 0);
+        for (size_t i = 1; i < bus.size(); ++i) {
+            const auto stop = FindStopId(bus[i]);
+            if (!stop) {
+                throw std::out_of_range("Unknown stop of bus " + bus[0] + ": " + bus[i]);
+            }
+            owned.bus_stops.push_back(*stop);
+        }
+        owned.bus_stop_offsets.push_back(static_cast<std::uint32_t>(owned.bus_stops.size()));
+    }
+    owned.bus_name_order = SortByName(owned.bus_name_chars, owned.bus_name_offsets);
+}
+
+void TransportCatalogue::FillStopBuses(OwnedArrays& owned) {
+    const size_t stop_count = owned.stop_coordinates.size();
+    const size_t bus_count = owned.bus_is_roundtrip.size();
+    // ранг автобуса в порядке названий: сортировка пар по нему упорядочивает автобусы остановки по названию
+    std::vector<std::uint32_t> bus_rank(bus_count);
+    for (std::uint32_t rank = 0; rank < bus_count; ++rank) {
+        bus_rank[owned.bus_name_order[rank]] = rank;
+    }
+
+    std::vector<std::pair<StopId, std::uint32_t>> stop_buses;
+    stop_buses.reserve(owned.bus_stops.size());
+    for (BusId bus = 0; bus < bus_count; ++bus) {
+        for (std::uint32_t i = owned.bus_stop_offsets[bus]; i < owned.bus_stop_offsets[bus + 1]; ++i) {
+            stop_buses.emplace_back(owned.bus_stops[i], bus_rank[bus]);
+        }
+    }
+    std::sort(stop_buses.begin(), stop_buses.end());
+    stop_buses.erase(std::unique(stop_buses.begin(), stop_buses.end()), stop_buses.end());
+
+    owned.stop_bus_offsets.assign(stop_count + 1, 0);
+    owned.stop_buses.reserve(stop_buses.size());
+    for (const auto& [stop, rank] : stop_buses) {
+        ++owned.stop_bus_offsets[stop + 1];
+        owned.stop_buses.push_back(owned.bus_name_order[rank]);
+    }
+    for (size_t stop = 0; stop < stop_count; ++stop) {
+        owned.stop_bus_offsets[stop + 1] += owned.stop_bus_offsets[stop];
+    }
+}
+
+void TransportCatalogue::FillDistances(OwnedArrays& owned, const SourceStopRequests& request_stops) {
+    std::vector<RoadDistance> road_distances;
+    for (StopId from = 0; from < request_stops.size(); ++from) {
+        for (const auto& [stop_to, distance] : request_stops[from].second) {
+            const auto to = FindStopId(stop_to);
+            if (!to) {
+                throw std::out_of_range("Unknown stop in road distances of " + std::string(GetStopName(from)) + ": " + stop_to);
+            }
+            road_distances.push_back({from, *to, distance});
+        }
+    }
+    FillDistances(owned, road_distances);
+}
+
+void TransportCatalogue::FillDistances(OwnedArrays& owned, const std::vector<RoadDistance>& road_distances,
+                                       bool has_explicit_distances) {
+    const size_t stop_count = owned.stop_coordinates.size();
+    // {откуда, куда, задано ли только обратное расстояние, расстояние}: после сортировки
+    // явно заданное расстояние идёт раньше обратного и вытесняет его
+    std::vector<std::tuple<StopId, StopId, bool, int>> distances;
+    distances.reserve(road_distances.size() * 2);
+    for (const auto& [from, to, distance] : road_distances) {
+        if (from >= stop_count || to >= stop_count) {
+            throw std::invalid_argument("Catalogue id is out of range");
+        }
+        distances.emplace_back(from, to, false, distance);
+        distances.emplace_back(to, from, true, distance);
+    }
+    std::sort(distances.begin(), distances.end());
+    distances.erase(std::unique(distances.begin(), distances.end(), [](const auto& lhs, const auto& rhs) {
+        return std::get<0>(lhs) == std::get<0>(rhs) && std::get<1>(lhs) == std::get<1>(rhs);
+    }), distances.end());
+
+    owned.distance_offsets.assign(stop_count + 1, 0);
+    owned.distance_targets.reserve(distances.size());
+    owned.distance_values.reserve(distances.size());
+    owned.distance_is_derived.reserve(has_explicit_distances ? distances.size() : 0);
+    for (const auto& [from, to, is_reverse, distance] : distances) {
+        ++owned.distance_offsets[from + 1];
+        owned.distance_targets.push_back(to);
+        owned.distance_values.push_back(distance);
+        if (has_explicit_distances) {
+            owned.distance_is_derived.push_back(is_reverse ? 1 : 0);
+        }
+    }
+    for (size_t stop = 0; stop < stop_count; ++stop) {
+        owned.distance_offsets[stop + 1] += owned.distance_offsets[stop];
+    }
+}
+
+void TransportCatalogue::CheckArrays() const {
+    const size_t stop_count = arrays_.stop_coordinates.size();
+    const size_t bus_count = arrays_.bus_is_roundtrip.size();
+    CheckOffsets(arrays_.stop_name_offsets, stop_count, arrays_.stop_name_chars.size());
+    CheckOffsets(arrays_.bus_name_offsets, bus_count, arrays_.bus_name_chars.size());
+    CheckOffsets(arrays_.bus_stop_offsets, bus_count, arrays_.bus_stops.size());
+    CheckOffsets(arrays_.stop_bus_offsets, stop_count, arrays_.stop_buses.size());
+    CheckOffsets(arrays_.distance_offsets, stop_count, arrays_.distance_targets.size());
+    if (arrays_.stop_name_order.size() != stop_count || arrays_.bus_name_order.size() != bus_count
+        || arrays_.distance_values.size() != arrays_.distance_targets.size()
+        || (!arrays_.distance_is_derived.empty() && arrays_.distance_is_derived.size() != arrays_.distance_targets.size())) {
+        throw std::invalid_argument("Inconsistent catalogue arrays");
+    }
+    CheckIds(arrays_.stop_name_order, stop_count);
+    CheckIds(arrays_.bus_name_order, bus_count);
+    CheckIds(arrays_.bus_stops, stop_count);
+    CheckIds(arrays_.stop_buses, bus_count);
+    CheckIds(arrays_.distance_targets, stop_count);
 }
 
 }  // namespace transport
\ No newline at end of file
@@ -1,48 +1,186 @@
 #pragma once
 
-#include <deque>
+#include <cstdint>
+#include <memory>
+#include <optional>
 #include <string>
 #include <string_view>
-#include <unordered_map>
 #include <vector>
-#include <set>
-#include <functional>
 
 #include "domain.h"
+#include "geo.h"
+#include "ranges.h"
 
 namespace transport {
 
 using namespace domain;
 
+using StopId = std::uint32_t;
+using BusId = std::uint32_t;
 
+/*
+ * Транспортный справочник. Остановкам и автобусам при создании присваиваются плотные номера
+ * в порядке их описания во входных данных; все данные хранятся массивами, индексируемыми номером.
+ * Названия лежат таблицами строк, поиск по названию - двоичный поиск по номерам, упорядоченным
+ * по названию; дальше работа идёт с номерами. Массивы либо свои, либо лежат во внешней памяти
+ * (отображённом файле базы) и читаются на месте
+ */
 class TransportCatalogue {
+private:
+    using StopIdsRange = ranges::Range<const StopId*>;
+    using BusIdsRange = ranges::Range<const BusId*>;
+    using DistancesRange = ranges::Range<const std::int32_t*>;
+
 public:
-    TransportCatalogue(Stops stops,
-                       PeekStops peek_stops,
-                       Buses buses,
-                       PeekBuses peek_buses,
-                       StopBuses stop_buses,
-                       domain::DistanceBetweenStops distance_between_stops);
+    // Массивы справочника. Таблица строк: символы подряд и смещения начала каждой строки
+    // (смещений на одно больше, чем строк). *_name_order - номера в порядке возрастания названий.
+    // CSR-массивы: bus_stops[bus_stop_offsets[bus] .. bus_stop_offsets[bus + 1]) - остановки автобуса bus;
+    // расстояния от остановки упорядочены по номеру остановки назначения. distance_is_derived[i] = 1 - расстояние
+    // не задано явно, а взято из обратного; пустой массив - признак не записан (базы, записанные до его появления)
+    struct Arrays {
+        ranges::Span<char> stop_name_chars;
+        ranges::Span<std::uint32_t> stop_name_offsets;
+        ranges::Span<StopId> stop_name_order;
+        ranges::Span<geo::Coordinates> stop_coordinates;
+
+        ranges::Span<char> bus_name_chars;
+        ranges::Span<std::uint32_t> bus_name_offsets;
+        ranges::Span<BusId> bus_name_order;
+        ranges::Span<std::uint8_t> bus_is_roundtrip;
+
+        ranges::Span<std::uint32_t> bus_stop_offsets;
+        ranges::Span<StopId> bus_stops;
+        ranges::Span<std::uint32_t> stop_bus_offsets;
+        ranges::Span<BusId> stop_buses;
+        ranges::Span<std::uint32_t> distance_offsets;
+        ranges::Span<StopId> distance_targets;
+        ranges::Span<std::int32_t> distance_values;
+        ranges::Span<std::uint8_t> distance_is_derived;
+    };
+
+    // Явно заданное дорожное расстояние
+    struct RoadDistance {
+        StopId from;
+        StopId to;
+        std::int32_t distance;
+    };
+
+    // Исходные данные справочника по номерам: остановки, автобусы с CSR-массивом их остановок и явно
+    // заданные расстояния. Порядок названий, автобусы остановок и обратные расстояния вычисляются.
+    // has_explicit_distances = false - среди distances могут быть и выведенные из обратных (базы,
+    // записанные до признака явных расстояний): тогда признак не заполняется
+    struct Description {
+        std::vector<std::string_view> stop_names;
+        std::vector<geo::Coordinates> stop_coordinates;
+        std::vector<std::string_view> bus_names;
+        std::vector<std::uint8_t> bus_is_roundtrip;
+        std::vector<std::uint32_t> bus_stop_offsets{0};
+        std::vector<StopId> bus_stops;
+        std::vector<RoadDistance> distances;
+        bool has_explicit_distances = true;
+    };
+
+    // Изменение справочника (make_delta): остановки и автобусы, добавленные или заменённые целиком,
+    // и названия удалённых. Остановки автобуса - полной последовательностью, как в SourceBusRequests
+    struct Delta {
+        SourceStopRequests stops;
+        SourceBusRequests buses;
+        std::vector<std::string> removed_stops;
+        std::vector<std::string> removed_buses;
+
+        // Накладывает более позднее изменение: его остановки и автобусы заменяют или удаляют прежние
+        void Merge(Delta later);
+    };
+
+    TransportCatalogue();
+    // Названия остановок в request_buses должны быть описаны в request_stops, иначе std::out_of_range
+    TransportCatalogue(const SourceStopRequests& request_stops, const SourceBusRequests& request_buses);
+    // Несогласованные массивы или номера - std::invalid_argument
+    explicit TransportCatalogue(Description description);
+    // Справочник над готовыми массивами во внешней памяти, которую держит storage.
+    // Несогласованные массивы - std::invalid_argument
+    TransportCatalogue(const Arrays& arrays, std::shared_ptr<const void> storage);
 
+    // Массивы не перемещаются вместе с объектом, поэтому перемещение их не инвалидирует
+    TransportCatalogue(TransportCatalogue&&) = default;
+    TransportCatalogue& operator=(TransportCatalogue&&) = default;
+    TransportCatalogue(const TransportCatalogue&) = delete;
+    TransportCatalogue& operator=(const TransportCatalogue&) = delete;
 
-    const Bus* FindBusByName(std::string_view name) const;
-    const Stop* FindStopByName(std::string_view name) const;
-    const std::set<std::string_view>* FindBusesForStop(std::string_view stop) const;
-    int DistanceBetweenStops(const std::pair<Stop*, Stop*>& stops) const;
+    std::optional<StopId> FindStopId(std::string_view name) const;
+    std::optional<BusId> FindBusId(std::string_view name) const;
 
     size_t GetCountStops() const;
     size_t GetCountBuses() const;
-    const Stops& GetStops() const;
-    const Buses& GetBuses() const;
 
+    std::string_view GetStopName(StopId stop) const;
+    geo::Coordinates GetStopCoordinates(StopId stop) const;
+    // Автобусы, проходящие через остановку, упорядоченные по названию
+    BusIdsRange GetStopBuses(StopId stop) const;
+
+    std::string_view GetBusName(BusId bus) const;
+    bool IsRoundtrip(BusId bus) const;
+    // Полная последовательность остановок; у некольцевого маршрута - туда и обратно
+    StopIdsRange GetBusStops(BusId bus) const;
+
+    // Дорожное расстояние; если задано только обратное - берётся оно, если не задано никакое - 0
+    int GetDistance(StopId from, StopId to) const;
+    // Список расстояний от остановки: остановки назначения по возрастанию номера и расстояния до них
+    // в том же порядке, включая взятые из обратного направления. Остальным остановкам расстояние - 0
+    StopIdsRange GetDistanceTargets(StopId from) const;
+    DistancesRange GetDistanceValues(StopId from) const;
+    // Известно ли, какие расстояния заданы явно; нет - у справочника из базы, записанной до появления признака
+    bool HasExplicitDistances() const;
+    // Задано ли расстояние от остановки до GetDistanceTargets(from)[index] явно, а не взято из обратного.
+    // Без признака явным считается расстояние, не равное обратному, а из пары равных - расстояние
+    // от остановки с меньшим номером
+    bool IsExplicitDistance(StopId from, size_t index) const;
+
+    const Arrays& GetArrays() const;
+
+    // Справочник с наложенным изменением. Остающиеся остановки и автобусы сохраняют порядок номеров,
+    // новые идут за ними. Расстояния - как при построении из запросов: явно заданные расстояния остающихся
+    // остановок и новые списки заменённых, обратные выводятся из них заново. Без признака явных расстояний
+    // расстояние до заменённой остановки, равное прежнему обратному, сохраняется, если новый список его не задаёт.
+    // Удаление отсутствующего названия
+    // ничего не меняет. Автобус через удалённую остановку, неизвестная остановка или название и среди
+    // заменённых, и среди удалённых - std::invalid_argument
+    TransportCatalogue ApplyDelta(const Delta& delta) const;
 
 private:
-    Stops stops_;
-    PeekStops peek_stops_;
-    Buses buses_;
-    PeekBuses peek_buses_;
-    StopBuses stop_buses_;
-    domain::DistanceBetweenStops distance_between_stops_;
+    // собственные массивы справочника, построенного из запросов
+    struct OwnedArrays {
+        std::vector<char> stop_name_chars;
+        std::vector<std::uint32_t> stop_name_offsets{0};
+        std::vector<StopId> stop_name_order;
+        std::vector<geo::Coordinates> stop_coordinates;
+
+        std::vector<char> bus_name_chars;
+        std::vector<std::uint32_t> bus_name_offsets{0};
+        std::vector<BusId> bus_name_order;
+        std::vector<std::uint8_t> bus_is_roundtrip;
+
+        std::vector<std::uint32_t> bus_stop_offsets{0};
+        std::vector<StopId> bus_stops;
+        std::vector<std::uint32_t> stop_bus_offsets{0};
+        std::vector<BusId> stop_buses;
+        std::vector<std::uint32_t> distance_offsets{0};
+        std::vector<StopId> distance_targets;
+        std::vector<std::int32_t> distance_values;
+        std::vector<std::uint8_t> distance_is_derived;
+
+        Arrays GetArrays() const;
+    };
+
+    std::shared_ptr<const void> storage_; // память, на которую указывают arrays_
+    Arrays arrays_;
+
+    void FillStops(OwnedArrays& owned, const SourceStopRequests& request_stops);
+    void FillBuses(OwnedArrays& owned, const SourceBusRequests& request_buses);
+    void FillStopBuses(OwnedArrays& owned);
+    void FillDistances(OwnedArrays& owned, const SourceStopRequests& request_stops);
+    void FillDistances(OwnedArrays& owned, const std::vector<RoadDistance>& road_distances, bool has_explicit_distances = true);
+    void CheckArrays() const;
 };
 
 }  // namespace transport
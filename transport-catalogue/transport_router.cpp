@@ -2,167 +2,396 @@
 
 namespace router {
 
+RouterType ParseRouterType(std::string_view name) {
+    if (name == "all_pairs"sv) {
+        return RouterType::ALL_PAIRS;
+    } else if (name == "dijkstra"sv) {
+        return RouterType::DIJKSTRA;
+    } else if (name == "contraction_hierarchy"sv) {
+        return RouterType::CONTRACTION_HIERARCHY;
+    } else if (name == "alt"sv) {
+        return RouterType::ALT;
+    } else if (name == "raptor"sv) {
+        return RouterType::RAPTOR;
+    }
+    throw std::invalid_argument("Unknown router type: "s + std::string(name));
+}
+
+GraphModel ParseGraphModel(std::string_view name) {
+    if (name == "stop_pairs"sv) {
+        return GraphModel::STOP_PAIRS;
+    } else if (name == "route_stops"sv) {
+        return GraphModel::ROUTE_STOPS;
+    }
+    throw std::invalid_argument("Unknown graph model: "s + std::string(name));
+}
+
+RoutingSettings::RoutingSettings(const Dict& routing_settings)
+: bus_wait_time(routing_settings.at("bus_wait_time").AsInt())
+, bus_velocity(routing_settings.at("bus_velocity").AsDouble()) {
+    if (const auto it = routing_settings.find("router"); it != routing_settings.end()) {
+        router_type = ParseRouterType(it->second.AsString());
+    }
+    if (const auto it = routing_settings.find("router_cache_size"); it != routing_settings.end()) {
+        router_cache_size = it->second.AsInt();
+    }
+    if (const auto it = routing_settings.find("graph_model"); it != routing_settings.end()) {
+        graph_model = ParseGraphModel(it->second.AsString());
+    }
+    if (const auto it = routing_settings.find("landmark_count"); it != routing_settings.end()) {
+        landmark_count = it->second.AsInt();
+    }
+}
+
+TransportRouter::TransportRouter()
+: routing_settings_(0, 0.0)
+, graph_(std::make_unique<Graph>()) {
+    graph_->Freeze();
+}
+
 TransportRouter::TransportRouter(const Dict& routing_settings, const TransportCatalogue& transport_catalogue)
 : routing_settings_(RoutingSettings(routing_settings))
-, graph_(transport_catalogue.GetCountStops() * 2)
-, router_(graph_) {
+, graph_(std::make_unique<Graph>(CountVertices(transport_catalogue))) {
     routing_settings_.bus_velocity *= SCALE_VELOCITY_FACTOR;
+    if (routing_settings_.router_type == RouterType::RAPTOR) {
+        // RAPTOR работает по маршрутам справочника, в базе остаются только настройки
+        stop_count_ = transport_catalogue.GetCountStops();
+        graph_->Freeze();
+        return;
+    }
     FillGraph(transport_catalogue);
+    if (routing_settings_.router_type == RouterType::ALL_PAIRS) {
+        router_.emplace(*graph_);
+    } else if (routing_settings_.router_type == RouterType::CONTRACTION_HIERARCHY) {
+        hierarchy_.emplace(*graph_);
+    } else if (routing_settings_.router_type == RouterType::ALT) {
+        landmarks_.emplace(*graph_, routing_settings_.landmark_count);
+    }
 }
 
 TransportRouter::TransportRouter(RoutingSettings routing_settings,
                 DirectedWeightedGraph<double> graph,
-                std::vector<std::string> stop_names,
-                Router<double>::RoutesInternalData internal_data)
+                size_t stop_count,
+                std::optional<TableRouter::Table> routes_table,
+                std::optional<ContractionHierarchy<double>> hierarchy,
+                std::optional<Landmarks<double>> landmarks)
 : routing_settings_(std::move(routing_settings))
-, graph_(std::move(graph))
-, stop_names_(std::move(stop_names))
-, router_(graph_, std::move(internal_data)) {
+, graph_(std::make_unique<Graph>(std::move(graph)))
+, hierarchy_(std::move(hierarchy))
+, landmarks_(std::move(landmarks))
+, stop_count_(stop_count) {
+    if (routes_table) {
+        router_.emplace(*graph_, std::move(*routes_table));
+    }
+    if (routing_settings_.router_type == RouterType::CONTRACTION_HIERARCHY && !hierarchy_) {
+        hierarchy_.emplace(*graph_); // в базе нет иерархии - строим заново
+    }
+    if (routing_settings_.router_type == RouterType::ALT && !landmarks_) {
+        landmarks_.emplace(*graph_, routing_settings_.landmark_count);
+    }
 }
 
-const TransportRouter::Graph& TransportRouter::GetGraph() const {
-    return graph_;
+TransportRouter::TransportRouter(const TransportRouter& base, const TransportCatalogue& base_catalogue,
+                                 const TransportCatalogue& transport_catalogue)
+: routing_settings_(base.routing_settings_)
+, graph_(std::make_unique<Graph>(CountVertices(transport_catalogue))) {
+    if (routing_settings_.router_type == RouterType::RAPTOR) {
+        stop_count_ = transport_catalogue.GetCountStops();
+        graph_->Freeze();
+        return;
+    }
+    FillGraph(transport_catalogue);
+    if (routing_settings_.router_type == RouterType::ALL_PAIRS) {
+        if (base.router_) {
+            router_.emplace(*graph_, base.GetGraph(), base.router_->GetRoutesTable(),
+                            MapVertices(base_catalogue, transport_catalogue));
+        } else {
+            router_.emplace(*graph_);
+        }
+    } else if (routing_settings_.router_type == RouterType::CONTRACTION_HIERARCHY) {
+        // сокращения зависят от порядка вершин по всему графу: иерархия строится заново
+        hierarchy_.emplace(*graph_);
+    } else if (routing_settings_.router_type == RouterType::ALT) {
+        if (base.landmarks_) {
+            landmarks_.emplace(*graph_, base.GetGraph(), *base.landmarks_,
+                               MapVertices(base_catalogue, transport_catalogue), routing_settings_.landmark_count);
+        } else {
+            landmarks_.emplace(*graph_, routing_settings_.landmark_count);
+        }
+    }
 }
 
-VertexId TransportRouter::GetVertexIdInput(std::string_view stop_name) const {
-    return 2 * (std::find(stop_names_.begin(), stop_names_.end(), stop_name) - stop_names_.begin());
+const TransportRouter::Graph& TransportRouter::GetGraph() const {
+    return *graph_;
 }
 
-std::optional<json::Node> TransportRouter::GetRouteAsNode(const Router<double>& router, std::string_view from, std::string_view to) const {
-    VertexId vertex_from = GetVertexIdInput(from);
-    VertexId vertex_to = GetVertexIdInput(to);
+VertexId TransportRouter::GetVertexIdInput(StopId stop) const {
+    return routing_settings_.graph_model == GraphModel::ROUTE_STOPS ? stop : 2 * static_cast<VertexId>(stop);
+}
 
-    std::optional<Router<double>::RouteInfo> candidate_route = router.BuildRoute(vertex_from, vertex_to);
-    if (!candidate_route.has_value()) {
-        return std::nullopt;
+std::unique_ptr<RouteBuilder<double>> TransportRouter::MakeRouter() const {
+    switch (routing_settings_.router_type) {
+        case RouterType::DIJKSTRA:
+            return std::make_unique<DijkstraRouter<double>>(*graph_, routing_settings_.router_cache_size);
+        case RouterType::CONTRACTION_HIERARCHY:
+            return std::make_unique<ContractionHierarchyRouter<double>>(*hierarchy_);
+        case RouterType::ALT:
+            return std::make_unique<LandmarkRouter<double>>(*graph_, *landmarks_);
+        case RouterType::RAPTOR:
+            return nullptr;
+        case RouterType::ALL_PAIRS:
+            break;
     }
+    return std::make_unique<TableRouter>(*graph_);
+}
 
-    auto answer = json::Builder{};
-    auto route = answer.StartArray();
-    for (const auto& edge_id : candidate_route->edges) {
-        auto item = route.StartDict();
-        const auto& edge = GetGraph().GetEdge(edge_id);
-        if (edge.span_count == 0) { // wait
-            item.Key("type").Value(static_cast<std::string>("Wait"));
-            item.Key("stop_name").Value(static_cast<std::string>(edge.name));
-        } else {
-            item.Key("type").Value(static_cast<std::string>("Bus"));
-            item.Key("bus").Value(static_cast<std::string>(edge.name));
-            item.Key("span_count").Value(static_cast<int>(edge.span_count));
+std::optional<RouteBuilder<double>::RouteInfo> TransportRouter::BuildRoute(const RouteBuilder<double>& router,
+                                                                          StopId from, StopId to) const {
+    return router.BuildRoute(GetVertexIdInput(from), GetVertexIdInput(to));
+}
+
+double TransportRouter::WriteRouteItems(const RouteBuilder<double>::RouteInfo& route, json::Writer& items) const {
+    // время складывается по элементам в порядке вывода, как и прежде по узлам ответа
+    double total_time = 0.0;
+    auto add_wait = [&items, &total_time](std::string_view stop_name, double time) {
+        items.StartDict()
+                .Key("stop_name").Value(stop_name)
+                .Key("time").Value(time)
+                .Key("type").Value("Wait")
+                .EndDict();
+        total_time += time;
+    };
+    auto add_bus = [&items, &total_time](std::string_view bus_name, int span_count, double time) {
+        items.StartDict()
+                .Key("bus").Value(bus_name)
+                .Key("span_count").Value(span_count)
+                .Key("time").Value(time)
+                .Key("type").Value("Bus")
+                .EndDict();
+        total_time += time;
+    };
+
+    if (routing_settings_.graph_model == GraphModel::STOP_PAIRS) {
+        for (const auto& edge_id : route.edges) {
+            const auto& edge = GetGraph().GetEdge(edge_id);
+            if (edge.span_count == 0) { // wait
+                add_wait(GetGraph().GetName(edge.name_id), edge.weight);
+            } else {
+                add_bus(GetGraph().GetName(edge.name_id), static_cast<int>(edge.span_count), edge.weight);
+            }
+        }
+    } else {
+        // посадка - ожидание на остановке; поездки подряд до высадки складываются в один Bus
+        int span_count = 0;
+        double bus_time = 0.0;
+        for (const auto& edge_id : route.edges) {
+            const auto& edge = GetGraph().GetEdge(edge_id);
+            if (edge.from < stop_count_) { // посадка
+                add_wait(GetGraph().GetName(edge.name_id), edge.weight);
+            } else if (edge.to >= stop_count_) { // поездка до следующей остановки
+                ++span_count;
+                bus_time += edge.weight;
+            } else { // высадка
+                add_bus(GetGraph().GetName(edge.name_id), span_count, bus_time);
+                span_count = 0;
+                bus_time = 0.0;
+            }
         }
-        item.Key("time").Value(edge.weight);
-        item.EndDict();
     }
-
-    route.EndArray();
-    return answer.Build();
+    return total_time;
 }
 
 const RoutingSettings& TransportRouter::GetRoutingSettings() const {
     return routing_settings_;
 }
 
-const std::vector<std::string>& TransportRouter::GetStopNames() const {
-    return stop_names_;
+size_t TransportRouter::GetStopCount() const {
+    return stop_count_;
 }
 
-const Router<double>& TransportRouter::GetRouter() const {
+const std::optional<TableRouter>& TransportRouter::GetRouter() const {
     return router_;
 }
 
+const std::optional<ContractionHierarchy<double>>& TransportRouter::GetHierarchy() const {
+    return hierarchy_;
+}
+
+const std::optional<Landmarks<double>>& TransportRouter::GetLandmarks() const {
+    return landmarks_;
+}
+
+size_t TransportRouter::CountVertices(const TransportCatalogue& transport_catalogue) const {
+    if (routing_settings_.router_type == RouterType::RAPTOR) {
+        return 0;
+    }
+    if (routing_settings_.graph_model == GraphModel::STOP_PAIRS) {
+        return transport_catalogue.GetCountStops() * 2;
+    }
+    // у некольцевого маршрута остановка разворота принадлежит обоим рейсам
+    size_t vertex_count = transport_catalogue.GetCountStops();
+    for (BusId bus = 0; bus < transport_catalogue.GetCountBuses(); ++bus) {
+        const auto stops = transport_catalogue.GetBusStops(bus);
+        const size_t stop_count = stops.end() - stops.begin();
+        vertex_count += stop_count + (transport_catalogue.IsRoundtrip(bus) || stop_count == 0 ? 0 : 1);
+    }
+    return vertex_count;
+}
+
+std::vector<VertexId> TransportRouter::MapVertices(const TransportCatalogue& base_catalogue,
+                                                   const TransportCatalogue& transport_catalogue) const {
+    std::vector<VertexId> vertex_map(CountVertices(base_catalogue), table_repair::REMOVED_VERTEX);
+    std::vector<std::optional<StopId>> stop_map(base_catalogue.GetCountStops());
+    for (StopId stop = 0; stop < base_catalogue.GetCountStops(); ++stop) {
+        stop_map[stop] = transport_catalogue.FindStopId(base_catalogue.GetStopName(stop));
+    }
+    if (routing_settings_.graph_model == GraphModel::STOP_PAIRS) {
+        for (StopId stop = 0; stop < stop_map.size(); ++stop) {
+            if (stop_map[stop]) {
+                vertex_map[2 * static_cast<VertexId>(stop)] = 2 * static_cast<VertexId>(*stop_map[stop]);
+                vertex_map[2 * static_cast<VertexId>(stop) + 1] = 2 * static_cast<VertexId>(*stop_map[stop]) + 1;
+            }
+        }
+        return vertex_map;
+    }
+
+    for (StopId stop = 0; stop < stop_map.size(); ++stop) {
+        if (stop_map[stop]) {
+            vertex_map[stop] = *stop_map[stop];
+        }
+    }
+    // вершины рейсов идут подряд по автобусам, как их нумерует FillRouteStopEdges
+    auto get_first_vertices = [](const TransportCatalogue& catalogue) {
+        std::vector<VertexId> first_vertices{catalogue.GetCountStops()};
+        for (BusId bus = 0; bus < catalogue.GetCountBuses(); ++bus) {
+            const auto stops = catalogue.GetBusStops(bus);
+            const size_t stop_count = stops.end() - stops.begin();
+            first_vertices.push_back(first_vertices.back() + stop_count
+                                     + (catalogue.IsRoundtrip(bus) || stop_count == 0 ? 0 : 1));
+        }
+        return first_vertices;
+    };
+    const std::vector<VertexId> base_first_vertices = get_first_vertices(base_catalogue);
+    const std::vector<VertexId> first_vertices = get_first_vertices(transport_catalogue);
+    for (BusId base_bus = 0; base_bus < base_catalogue.GetCountBuses(); ++base_bus) {
+        const auto bus = transport_catalogue.FindBusId(base_catalogue.GetBusName(base_bus));
+        if (!bus || transport_catalogue.IsRoundtrip(*bus) != base_catalogue.IsRoundtrip(base_bus)) {
+            continue;
+        }
+        const auto base_stops = base_catalogue.GetBusStops(base_bus);
+        const auto stops = transport_catalogue.GetBusStops(*bus);
+        if (!std::equal(base_stops.begin(), base_stops.end(), stops.begin(), stops.end(), [&stop_map](StopId base_stop, StopId stop) {
+                return stop_map[base_stop] == stop;
+            })) {
+            continue;
+        }
+        for (VertexId offset = 0; offset < base_first_vertices[base_bus + 1] - base_first_vertices[base_bus]; ++offset) {
+            vertex_map[base_first_vertices[base_bus] + offset] = first_vertices[*bus] + offset;
+        }
+    }
+    return vertex_map;
+}
+
 void TransportRouter::FillVertex(const TransportCatalogue& transport_catalogue) {
     const double WEIGHT = routing_settings_.bus_wait_time;
-    size_t from = 0, to = 1;
-    for (const auto& stop: transport_catalogue.GetStops()) {
-        graph_.AddEdge({from, to, WEIGHT, stop.stop_name, 0});
-        stop_names_.push_back(stop.stop_name);
-        from += 2;
-        to += 2;
+    stop_count_ = transport_catalogue.GetCountStops();
+    if (routing_settings_.graph_model != GraphModel::STOP_PAIRS) {
+        return;
+    }
+    for (StopId stop = 0; stop < stop_count_; ++stop) {
+        const VertexId from = 2 * static_cast<VertexId>(stop);
+        graph_->AddEdge({from, from + 1, WEIGHT, graph_->AddName(transport_catalogue.GetStopName(stop)), 0});
     }
 }
 
-void TransportRouter::FillEdges(const TransportCatalogue& transport_catalogue) {
-    for (const auto& bus: transport_catalogue.GetBuses()) {
-        if (bus.is_roundtrip) {
-            const auto& stops = bus.bus_stops;
-            for (size_t from = 0; from + 1 < stops.size(); ++from) {
-                std::string_view stop_from_name = stops[from]->stop_name;
-                VertexId stop_from_vertex =
-                        1 + 2 * (std::find(stop_names_.begin(), stop_names_.end(), stop_from_name) - stop_names_.begin());
-                double weight = 0.0;
-                size_t span_count = 0;
-                for (size_t to = from + 1; to < stops.size(); ++to) {
-                    if (from == 0 && to == stops.size() - 1) continue;
-                    std::string_view stop_to_name = stops[to]->stop_name;
-                    VertexId stop_to_vertex =
-                            2 * (std::find(stop_names_.begin(), stop_names_.end(), stop_to_name) - stop_names_.begin());
-
-                    auto stop_from = transport_catalogue.FindStopByName(stop_from_name);
-                    auto stop_to = transport_catalogue.FindStopByName(stop_to_name);
-                    weight += transport_catalogue.DistanceBetweenStops( {const_cast<Stop*>(stop_from), const_cast<Stop*>(stop_to)} )
-                              / routing_settings_.bus_velocity;
-
-                    stop_from_name = stop_to_name;
-                    ++span_count;
-                    graph_.AddEdge({stop_from_vertex, stop_to_vertex, weight, bus.bus_name, span_count});
-                }
-            }
+void TransportRouter::FillRouteStopEdges(const TransportCatalogue& transport_catalogue) {
+    const double wait_time = routing_settings_.bus_wait_time;
+    VertexId route_stop_vertex = stop_count_;
+    for (BusId bus = 0; bus < transport_catalogue.GetCountBuses(); ++bus) {
+        const NameId bus_name_id = graph_->AddName(transport_catalogue.GetBusName(bus));
+        const auto bus_stops = transport_catalogue.GetBusStops(bus);
+        const std::vector<StopId> stops(bus_stops.begin(), bus_stops.end());
+        if (stops.empty()) {
+            continue;
+        }
+
+        // рейсы автобуса - отрезки [first, last] последовательности остановок;
+        // некольцевой маршрут разворачивается на средней остановке, проехать её без пересадки нельзя
+        std::vector<std::pair<size_t, size_t>> trips;
+        if (transport_catalogue.IsRoundtrip(bus)) {
+            trips.push_back({0, stops.size() - 1});
         } else {
-            const auto& stops = bus.bus_stops;
-            size_t mid = stops.size() / 2;
-
-            // туда
-            for (size_t from = 0; from < mid; ++from) {
-                std::string_view stop_from_name = stops[from]->stop_name;
-                VertexId stop_from_vertex =
-                        1 + 2 * (std::find(stop_names_.begin(), stop_names_.end(), stop_from_name) - stop_names_.begin());
-                double weight = 0.0;
-                size_t span_count = 0;
-                for (size_t to = from + 1; to <= mid; ++to) {
-                    std::string_view stop_to_name = stops[to]->stop_name;
-                    VertexId stop_to_vertex =
-                            2 * (std::find(stop_names_.begin(), stop_names_.end(), stop_to_name) - stop_names_.begin());
-
-                    auto stop_from = transport_catalogue.FindStopByName(stop_from_name);
-                    auto stop_to = transport_catalogue.FindStopByName(stop_to_name);
-                    weight += transport_catalogue.DistanceBetweenStops( {const_cast<Stop*>(stop_from), const_cast<Stop*>(stop_to)} )
-                              / routing_settings_.bus_velocity;
-
-                    stop_from_name = stop_to_name;
-                    ++span_count;
-                    graph_.AddEdge({stop_from_vertex, stop_to_vertex, weight, bus.bus_name, span_count});
-                }
-            }
+            const size_t mid = stops.size() / 2;
+            trips.push_back({0, mid});
+            trips.push_back({mid, stops.size() - 1});
+        }
+
+        for (const auto& [first, last] : trips) {
+            for (size_t position = first; position <= last; ++position) {
+                const StopId stop = stops[position];
+                const VertexId stop_vertex = stop;
+                const VertexId vertex = route_stop_vertex + position - first;
+                const NameId stop_name_id = graph_->AddName(transport_catalogue.GetStopName(stop));
 
-            // обратно
-            for (size_t from = mid; from + 1 < stops.size(); ++from) {
-                std::string_view stop_from_name = stops[from]->stop_name;
-                VertexId stop_from_vertex =
-                        1 + 2 * (std::find(stop_names_.begin(), stop_names_.end(), stop_from_name) - stop_names_.begin());
-                double weight = 0.0;
-                size_t span_count = 0;
-                for (size_t to = from + 1; to < stops.size(); ++to) {
-                    std::string_view stop_to_name = stops[to]->stop_name;
-                    VertexId stop_to_vertex =
-                            2 * (std::find(stop_names_.begin(), stop_names_.end(), stop_to_name) - stop_names_.begin());
-
-                    auto stop_from = transport_catalogue.FindStopByName(stop_from_name);
-                    auto stop_to = transport_catalogue.FindStopByName(stop_to_name);
-                    weight += transport_catalogue.DistanceBetweenStops( {const_cast<Stop*>(stop_from), const_cast<Stop*>(stop_to)} )
-                              / routing_settings_.bus_velocity;
-
-                    stop_from_name = stop_to_name;
-                    ++span_count;
-                    graph_.AddEdge({stop_from_vertex, stop_to_vertex, weight, bus.bus_name, span_count});
+                // с последней остановки рейса не уезжают, на первую не приезжают
+                if (position != last) {
+                    graph_->AddEdge({stop_vertex, vertex, wait_time, stop_name_id, 0});
+                    const double ride_time = transport_catalogue.GetDistance(stop, stops[position + 1])
+                                             / routing_settings_.bus_velocity;
+                    graph_->AddEdge({vertex, vertex + 1, ride_time, bus_name_id, 1});
+                }
+                if (position != first) {
+                    graph_->AddEdge({vertex, stop_vertex, 0.0, bus_name_id, 0});
                 }
             }
+            route_stop_vertex += last - first + 1;
+        }
+    }
+}
+
+void TransportRouter::FillTripEdges(const TransportCatalogue& transport_catalogue, const std::vector<StopId>& stops,
+                                    size_t first, size_t last, NameId bus_name_id, bool skip_full_trip) {
+    // ребро из каждой остановки рейса [first, last] до каждой следующей с накопленным временем в пути
+    for (size_t from = first; from < last; ++from) {
+        const VertexId stop_from_vertex = 2 * static_cast<VertexId>(stops[from]) + 1;
+        double weight = 0.0;
+        size_t span_count = 0;
+        for (size_t to = from + 1; to <= last; ++to) {
+            weight += transport_catalogue.GetDistance(stops[to - 1], stops[to]) / routing_settings_.bus_velocity;
+            ++span_count;
+            if (skip_full_trip && from == first && to == last) continue;
+            graph_->AddEdge({stop_from_vertex, 2 * static_cast<VertexId>(stops[to]), weight, bus_name_id, span_count});
+        }
+    }
+}
+
+void TransportRouter::FillEdges(const TransportCatalogue& transport_catalogue) {
+    for (BusId bus = 0; bus < transport_catalogue.GetCountBuses(); ++bus) {
+        const NameId bus_name_id = graph_->AddName(transport_catalogue.GetBusName(bus));
+        const auto bus_stops = transport_catalogue.GetBusStops(bus);
+        const std::vector<StopId> stops(bus_stops.begin(), bus_stops.end());
+        if (stops.empty()) {
+            continue;
+        }
+        if (transport_catalogue.IsRoundtrip(bus)) {
+            // кольцевой маршрут: поездка от первой остановки до неё же по кругу не нужна
+            FillTripEdges(transport_catalogue, stops, 0, stops.size() - 1, bus_name_id, true);
+        } else {
+            const size_t mid = stops.size() / 2;
+            FillTripEdges(transport_catalogue, stops, 0, mid, bus_name_id, false); // туда
+            FillTripEdges(transport_catalogue, stops, mid, stops.size() - 1, bus_name_id, false); // обратно
         }
     }
 }
 
 void TransportRouter::FillGraph(const TransportCatalogue& transport_catalogue) {
     FillVertex(transport_catalogue);
-    FillEdges(transport_catalogue);
+    if (routing_settings_.graph_model == GraphModel::STOP_PAIRS) {
+        FillEdges(transport_catalogue);
+    } else {
+        FillRouteStopEdges(transport_catalogue);
+    }
+    graph_->Freeze();
 }
 
 }  //  namespace router
\ No newline at end of file
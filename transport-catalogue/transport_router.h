@@ -1,13 +1,17 @@
 #pragma once
 
+#include <memory>
 #include <string_view>
 #include <vector>
 #include <optional>
 
 #include "json.h"
 #include "router.h"
+#include "dijkstra_router.h"
+#include "contraction_hierarchy.h"
+#include "landmarks.h"
 #include "transport_catalogue.h"
-#include "json_builder.h"
+#include "json_writer.h"
 
 namespace router {
 
@@ -15,13 +19,43 @@ using namespace json;
 using namespace graph;
 using namespace transport;
 
+// Разрядность весов в таблице RouterType::ALL_PAIRS (опция CMake TRANSPORT_CATALOGUE_FLOAT_ROUTE_TABLE)
+#ifdef TRANSPORT_ROUTER_FLOAT_ROUTE_TABLE
+using RouteTableWeight = float;
+#else
+using RouteTableWeight = double;
+#endif
+using TableRouter = Router<double, RouteTableWeight>;
+
 static const double SCALE_VELOCITY_FACTOR = 1000.0 / 60.0; // (N) km/h = (N * SVF) m/min
+static const size_t DEFAULT_ROUTER_CACHE_SIZE = 128;
+static const size_t DEFAULT_LANDMARK_COUNT = 16;
+
+// Алгоритм, которым строятся маршруты (поле "router" в routing_settings)
+enum class RouterType {
+    ALL_PAIRS, // предпосчёт кратчайших путей между всеми парами вершин при создании базы
+    DIJKSTRA,  // поиск по запросу без предпосчёта
+    CONTRACTION_HIERARCHY, // иерархия сжатия, построенная при создании базы
+    ALT, // двунаправленный A* с оценками по ориентирам, выбранным при создании базы
+    RAPTOR, // поиск по раундам прямо по маршрутам справочника; граф не строится
+};
+
+RouterType ParseRouterType(std::string_view name);
+
+// Модель графа маршрутов (поле "graph_model" в routing_settings)
+enum class GraphModel {
+    // вершины "прибытие" и "отправление" для каждой остановки, ребро ожидания между ними
+    // и ребро от каждой остановки автобуса до каждой следующей: O(k^2) рёбер на маршрут из k остановок
+    STOP_PAIRS,
+    // вершина на остановку и вершина на каждую остановку каждого рейса автобуса: ребро посадки
+    // с временем ожидания, рёбра поездки между соседними остановками и ребро высадки: O(k) рёбер
+    ROUTE_STOPS,
+};
+
+GraphModel ParseGraphModel(std::string_view name);
 
 struct RoutingSettings {
-    RoutingSettings(const Dict& routing_settings)
-    : bus_wait_time(routing_settings.at("bus_wait_time").AsInt())
-    , bus_velocity(routing_settings.at("bus_velocity").AsDouble()) {
-    }
+    RoutingSettings(const Dict& routing_settings);
 
     RoutingSettings(int time, double velocity)
     : bus_wait_time(time)
@@ -30,39 +64,75 @@ struct RoutingSettings {
 
     int bus_wait_time;
     double bus_velocity;
+
+    RouterType router_type = RouterType::ALL_PAIRS;
+    size_t router_cache_size = DEFAULT_ROUTER_CACHE_SIZE; // число деревьев кратчайших путей в кэше DIJKSTRA
+    GraphModel graph_model = GraphModel::STOP_PAIRS;
+    size_t landmark_count = DEFAULT_LANDMARK_COUNT; // число ориентиров ALT
 };
 
 class TransportRouter {
 private:
     using Graph = DirectedWeightedGraph<double>;
 public:
+    // Пустой маршрутизатор без графа: база была прочитана без маршрутных данных
+    TransportRouter();
     TransportRouter(const Dict& routing_settings, const TransportCatalogue& transport_catalogue);
 
     TransportRouter(RoutingSettings routing_settings,
                     DirectedWeightedGraph<double> graph,
-                    std::vector<std::string> stop_names,
-                    Router<double>::RoutesInternalData internal_data);
+                    size_t stop_count,
+                    std::optional<TableRouter::Table> routes_table,
+                    std::optional<ContractionHierarchy<double>> hierarchy,
+                    std::optional<Landmarks<double>> landmarks);
+    // Маршрутизатор справочника, полученного из base_catalogue наложением изменения (TransportCatalogue::ApplyDelta),
+    // по маршрутизатору base прежнего справочника с теми же настройками. Граф строится заново, таблица
+    // RouterType::ALL_PAIRS пересчитывается только в строках, маршруты которых могли измениться, у ориентиров ALT
+    // расстояния доводятся так же (Landmarks). Ограничения: восстановленная таблица - своя V * V в памяти, а не
+    // отображение файла базы, иерархия сокращений строится заново целиком; при каждой загрузке с изменением работа
+    // повторяется - сохраняет восстановленные структуры только compact, записывая базу заново
+    TransportRouter(const TransportRouter& base, const TransportCatalogue& base_catalogue,
+                    const TransportCatalogue& transport_catalogue);
 
     const Graph& GetGraph() const;
-    VertexId GetVertexIdInput(std::string_view stop_name) const;
+    VertexId GetVertexIdInput(StopId stop) const;
 
-    std::optional<json::Node> GetRouteAsNode(const Router<double>& router, std::string_view from, std::string_view to) const;
+    // Создаёт движок маршрутизации, выбранный в routing_settings; для RouterType::RAPTOR графа нет - nullptr
+    std::unique_ptr<RouteBuilder<double>> MakeRouter() const;
+    // Маршрут между остановками; nullopt - маршрута нет
+    std::optional<RouteBuilder<double>::RouteInfo> BuildRoute(const RouteBuilder<double>& router, StopId from, StopId to) const;
+    // Дописывает элементы маршрута (Wait и Bus) в открытый массив items и возвращает их суммарное время
+    double WriteRouteItems(const RouteBuilder<double>::RouteInfo& route, json::Writer& items) const;
 
     const RoutingSettings& GetRoutingSettings() const;
-    const std::vector<std::string>& GetStopNames() const;
+    size_t GetStopCount() const;
 
-
-    const Router<double>& GetRouter() const;
+    // Предпосчитанная таблица маршрутов; есть только у RouterType::ALL_PAIRS
+    const std::optional<TableRouter>& GetRouter() const;
+    // Иерархия сжатия; есть только у RouterType::CONTRACTION_HIERARCHY
+    const std::optional<ContractionHierarchy<double>>& GetHierarchy() const;
+    // Ориентиры; есть только у RouterType::ALT
+    const std::optional<Landmarks<double>>& GetLandmarks() const;
 
 private:
     RoutingSettings routing_settings_;
-    Graph graph_;
-    Router<double> router_;
-    std::vector<std::string> stop_names_;
-
+    // граф в куче: таблица router_ ссылается на него и должна оставаться верной после перемещения TransportRouter
+    std::unique_ptr<Graph> graph_;
+    std::optional<TableRouter> router_;
+    std::optional<ContractionHierarchy<double>> hierarchy_;
+    std::optional<Landmarks<double>> landmarks_;
+    size_t stop_count_ = 0;
+
+    size_t CountVertices(const TransportCatalogue& transport_catalogue) const;
     void FillGraph(const TransportCatalogue& transport_catalogue);
     void FillVertex(const TransportCatalogue& transport_catalogue);
     void FillEdges(const TransportCatalogue& transport_catalogue);
+    void FillTripEdges(const TransportCatalogue& transport_catalogue, const std::vector<StopId>& stops,
+                       size_t first, size_t last, NameId bus_name_id, bool skip_full_trip);
+    void FillRouteStopEdges(const TransportCatalogue& transport_catalogue);
+    // Номера вершин графа base_catalogue в графе transport_catalogue, table_repair::REMOVED_VERTEX - вершины нет.
+    // Вершины остановок сопоставляются по названию, вершины рейсов ROUTE_STOPS - у автобусов с прежними остановками
+    std::vector<VertexId> MapVertices(const TransportCatalogue& base_catalogue, const TransportCatalogue& transport_catalogue) const;
 };
 
 }  //  namespace router
\ No newline at end of file